@@ -76,6 +76,18 @@ const bool useNVS = true; // true za produkcijo
 #define PIN_I2C_SDA 48
 #define PIN_I2C_SCL 47
 
+// Merjenje napajanja (ADC)
+#define PIN_SUPPLY_5V 2
+#define PIN_SUPPLY_3V3 3
+#define SUPPLY_5V_DIVIDER 2.13f          // razmerje delilnika 5 V
+#define SUPPLY_3V3_DIVIDER 2.18f         // razmerje delilnika 3,3 V
+#define SUPPLY_SAMPLE_PERIOD_MS 2        // perioda vzorčenja napajanja
+#define SUPPLY_OVERSAMPLE 4              // število ADC branj na vzorec
+#define SUPPLY_SAG_5V_THRESHOLD 4.5f     // prag padca 5 V (V)
+#define SUPPLY_SAG_HYSTERESIS 0.1f       // histereza konca padca (V)
+#define SUPPLY_SAG_CORRELATION_MS 1000   // največji zamik preklop releja -> padec za korelacijo
+#define SUPPLY_SAG_LOG_SIZE 8            // število hranjenih padcev
+
 // SD card pins
 #define SD_CS_PIN 4
 #define SD_MOSI_PIN 6
@@ -87,10 +99,57 @@ const bool useNVS = true; // true za produkcijo
 #define I2C_TIMEOUT_MS 100
 #define I2C_CLOCK_SPEED 10000  // 10 kHz za robustno komunikacijo
 #define SENSOR_READ_TIMEOUT_MS 200
+#define CONTROL_TICK_MS 200  // Perioda branja vhodov in krmiljenja ventilatorjev
+// Vbrizgavanje I2C napak (NACK, timeout, zataknjen SDA, neveljavni podatki) za testiranje
+// obnovitvenih poti - odkomentiraj ali -DI2C_FAULT_INJECTION, urnik prek /api/i2c-fault;
+// izgubljeni krmilni cikli po scenariju v /api/i2c-stats (lost_control_ticks_by_fault)
+// #define I2C_FAULT_INJECTION
 
 #define LOG_REPEAT_INTERVAL 60000 // Omejitev ponovitev log sporočil (60 sekund)
+#define LOG_REPEAT_SLOTS 32       // klicna mesta, sledena za ponovitve
+#define LOG_TAG_BYTES_PER_MIN 4096 // omejitev log bajtov na tag na minuto (ERROR izvzet)
 #define SENSOR_TEST_INTERVAL 3600 // Interval za preverjanje senzorjev (sekunde)
 #define STATUS_UPDATE_INTERVAL 300000UL // Interval za STATUS_UPDATE (5 minut v ms)
+#define STATUS_KEYFRAME_EVERY 20  // delta STATUS_UPDATE: polno stanje vsakih N sporočil
+#define HTTP_KEEPALIVE_IDLE_MS 20000 // keep-alive povezava do REW/DEW se zapre po tem času neaktivnosti
+#define HTTP_CONNECT_TIMEOUT_MS 3000
+#define HTTP_ATTEMPT_TIMEOUT_MS 10000 // en poskus (povezava + odgovor)
+#define HTTP_RETRY_BACKOFF_MS 2000    // neblokirajoč premor pred ponovitvijo (x2 na poskus, jitter)
+#define HTTP_RETRY_BACKOFF_MAX_MS 8000
+#define HTTP_UPDATE_DEADLINE_MS 25000 // STATUS/DEW_UPDATE skupaj s ponovitvami
+#define HTTP_PING_TIMEOUT_MS 1000
+#define LIVENESS_INTERVAL_MS 30000    // ping dosegljive enote brez drugega prometa (liveness.h)
+#define LIVENESS_BACKOFF_MIN_MS 5000  // ping nedosegljive enote (x2, jitter)
+#define LIVENESS_BACKOFF_MAX_MS 300000UL
+#define LIVENESS_DOWN_AFTER 2         // zaporedni neuspehi do offline
+#define HTTP_RESPONSE_MAX 128         // shranjen začetek telesa odgovora
+#define MSG_BODY_MAX 768              // telo sporočila med enotami (JSON ali MessagePack)
+#define MSG_DOC_ARENA 2048            // fiksna arena JsonDocument za sporočilo (wirearena.h)
+#define STATUS_SNAPSHOT_MAX 512       // posnetek polnega stanja (MessagePack) za delto in dogodke
+#define OUTBOX_EVENTS_MAX 8           // dogodki, ki čakajo dostavo - skupaj za vse enote (outbox.h)
+#define OUTBOX_BACKOFF_MIN_MS 5000    // ponovni poskus nedosegljive enote (x2, jitter)
+#define OUTBOX_BACKOFF_MAX_MS 300000UL
+#define OUTBOX_DRAIN_INTERVAL_MS 250  // tempo praznjenja zaostanka po ponovni vzpostavitvi
+#define MCAST_GROUP "239.255.53.1"    // multicast objava stanja (mcast.h)
+#define MCAST_PORT 45353
+#define MCAST_HEARTBEAT_MS 10000
+#define DASH_HEARTBEAT_MS 10000     // /events heartbeat z uro in preostalimi časi (dashpush.h)
+#define DASH_EVENT_MAX 1536         // eno SSE sporočilo (full z vsemi polji)
+#define WS_MAX_CLIENTS 4            // /ws kanal REW (wsctl.h); starejši odjemalci se zaprejo
+#define WS_KEEPALIVE_S 15           // ping po tišini - zaznava prekinjene povezave
+// Meritev msg/s (nova povezava proti keep-alive) prek /api/http-bench - vklop z -DHTTP_BENCH
+// MQTT telemetrija in ukazi (mqtt.h) - okolje esp32-s3-eth-mqtt (-DMQTT_TELEMETRY)
+#define MQTT_HOST "192.168.2.10"
+#define MQTT_PORT 1883
+#define MQTT_USER ""                 // prazno = brez prijave
+#define MQTT_PASSWORD ""
+#define MQTT_CLIENT_ID "vent_cee"
+#define MQTT_TOPIC_PREFIX "vent/cee"
+#define MQTT_QOS 1                   // objave stanja in naročnina na ukaze (0 ali 1)
+#define MQTT_KEEPALIVE_S 30
+#define MQTT_TICK_MS 1000            // preverjanje sprememb in objava spremenjenih skupin
+#define MQTT_RECONNECT_MIN_MS 5000   // ponovna povezava z brokerjem (x2, jitter)
+#define MQTT_RECONNECT_MAX_MS 300000UL
 
 #define ERR_BME280 0x01
 #define ERR_SHT41 0x02
@@ -124,9 +183,41 @@ const bool NND_DAYS[7] = {true, true, true, true, true, false, false};
 
 #define SERIAL_BAUD 115200
 #define SENSOR_READ_INTERVAL 60
+#define SENSOR_READ_INTERVAL_FAST 10   // Hitro vzorčenje prostora v aktivnem sušenju ali ob dvigu vlage (sekunde)
+#define SENSOR_HUM_RISE_FAST 2.0       // Dvig vlage (%) v SENSOR_READ_INTERVAL, ki vklopi hitro vzorčenje
+#define SENSOR_BUS_BUDGET_MS 3000      // Največ časa branja senzorjev na I2C v 60 s oknu (ms)
 #define DATA_SAVE_INTERVAL 360
-#define LOG_THRESHOLD_IDLE 7168  // 7kB - flush logs when idle
-#define LOG_BUFFER_MAX 30720      // 30kB - force flush regardless of idle status
+#define LOG_RING_SIZE 65536          // 64kB - binarni log ring v PSRAM
+#define LOG_RING_SIZE_NO_PSRAM 16384 // 16kB - ring v notranjem RAM-u, če PSRAM ni na voljo
+#define LOG_THRESHOLD_IDLE 7168  // 7kB - flush logs when idle (neposlano za REW)
+#define LOG_BUFFER_MAX 30720      // 30kB - force flush regardless of idle status, max velikost paketa
+#define LOG_WEB_MAX_LINES 300       // privzeto število vrstic na /logs strani
+#define LOG_WEB_LIMIT_MAX 2000      // največji limit= za /logs
+#define LOG_WEB_SCAN_BLOCK 32       // zapisov na korak iskanja začetka filtrirane strani (nazaj od konca)
+#define LOG_SD_DIR "/logs"
+#define LOG_SD_FILE_SIZE (8UL * 1024 * 1024)  // prealocirana velikost dnevne log datoteke
+#define LOG_SD_FOOTER_SIZE 2048         // footer (povzetek + indeks) na koncu datoteke
+#define LOG_SD_INDEX_STRIDE 65536       // vnos v indeks vsakih 64 kB podatkov
+#define LOG_SD_MAX_FILES 60             // največ log datotek na kartici (najstarejše se brišejo)
+#define LOG_SD_STAGING_SIZE 4096        // RAM staging za pisanje celih sektorjev
+#define LOG_SD_POLL_MS 1000             // perioda SD log taska
+#define LOG_SD_PAD_MS 60000             // nepopoln sektor dopolni in zapiši po tem času
+#define LOG_SD_QUERY_BUF 2048           // branje pri /api/logs/query (4 sektorji na SPI prenos)
+#define LOG_SD_QUERY_WINDOW 3600        // privzeto časovno okno poizvedbe (s)
+#define LOG_SD_QUERY_LIMIT 10000        // največ vrstic na poizvedbo
+#define LOG_SD_QUERY_OUT 4096           // vmesnik prebranih vrstic med logquery taskom in web odzivom
+#define LOG_SD_QUERY_TARGET_MS 100      // cilj za poizvedbo okna LOG_SD_QUERY_WINDOW (brez čakanja na bralca)
+#define LOG_SHIP_BATCH_RECORDS 256      // zapisov na en POST na REW
+#define LOG_SHIP_CONNECT_TIMEOUT_MS 3000
+#define LOG_SHIP_IO_TIMEOUT_S 10        // timeout pisanja/branja socketa
+#define LOG_SHIP_RESPONSE_TIMEOUT_MS 10000
+#ifndef LOG_DEFERRED_FORMAT
+#define LOG_DEFERRED_FORMAT 1       // LOG_* zapiše format + argumente, oblikuje šele porabnik (0 = takoj)
+#endif
+#define LOG_SERIAL_LAG_MS 100       // zapis, izpisan kasneje po prebujenju serial taska, šteje kot zaostal
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0             // nižji nivoji se ne prevedejo (0=DEBUG, 1=INFO, 2=WARN, 3=ERROR)
+#endif
 
 // Privzete vrednosti za struct so odstranjene - glej initDefaults() v globals.cpp
 // To poenostavi vzdrževanje tovarniških nastavitev (samo eno mesto za spremembe)
@@ -232,12 +323,17 @@ struct CurrentData {
     unsigned long lastStatusUpdateTime;
     float supply5V;
     float supply3V3;
+    float supply5VMin;          // min 5 V v zadnjem oknu branja
+    float supply5VMax;          // max 5 V v zadnjem oknu branja
+    uint32_t supplySagCount;    // padci 5 V od zagona
     bool utilityDryingMode;
     bool bathroomDryingMode;
     int utilityCycleMode;
     int bathroomCycleMode;
     time_t utilityExpectedEndTime;
     time_t bathroomExpectedEndTime;
+    uint16_t utilitySampleInterval;   // efektivni interval vzorčenja SHT41 (s)
+    uint16_t bathroomSampleInterval;  // efektivni interval vzorčenja BME280 (s)
 };
 
 #endif
@@ -29,6 +29,7 @@
 #define FIELD_ERROR_BME280        "ebm"   // error_bme280
 #define FIELD_ERROR_SHT41         "esht"  // error_sht41
 #define FIELD_ERROR_POWER         "epwr"  // error_power
+#define FIELD_POWER_SAGS          "psag"  // power_sag_count (padci 5 V od zagona)
 #define FIELD_ERROR_DEW           "edew"  // error_dew
 #define FIELD_ERROR_TIME_SYNC     "etms"  // error_time_sync
 
@@ -42,6 +43,11 @@
 #define FIELD_ENERGY_CONSUMPTION  "eng"   // energy_consumption
 #define FIELD_DUTY_CYCLE_LIVING   "dlds"  // duty_cycle_living_room
 
+// STATUS_UPDATE delta protokol (samo če REW odgovori z X-Vent-Caps: delta)
+#define FIELD_SEQUENCE            "sq"    // zaporedna številka sporočila
+#define FIELD_BASE_SEQUENCE       "bs"    // sq potrjenega stanja, na katerega se nanaša delta
+#define FIELD_KEYFRAME            "kf"    // 1 = vsa polja (keyframe)
+
 // DEW_UPDATE field names (CEE → DEW) - skupno sporočilo za obe enoti (UT in KOP)
 // Polja za ventilatorje in čase so ista kot v STATUS_UPDATE:
 //   FIELD_FAN_UTILITY, FIELD_FAN_BATHROOM, FIELD_TIME_UTILITY, FIELD_TIME_BATHROOM
@@ -67,6 +73,17 @@
 #define FIELD_ROOM                "room"  // room
 #define FIELD_ACTION              "action"// action
 
+// Kanal /ws (REW ↔ CEE, wsctl.h): vsak okvir je objekt s tipom in id, ostala
+// polja so ista kot v telesu HTTP sporočila istega tipa
+#define FIELD_MSG_TYPE            "mt"    // tip okvirja (WS_MSG_*)
+#define FIELD_MSG_ID              "id"    // id zahteve, potrditev ga vrne
+#define FIELD_ACK_STATUS          "status"// "OK" / "ERROR" - kot HTTP odgovor
+#define FIELD_ACK_MESSAGE         "message"
+#define WS_MSG_MANUAL_CONTROL     "mc"    // REW → CEE
+#define WS_MSG_SENSOR_DATA        "sd"    // REW → CEE
+#define WS_MSG_ACK                "ack"   // potrditev v obe smeri
+#define WS_MSG_STATE              "st"    // CEE → REW: polja STATUS_UPDATE + FIELD_SEQUENCE
+
 // LOGS field names (CEE → REW)
 #define FIELD_LOGS                "logs"  // logs content
 
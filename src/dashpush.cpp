@@ -0,0 +1,193 @@
+// dashpush.cpp - Server-Sent Events push of dashboard data
+
+#include "dashpush.h"
+#include <math.h>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "web.h"
+
+#define DASH_VALUE_MAX 16           // besedilo ene vrednosti ("-1234.5", "false", Unix čas)
+
+enum DashKind : uint8_t { DASH_BOOL, DASH_U8, DASH_U16, DASH_U32, DASH_INT, DASH_TIME, DASH_F0, DASH_F1 };
+
+struct DashField {
+    const char* key;
+    DashKind kind;
+    const void* value;
+};
+
+// Polja, ki gredo v delto ob spremembi (ključi kot v /current-data)
+static const DashField fields[] = {
+    {"bathroom_temp",              DASH_F1,   &currentData.bathroomTemp},
+    {"bathroom_humidity",          DASH_F1,   &currentData.bathroomHumidity},
+    {"bathroom_pressure",          DASH_F0,   &currentData.bathroomPressure},
+    {"bathroom_button",            DASH_BOOL, &currentData.bathroomButton},
+    {"bathroom_light1",            DASH_BOOL, &currentData.bathroomLight1},
+    {"bathroom_light2",            DASH_BOOL, &currentData.bathroomLight2},
+    {"bathroom_fan",               DASH_BOOL, &currentData.bathroomFan},
+    {"bathroom_disabled",          DASH_BOOL, &currentData.disableBathroom},
+    {"bathroom_drying_mode",       DASH_BOOL, &currentData.bathroomDryingMode},
+    {"bathroom_cycle_mode",        DASH_INT,  &currentData.bathroomCycleMode},
+    {"bathroom_expected_end_time", DASH_TIME, &currentData.bathroomExpectedEndTime},
+    {"utility_temp",               DASH_F1,   &currentData.utilityTemp},
+    {"utility_humidity",           DASH_F1,   &currentData.utilityHumidity},
+    {"utility_light",              DASH_BOOL, &currentData.utilityLight},
+    {"utility_switch",             DASH_BOOL, &currentData.utilitySwitch},
+    {"utility_fan",                DASH_BOOL, &currentData.utilityFan},
+    {"utility_disabled",           DASH_BOOL, &currentData.disableUtility},
+    {"utility_drying_mode",        DASH_BOOL, &currentData.utilityDryingMode},
+    {"utility_cycle_mode",         DASH_INT,  &currentData.utilityCycleMode},
+    {"utility_expected_end_time",  DASH_TIME, &currentData.utilityExpectedEndTime},
+    {"wc_light",                   DASH_BOOL, &currentData.wcLight},
+    {"wc_fan",                     DASH_BOOL, &currentData.wcFan},
+    {"wc_disabled",                DASH_BOOL, &currentData.disableWc},
+    {"living_temp",                DASH_F1,   &currentData.livingTemp},
+    {"living_humidity",            DASH_F1,   &currentData.livingHumidity},
+    {"living_co2",                 DASH_U16,  &currentData.livingCO2},
+    {"living_window1",             DASH_BOOL, &currentData.windowSensor1},
+    {"living_window2",             DASH_BOOL, &currentData.windowSensor2},
+    {"living_fan_level",           DASH_U8,   &currentData.livingExhaustLevel},
+    {"living_duty_cycle",          DASH_F1,   &currentData.livingRoomDutyCycle},
+    {"living_disabled",            DASH_BOOL, &currentData.disableLivingRoom},
+    {"external_temp",              DASH_F1,   &currentData.externalTemp},
+    {"external_humidity",          DASH_F1,   &currentData.externalHumidity},
+    {"external_pressure",          DASH_F1,   &currentData.externalPressure},
+    {"external_timestamp",         DASH_U32,  &externalData.timestamp},
+    {"external_data_valid",        DASH_BOOL, &externalDataValid},
+    {"time_synced",                DASH_BOOL, &timeSynced},
+    {"rew_online",                 DASH_BOOL, &rewStatus.isOnline},
+    {"ut_dew_online",              DASH_BOOL, &utDewStatus.isOnline},
+    {"kop_dew_online",             DASH_BOOL, &kopDewStatus.isOnline},
+    {"error_flags",                DASH_U8,   &currentData.errorFlags},
+};
+#define DASH_FIELD_COUNT (sizeof(fields) / sizeof(fields[0]))
+
+static AsyncEventSource events("/events");
+static char lastValue[DASH_FIELD_COUNT][DASH_VALUE_MAX];    // zadnje poslano besedilo
+static char eventBuf[DASH_EVENT_MAX];
+static volatile uint32_t connects = 0;      // piše async_tcp task (onConnect)
+static uint32_t connectsSeen = 0;
+static uint32_t eventId = 0;
+static unsigned long lastCheck = 0;
+static unsigned long lastTick = 0;
+static DashPushStats stats;
+
+static void formatValue(const DashField& f, char* out, size_t size) {
+    switch (f.kind) {
+        case DASH_BOOL: snprintf(out, size, "%s", *(const bool*)f.value ? "true" : "false"); break;
+        case DASH_U8:   snprintf(out, size, "%u", *(const uint8_t*)f.value); break;
+        case DASH_U16:  snprintf(out, size, "%u", *(const uint16_t*)f.value); break;
+        case DASH_U32:  snprintf(out, size, "%lu", (unsigned long)*(const uint32_t*)f.value); break;
+        case DASH_INT:  snprintf(out, size, "%d", *(const int*)f.value); break;
+        case DASH_TIME: snprintf(out, size, "%ld", (long)*(const time_t*)f.value); break;
+        case DASH_F0:
+        case DASH_F1: {
+            float v = *(const float*)f.value;
+            // NaN (senzor še ni prebran) ni veljaven JSON
+            if (!isfinite(v)) snprintf(out, size, "null");
+            else if (f.kind == DASH_F0) snprintf(out, size, "%d", (int)v);
+            else snprintf(out, size, "%.1f", v);
+            break;
+        }
+    }
+}
+
+// Doda "key":value, v buffer; false, če ne gre več (ostalo gre v naslednjo delto)
+static bool appendField(size_t& len, const char* key, const char* value) {
+    int n = snprintf(eventBuf + len, sizeof(eventBuf) - len, "\"%s\":%s,", key, value);
+    if (n < 0 || len + n >= sizeof(eventBuf) - 1) {     // prostor za zaključni '}'
+        eventBuf[len] = '\0';
+        return false;
+    }
+    len += n;
+    return true;
+}
+
+static void sendEvent(const char* type, size_t len) {
+    eventBuf[len - 1] = '}';                            // nadomesti zadnjo vejico
+    if (events.send(eventBuf, type, ++eventId) == AsyncEventSource::DISCARDED) stats.discarded++;
+    stats.events++;
+}
+
+static void sendFields(bool full) {
+    size_t len = 0;
+    eventBuf[len++] = '{';
+    for (size_t i = 0; i < DASH_FIELD_COUNT; i++) {
+        char value[DASH_VALUE_MAX];
+        formatValue(fields[i], value, sizeof(value));
+        if (!full && strcmp(value, lastValue[i]) == 0) continue;
+        if (!appendField(len, fields[i].key, value)) {
+            LOG_WARN("Web", "/events: DASH_EVENT_MAX premajhen (%u B)", (unsigned)sizeof(eventBuf));
+            break;
+        }
+        strcpy(lastValue[i], value);
+    }
+    if (len > 1) sendEvent(full ? "full" : "delta", len);
+}
+
+static void sendTick() {
+    char value[40];
+    size_t len = 0;
+    eventBuf[len++] = '{';
+    snprintf(value, sizeof(value), "\"%s\"", myTZ.dateTime().c_str());
+    appendField(len, "current_time", value);
+    snprintf(value, sizeof(value), "\"%s\"", formatUptime(millis() / 1000).c_str());
+    appendField(len, "uptime", value);
+    snprintf(value, sizeof(value), "%lu", (unsigned long)myTZ.now());
+    appendField(len, "server_timestamp", value);
+
+    static const char* const remainingKeys[] = {"bathroom_remaining", "utility_remaining", "wc_remaining",
+                                                nullptr, "living_remaining"};
+    for (int i = 0; i < 5; i++) {
+        if (!remainingKeys[i]) continue;
+        snprintf(value, sizeof(value), "%d", getRemainingTime(i));
+        appendField(len, remainingKeys[i], value);
+    }
+
+    float ramPercent = (ESP.getHeapSize() - ESP.getFreeHeap()) * 100.0 / ESP.getHeapSize();
+    snprintf(value, sizeof(value), "%.1f", ramPercent);
+    appendField(len, "ram_percent", value);
+    snprintf(value, sizeof(value), "%u", (unsigned)getLogPendingBytes(LOG_CONSUMER_REW));
+    appendField(len, "log_buffer_size", value);
+    snprintf(value, sizeof(value), "%.3f", currentData.supply3V3);
+    appendField(len, "supply_3v3", value);
+    snprintf(value, sizeof(value), "%.3f", currentData.supply5V);
+    appendField(len, "supply_5v", value);
+    snprintf(value, sizeof(value), "%.1f", currentData.currentPower);
+    appendField(len, "current_power", value);
+    snprintf(value, sizeof(value), "%.1f", currentData.energyConsumption);
+    appendField(len, "energy_consumption", value);
+
+    sendEvent("tick", len);
+    lastTick = millis();
+}
+
+void initDashboardEvents(AsyncWebServer& server) {
+    events.onConnect([](AsyncEventSourceClient* client) {
+        connects = connects + 1;        // full stanje pošlje glavna zanka
+        LOG_DEBUG("Web", "/events: nov odjemalec %s", client->client()->remoteIP().toString().c_str());
+    });
+    server.addHandler(&events);
+}
+
+void dashboardService() {
+    unsigned long now = millis();
+    if (now - lastCheck < CONTROL_TICK_MS) return;
+    lastCheck = now;
+
+    stats.clients = events.count();
+    if (stats.clients == 0) return;
+
+    // Nov odjemalec: full gre vsem (en zapis), obstoječim ne škodi
+    uint32_t seen = connects;
+    bool full = seen != connectsSeen;
+    connectsSeen = seen;
+
+    sendFields(full);
+    if (full || now - lastTick >= DASH_HEARTBEAT_MS) sendTick();
+}
+
+void getDashPushStats(DashPushStats& out) {
+    out = stats;
+}
@@ -0,0 +1,35 @@
+// dashpush.h - Server-Sent Events push of dashboard data
+//
+// /events (AsyncEventSource) pošilja nadzorni plošči (root stran) spremembe
+// currentData namesto 10 s pollinga /current-data. Ključi in oblika vrednosti
+// so isti kot v /current-data, zato stran sporočila samo združi v zadnje stanje.
+//
+//   full  - vsa polja; ob povezavi novega odjemalca
+//   delta - le polja, ki so se spremenila od prejšnjega sporočila
+//   tick  - heartbeat vsakih DASH_HEARTBEAT_MS: ura, uptime, preostali časi,
+//           napajanje in RAM - vrednosti, ki se spreminjajo stalno in bi sicer
+//           sprožile delto ob vsakem koraku krmiljenja
+//
+// Sporočilo se zgradi enkrat v statičen buffer, knjižnica ga deli med vse
+// odjemalce. Brez odjemalcev dashboardService() ne formatira ničesar.
+
+#ifndef DASHPUSH_H
+#define DASHPUSH_H
+
+#include <ESPAsyncWebServer.h>
+
+struct DashPushStats {
+    uint32_t clients;
+    uint32_t events;          // poslana sporočila (vsa vrste)
+    uint32_t discarded;       // noben odjemalec ga ni sprejel (polna vrsta)
+};
+
+// Registrira /events na strežniku (iz setupWebServer)
+void initDashboardEvents(AsyncWebServer& server);
+
+// Iz glavne zanke: preveri spremembe na CONTROL_TICK_MS in pošlje delto/heartbeat
+void dashboardService();
+
+void getDashPushStats(DashPushStats& stats);
+
+#endif // DASHPUSH_H
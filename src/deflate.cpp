@@ -0,0 +1,205 @@
+// deflate.cpp - Minimal streaming gzip compressor for CEE
+
+#include "deflate.h"
+
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_HASH_EMPTY 0xFFFF
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// CRC32 (gzip) s 4-bitno tabelo
+static const uint32_t crcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static bool flushOut(DeflateState& s) {
+    if (s.outLen == 0 || s.failed) return !s.failed;
+    if (!s.sink(s.out, s.outLen, s.ctx)) s.failed = true;
+    s.bytesOut += s.outLen;
+    s.outLen = 0;
+    return !s.failed;
+}
+
+static inline void putByte(DeflateState& s, uint8_t b) {
+    s.out[s.outLen++] = b;
+    if (s.outLen == DEFLATE_OUT_SIZE) flushOut(s);
+}
+
+// Biti v deflate gredo od LSB naprej
+static inline void putBits(DeflateState& s, uint32_t value, uint8_t count) {
+    s.bitBuf |= value << s.bitCount;
+    s.bitCount += count;
+    while (s.bitCount >= 8) {
+        putByte(s, s.bitBuf & 0xFF);
+        s.bitBuf >>= 8;
+        s.bitCount -= 8;
+    }
+}
+
+// Huffmanove kode se pišejo od MSB naprej
+static inline void putCode(DeflateState& s, uint32_t code, uint8_t length) {
+    uint32_t rev = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        rev = (rev << 1) | (code & 1);
+        code >>= 1;
+    }
+    putBits(s, rev, length);
+}
+
+static void putSymbol(DeflateState& s, uint16_t sym) {
+    if (sym <= 143) putCode(s, 0x30 + sym, 8);
+    else if (sym <= 255) putCode(s, 0x190 + (sym - 144), 9);
+    else if (sym <= 279) putCode(s, sym - 256, 7);
+    else putCode(s, 0xC0 + (sym - 280), 8);
+}
+
+static void putMatch(DeflateState& s, uint16_t length, uint16_t dist) {
+    int l = 28;
+    while (lengthBase[l] > length) l--;
+    putSymbol(s, 257 + l);
+    if (lengthExtra[l]) putBits(s, length - lengthBase[l], lengthExtra[l]);
+
+    int d = 29;
+    while (distBase[d] > dist) d--;
+    putCode(s, d, 5);
+    if (distExtra[d]) putBits(s, dist - distBase[d], distExtra[d]);
+}
+
+static inline uint16_t hash3(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+// Kodira buf[pos..bufLen); brez flush pusti DEFLATE_MAX_MATCH bajtov za naslednje ujemanje
+static void compressBlock(DeflateState& s, bool flush) {
+    while (s.pos < s.bufLen && (flush || s.bufLen - s.pos >= DEFLATE_MAX_MATCH)) {
+        size_t avail = s.bufLen - s.pos;
+        uint16_t bestLen = 0;
+        uint16_t bestDist = 0;
+
+        if (avail >= DEFLATE_MIN_MATCH) {
+            uint16_t h = hash3(s.buf + s.pos);
+            uint16_t cand = s.head[h];
+            s.head[h] = s.pos;
+            if (cand != DEFLATE_HASH_EMPTY && cand < s.pos && s.pos - cand <= DEFLATE_WINDOW) {
+                size_t maxLen = avail < DEFLATE_MAX_MATCH ? avail : DEFLATE_MAX_MATCH;
+                const uint8_t* a = s.buf + cand;
+                const uint8_t* b = s.buf + s.pos;
+                size_t len = 0;
+                while (len < maxLen && a[len] == b[len]) len++;
+                if (len >= DEFLATE_MIN_MATCH) {
+                    bestLen = len;
+                    bestDist = s.pos - cand;
+                }
+            }
+        }
+
+        if (bestLen) {
+            putMatch(s, bestLen, bestDist);
+            // Vstavi še pozicije znotraj ujemanja, da so na voljo naslednjim iskanjem
+            size_t end = s.pos + bestLen;
+            for (size_t p = s.pos + 1; p < end && p + DEFLATE_MIN_MATCH <= s.bufLen; p++) {
+                s.head[hash3(s.buf + p)] = p;
+            }
+            s.pos = end;
+        } else {
+            putSymbol(s, s.buf[s.pos]);
+            s.pos++;
+        }
+    }
+}
+
+// Ohrani zadnjih DEFLATE_WINDOW bajtov zgodovine, ostalo zavrže
+static void slideWindow(DeflateState& s) {
+    if (s.pos <= DEFLATE_WINDOW) return;
+    size_t shift = s.pos - DEFLATE_WINDOW;
+    memmove(s.buf, s.buf + shift, s.bufLen - shift);
+    s.bufLen -= shift;
+    s.pos -= shift;
+    for (size_t i = 0; i < (1u << DEFLATE_HASH_BITS); i++) {
+        uint16_t h = s.head[i];
+        s.head[i] = (h == DEFLATE_HASH_EMPTY || h < shift) ? DEFLATE_HASH_EMPTY : h - shift;
+    }
+}
+
+bool deflateBegin(DeflateState& s, DeflateSink sink, void* ctx) {
+    s.bufLen = s.pos = s.outLen = 0;
+    s.bitBuf = 0;
+    s.bitCount = 0;
+    s.crc = 0;
+    s.bytesIn = s.bytesOut = 0;
+    s.failed = false;
+    s.sink = sink;
+    s.ctx = ctx;
+    memset(s.head, 0xFF, sizeof(s.head));
+
+    // gzip glava: ID1 ID2 CM=8 FLG=0 MTIME=0 XFL=0 OS=255
+    static const uint8_t gzipHeader[10] = {0x1F, 0x8B, 0x08, 0x00, 0, 0, 0, 0, 0x00, 0xFF};
+    for (uint8_t b : gzipHeader) putByte(s, b);
+
+    // Nezaključen blok s fiksnimi kodami (BFINAL=0, BTYPE=01)
+    putBits(s, 0, 1);
+    putBits(s, 1, 2);
+    return !s.failed;
+}
+
+bool deflateWrite(DeflateState& s, const uint8_t* data, size_t length) {
+    s.crc = crc32Update(s.crc, data, length);
+    s.bytesIn += length;
+    while (length > 0 && !s.failed) {
+        size_t n = DEFLATE_BUF - s.bufLen;
+        if (n > length) n = length;
+        memcpy(s.buf + s.bufLen, data, n);
+        s.bufLen += n;
+        data += n;
+        length -= n;
+        if (s.bufLen == DEFLATE_BUF) {
+            compressBlock(s, false);
+            slideWindow(s);
+        }
+    }
+    return !s.failed;
+}
+
+bool deflateFinish(DeflateState& s) {
+    compressBlock(s, true);
+    putSymbol(s, 256);                 // konec bloka
+
+    // Prazen zaključni blok (BFINAL=1, BTYPE=01)
+    putBits(s, 1, 1);
+    putBits(s, 1, 2);
+    putSymbol(s, 256);
+    if (s.bitCount > 0) putBits(s, 0, 8 - s.bitCount);
+
+    // gzip zaključek: CRC32, ISIZE (little endian)
+    for (int i = 0; i < 4; i++) putByte(s, (s.crc >> (8 * i)) & 0xFF);
+    for (int i = 0; i < 4; i++) putByte(s, (s.bytesIn >> (8 * i)) & 0xFF);
+    return flushOut(s);
+}
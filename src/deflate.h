@@ -0,0 +1,41 @@
+// deflate.h - Minimal streaming gzip compressor for CEE
+//
+// LZ77 z majhnim oknom (DEFLATE_WINDOW) in fiksnimi Huffmanovimi kodami
+// (RFC 1951, BTYPE=01), zavito v gzip (RFC 1952). Brez dinamičnih alokacij;
+// celotno stanje je v DeflateState (~7 kB), izhod gre sproti v sink.
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <Arduino.h>
+
+#define DEFLATE_WINDOW 2048          // zgodovina za iskanje ujemanj
+#define DEFLATE_BUF (2 * DEFLATE_WINDOW)
+#define DEFLATE_HASH_BITS 10
+#define DEFLATE_OUT_SIZE 512
+
+// Sink prejme stisnjene bajte; false prekine stiskanje
+typedef bool (*DeflateSink)(const uint8_t* data, size_t length, void* ctx);
+
+struct DeflateState {
+    uint8_t buf[DEFLATE_BUF];
+    uint16_t head[1 << DEFLATE_HASH_BITS];
+    uint8_t out[DEFLATE_OUT_SIZE];
+    size_t bufLen;
+    size_t pos;
+    size_t outLen;
+    uint32_t bitBuf;
+    uint8_t bitCount;
+    uint32_t crc;
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+    bool failed;
+    DeflateSink sink;
+    void* ctx;
+};
+
+bool deflateBegin(DeflateState& s, DeflateSink sink, void* ctx);
+bool deflateWrite(DeflateState& s, const uint8_t* data, size_t length);
+bool deflateFinish(DeflateState& s);
+
+#endif // DEFLATE_H
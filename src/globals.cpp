@@ -35,7 +35,6 @@ bool sht41Present = false;
 unsigned long lastSensorRead = 0;
 
 // Logging globals
-String logBuffer = "";
 bool loggingInitialized = false;
 unsigned long lastLogFlush = 0;
 
@@ -74,6 +73,9 @@ void initCurrentData() {
   // Inicializacija currentData na privzete vrednosti
   currentData.supply5V = 0.0f;
   currentData.supply3V3 = 0.0f;
+  currentData.supply5VMin = 0.0f;
+  currentData.supply5VMax = 0.0f;
+  currentData.supplySagCount = 0;
   currentData.livingCO2 = 0;
   currentData.livingTemp = 0.0f;
   currentData.livingHumidity = 0.0f;
@@ -122,6 +124,8 @@ void initCurrentData() {
   currentData.bathroomDryingMode = false;
   currentData.utilityCycleMode = 0;
   currentData.bathroomCycleMode = 0;
+  currentData.utilitySampleInterval = SENSOR_READ_INTERVAL;
+  currentData.bathroomSampleInterval = SENSOR_READ_INTERVAL;
   
   for (int i = 0; i < 6; i++) {
     currentData.offTimes[i] = 0;
@@ -31,7 +31,6 @@ extern bool sht41Present;
 extern unsigned long lastSensorRead;
 
 // Logging globals
-extern String logBuffer;
 extern bool loggingInitialized;
 extern unsigned long lastLogFlush;
 
@@ -1,113 +1,147 @@
 // http.cpp - HTTP client functions for sending messages
 
 #include "http.h"
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "globals.h"
 #include "logging.h"
 #include "config.h"
 #include "vent.h"
 #include "message_fields.h"
+#include "wire.h"
+#include "wirearena.h"
+#include "statemsg.h"
+#include "mcast.h"
+#include "outbox.h"
+#include "liveness.h"
+#include "wsctl.h"
+
+// Odgovor 4xx: sporočilo zavrnjeno, enota pa je dosegljiva
+static bool peerReachable(int code) {
+    if (code >= 400 && code < 500) {
+        LOG_WARN("HTTP", "Request rejected code=%d - message invalid but device online", code);
+    }
+    return code > 0 && code < 500;
+}
+
+// Dostava iz outboxa je uspela - enota je spet online brez čakanja na ping
+static void markPeerOnline(HttpPeerId peer) {
+    if (livenessReport(peer, true)) {
+        LOG_INFO("HTTP", "%s reaktiviran ob uspešni dostavi iz outboxa", httpPeerName(peer));
+    }
+}
+
+// Zmožnosti po enoti iz X-Vent-Caps: MessagePack in poslušanje multicast objave
+static WireFormat peerFormat[HTTP_PEER_COUNT] = {};
+static bool peerMcast[HTTP_PEER_COUNT] = {};
+static uint8_t messageBuf[MSG_BODY_MAX];    // kodirano sporočilo (samo glavna zanka)
 
-// Forward declarations
-int sendHttpPostRaw(const char* url, const String& data, int timeoutMs, String* responseBody = nullptr);
-bool sendHttpPostWithRetryRaw(const char* deviceName, const char* url, const String& data, int maxRetries = 3, bool logResult = true);
-
-// URLs za enote - gradijo se iz IP defin v config.h
-#define REW_URL     "http://" IP_REW
-#define DEW_UT_URL  "http://" IP_UT_DEW
-#define DEW_KOP_URL "http://" IP_KOP_DEW
-
-// Helper: Compute fan states — shared between sendStatusUpdate and checkAndSendStatusUpdate
-// Eliminates code duplication and keeps both functions in sync
-struct FanStates {
-    uint8_t fwc, fut, fkop, fdse;
-};
-
-FanStates computeFanStates() {
-    FanStates s;
-    s.fwc = currentData.disableWc ? 9 : (currentData.wcFan ? 1 : 0);
-    if (currentData.disableUtility) {
-        s.fut = 9;
-    } else if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
-        s.fut = 5 + currentData.utilityCycleMode;  // 6=mode1, 7=mode2, 8=mode3
-    } else {
-        s.fut = currentData.utilityFan ? 1 : 0;
+// Dokumenti sporočil s fiksnimi arenami - brez heapa ob vsaki spremembi stanja.
+// Samo glavna zanka; stateDoc gradi polno stanje (STATUS, DEW, multicast, dogodek)
+// in ga vsak uporabnik pred tem počisti z beginStateDoc().
+static WireDocument<MSG_DOC_ARENA> stateDoc;
+
+static JsonDocument& beginStateDoc() {
+    stateDoc.clear();
+    return stateDoc;
+}
+
+static void updatePeerCaps(HttpPeerId peer, const char* headers) {
+    char value[32];
+    if (!httpHeaderValue(headers, "X-Vent-Caps", value, sizeof(value))) value[0] = '\0';
+    WireFormat format = strstr(value, "msgpack") ? WIRE_MSGPACK : WIRE_JSON;
+    if (format != peerFormat[peer]) {
+        LOG_INFO("HTTP", "%s: format sporočil %s", httpPeerName(peer), wireContentType(format));
+        peerFormat[peer] = format;
     }
-    if (currentData.disableBathroom) {
-        s.fkop = 9;
-    } else if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
-        s.fkop = 5 + currentData.bathroomCycleMode;  // 6=mode1, 7=mode2, 8=mode3
-    } else {
-        s.fkop = currentData.bathroomFan ? 1 : 0;
+    bool mcast = strstr(value, "mcast") != nullptr;
+    if (mcast != peerMcast[peer]) {
+        LOG_INFO("HTTP", "%s: multicast objava %s", httpPeerName(peer), mcast ? "posluša" : "ne posluša");
+        peerMcast[peer] = mcast;
     }
-    s.fdse = currentData.disableLivingRoom ? 9 : currentData.livingExhaustLevel;
-    return s;
 }
 
-// Send STATUS_UPDATE to REW
-bool sendStatusUpdate() {
-    String url = String(REW_URL) + "/api/status-update";
+// 4xx na MessagePack telo: enota ga ne razume več (npr. vrnjena starejša verzija),
+// X-Vent-Caps pa se bere samo ob 2xx - nazaj na JSON in stanje znova v outbox.
+// Ob naslednjem 2xx z "msgpack" v glavi updatePeerCaps spet izbere MessagePack.
+static void rejectedMsgPack(const HttpResult& result) {
+    if (result.code < 400 || result.code >= 500) return;
+    if (wireFormatOf(result.contentType) != WIRE_MSGPACK || peerFormat[result.peer] != WIRE_MSGPACK) return;
+    LOG_WARN("HTTP", "%s: MessagePack zavrnjen (HTTP %d) - nazaj na %s",
+             httpPeerName(result.peer), result.code, wireContentType(WIRE_JSON));
+    peerFormat[result.peer] = WIRE_JSON;
+    outboxPostState(result.peer);
+}
+
+// Enota prejme spremembe po multicastu ali /ws - HTTP samo še ob periodičnem pošiljanju
+static bool coveredByPush(HttpPeerId peer) {
+    if (peer == HTTP_PEER_REW && controlSocketActive()) return true;
+    return peerMcast[peer] && stateMulticastActive();
+}
 
-    DynamicJsonDocument doc(512);
+// Delta STATUS_UPDATE (statemsg.h) REW vklopi z "delta" v odgovoru na našo glavo
+#define STATUS_CAPS_HEADER "X-Vent-Caps: delta,msgpack,mcast\r\n"
+#define DEW_CAPS_HEADER "X-Vent-Caps: msgpack,mcast\r\n"
 
-    // Fans — via shared helper (0=off, 1=on, 6-8=drying mode, 9=disabled)
-    FanStates fs = computeFanStates();
-    doc[FIELD_FAN_WC]         = fs.fwc;
-    doc[FIELD_FAN_UTILITY]    = fs.fut;
-    doc[FIELD_FAN_BATHROOM]   = fs.fkop;
-    doc[FIELD_FAN_LIVING_EXH] = fs.fdse;
-
-    // Inputs (digital states)
-    doc[FIELD_INPUT_BATHROOM_L1] = currentData.bathroomLight1 ? 1 : 0;
-    doc[FIELD_INPUT_BATHROOM_L2] = currentData.bathroomLight2 ? 1 : 0;
-    doc[FIELD_INPUT_UTILITY_L]   = currentData.utilityLight ? 1 : 0;
-    doc[FIELD_INPUT_WC_L]        = currentData.wcLight ? 1 : 0;
-    doc[FIELD_INPUT_WINDOW_ROOF] = currentData.windowSensor1 ? 1 : 0;
-    doc[FIELD_INPUT_WINDOW_BALC] = currentData.windowSensor2 ? 1 : 0;
-
-    // Off-times (Unix timestamps)
-    doc[FIELD_TIME_WC] = currentData.offTimes[2];
-    if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
-        doc[FIELD_TIME_UTILITY] = currentData.utilityExpectedEndTime;
-    } else {
-        doc[FIELD_TIME_UTILITY] = currentData.offTimes[1];
+// 2xx potrdi sporočilo - zmožnosti in zahteva za keyframe iz glav odgovora
+static void ackStatusResponse(uint32_t seq, const char* headers) {
+    char value[24];
+    bool caps = httpHeaderValue(headers, "X-Vent-Caps", value, sizeof(value)) && strstr(value, "delta");
+    bool keyframe = httpHeaderValue(headers, "X-Vent-Keyframe", value, sizeof(value)) && value[0] == '1';
+    ackStatusMessage(seq, caps, keyframe);
+}
+
+// Zaključek STATUS_UPDATE (iz httpPoolService) - ob uspehu ne logiramo
+static void onStatusUpdateDone(const HttpResult& result, void* arg) {
+    uint32_t seq = (uint32_t)(uintptr_t)arg;
+    outboxDone(result.peer, result.code);
+    if (result.code == HTTP_POOL_SUPERSEDED) {
+        // Nikoli poslan; keyframe, ki ga REW pričakuje, gre z naslednjim
+        dropStatusMessage(seq);
+        return;
     }
-    if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
-        doc[FIELD_TIME_BATHROOM] = currentData.bathroomExpectedEndTime;
-    } else {
-        doc[FIELD_TIME_BATHROOM] = currentData.offTimes[0];
+    if (result.code >= 200 && result.code < 300) {
+        markPeerOnline(result.peer);
+        updatePeerCaps(result.peer, result.headers);
+        ackStatusResponse(seq, result.headers);
+        return;
     }
-    doc[FIELD_TIME_LIVING_EXH] = currentData.offTimes[4];
-
-    // Error flags (0=ok, 1=error)
-    doc[FIELD_ERROR_BME280] = currentData.errorFlags & ERR_BME280 ? 1 : 0;
-    doc[FIELD_ERROR_SHT41]  = currentData.errorFlags & ERR_SHT41 ? 1 : 0;
-    doc[FIELD_ERROR_POWER]  = currentData.errorFlags & ERR_POWER ? 1 : 0;
-    doc[FIELD_ERROR_DEW]    = currentData.dewError;
-    // Time sync error detection
-    uint8_t timeSyncError = 0;
-    if (!timeSynced) {
-        timeSyncError = 1;  // NTP not synchronized
-    } else if (externalDataValid) {
-        uint32_t currentTime = myTZ.now();
-        uint32_t timeDiff = abs((int32_t)(currentTime - externalData.timestamp));
-        if (timeDiff > 300) timeSyncError = 2;  // Time discrepancy >5min
+    // Zavrnjena delta ali izpad REW (morda ponovni zagon) - osveži s polnim stanjem
+    rejectedMsgPack(result);
+    requestStatusKeyframe();
+    if (peerReachable(result.code)) {
+        markPeerOnline(result.peer);
+        return;
     }
-    doc[FIELD_ERROR_TIME_SYNC] = timeSyncError;
+    LOG_WARN("HTTP", "STATUS_UPDATE→REW ni dostavljen (HTTP %d, %u poskusov, %lu ms)",
+             result.code, result.attempts, (unsigned long)result.elapsedMs);
+    livenessReport(result.peer, false);
+}
 
-    // Sensor data
-    doc[FIELD_TEMP_BATHROOM]      = currentData.bathroomTemp;
-    doc[FIELD_HUM_BATHROOM]       = currentData.bathroomHumidity;
-    doc[FIELD_PRESS_BATHROOM]     = currentData.bathroomPressure;
-    doc[FIELD_TEMP_UTILITY]       = currentData.utilityTemp;
-    doc[FIELD_HUM_UTILITY]        = currentData.utilityHumidity;
-    doc[FIELD_CURRENT_POWER]      = currentData.currentPower;
-    doc[FIELD_ENERGY_CONSUMPTION] = currentData.energyConsumption;
-    doc[FIELD_DUTY_CYCLE_LIVING]  = (int)currentData.livingRoomDutyCycle;
+// Zaključek DEW_UPDATE - vedno logiraj rezultat z HTTP kodo in JSON payloadom
+static void onDewUpdateDone(const HttpResult& result, void* arg) {
+    const char* room = (const char*)arg;
+    outboxDone(result.peer, result.code);
+    if (result.code == HTTP_POOL_SUPERSEDED) return;
+    char payload[LOG_LINE_MAX];
+    wireToText(wireFormatOf(result.contentType), result.request, result.requestLength, payload, sizeof(payload));
+    if (peerReachable(result.code)) {
+        markPeerOnline(result.peer);
+        if (result.code < 300) updatePeerCaps(result.peer, result.headers);
+        else rejectedMsgPack(result);
+        LOG_INFO("HTTP", "DEW_UPDATE→%s: HTTP %d | %s", room, result.code, payload);
+        return;
+    }
+    LOG_ERROR("HTTP", "DEW_UPDATE→%s: HTTP %d FAILED | %s", room, result.code, payload);
+    LOG_WARN("HTTP", "%s: DEW_UPDATE ni dostavljen (%u poskusov, %lu ms)",
+             httpPeerName(result.peer), result.attempts, (unsigned long)result.elapsedMs);
+    livenessReport(result.peer, false);
+}
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+// Send STATUS_UPDATE to REW - vrne true, ko je zahtevek v vrsti; rezultat v onStatusUpdateDone
+bool sendStatusUpdate() {
+    JsonDocument& doc = beginStateDoc();
+    FanStates fs = computeFanStates();
+    fillStatusFields(doc, fs);
 
     // Delta logging - logiraj samo ob spremembah
     static uint8_t prev_fwc  = 0xFF;  // 0xFF = neinicializirano
@@ -159,89 +193,97 @@ bool sendStatusUpdate() {
         prev_err  = err_combined;
     }
 
-    bool success = sendHttpPostWithRetry("REW", url.c_str(), jsonString, 2, false, nullptr);
-    // Ob uspehu ne logiramo, ob napaki že logira sendHttpPostWithRetry
-    return success;
-}
-
-// Send DEW_UPDATE to specified DEW unit - unified payload for both UT and KOP
-bool sendDewUpdate(const char* room) {
-    String url;
-    if (strcmp(room, "UT") == 0) {
-        url = String(DEW_UT_URL) + "/api/dew-update";
-    } else if (strcmp(room, "KOP") == 0) {
-        url = String(DEW_KOP_URL) + "/api/dew-update";
-    } else {
-        LOG_ERROR("HTTP", "Invalid room for DEW_UPDATE: %s", room);
+    uint32_t seq;
+    size_t length = encodeStatusMessage(doc, peerFormat[HTTP_PEER_REW], seq, messageBuf, sizeof(messageBuf));
+    if (length == 0) {
+        LOG_ERROR("HTTP", "STATUS_UPDATE ne gre v %d B", MSG_BODY_MAX);
         return false;
     }
+    return httpPoolSend(HTTP_PEER_REW, "/api/status-update", wireContentType(peerFormat[HTTP_PEER_REW]),
+                        messageBuf, length, HTTP_UPDATE_DEADLINE_MS, 2,
+                        onStatusUpdateDone, (void*)(uintptr_t)seq, STATUS_CAPS_HEADER);
+}
 
-    // Create unified JSON payload - same structure sent to both UT and KOP
-    // Each DEW unit reads the fields relevant to its role
-    DynamicJsonDocument doc(384);
-
-    // Utility fan state (0=off, 1=on, 6-8=drying mode, 9=disabled)
-    if (currentData.disableUtility) {
-        doc[FIELD_FAN_UTILITY] = 9;
-    } else if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
-        doc[FIELD_FAN_UTILITY] = 5 + currentData.utilityCycleMode;  // 6, 7, or 8
-    } else {
-        doc[FIELD_FAN_UTILITY] = currentData.utilityFan ? 1 : 0;
-    }
-
-    // Bathroom fan state (0=off, 1=on, 6-8=drying mode, 9=disabled)
-    if (currentData.disableBathroom) {
-        doc[FIELD_FAN_BATHROOM] = 9;
-    } else if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
-        doc[FIELD_FAN_BATHROOM] = 5 + currentData.bathroomCycleMode;  // 6, 7, or 8
-    } else {
-        doc[FIELD_FAN_BATHROOM] = currentData.bathroomFan ? 1 : 0;
-    }
-
-    // Utility time: expectedEndTime if drying (6-8), else offTimes[1]
-    if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
-        doc[FIELD_TIME_UTILITY] = currentData.utilityExpectedEndTime;
-    } else {
-        doc[FIELD_TIME_UTILITY] = currentData.offTimes[1];
-    }
-
-    // Bathroom time: expectedEndTime if drying (6-8), else offTimes[0]
-    if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
-        doc[FIELD_TIME_BATHROOM] = currentData.bathroomExpectedEndTime;
-    } else {
-        doc[FIELD_TIME_BATHROOM] = currentData.offTimes[0];
+// Send DEW_UPDATE to DEW units - sporočilo se zgradi in zakodira enkrat na format;
+// vrne masko enot (bit na HttpPeerId), za katere je zahtevek v vrsti
+uint8_t sendDewUpdates(bool ut, bool kop) {
+    if (!ut && !kop) return 0;
+    JsonDocument& doc = beginStateDoc();
+    fillDewFields(doc);
+
+    static const struct { HttpPeerId peer; const char* room; } units[2] = {
+        {HTTP_PEER_UT_DEW, "UT"}, {HTTP_PEER_KOP_DEW, "KOP"}
+    };
+    size_t length = 0;
+    WireFormat encoded = WIRE_JSON;
+    uint8_t queued = 0;
+    for (int i = 0; i < 2; i++) {
+        if (!(i == 0 ? ut : kop)) continue;
+        HttpPeerId peer = units[i].peer;
+        if (length == 0 || encoded != peerFormat[peer]) {
+            encoded = peerFormat[peer];
+            length = encodeStateDoc(doc, encoded, messageBuf, sizeof(messageBuf));
+        }
+        if (length == 0) {
+            LOG_ERROR("HTTP", "DEW_UPDATE ne gre v %d B", MSG_BODY_MAX);
+            return queued;
+        }
+        if (httpPoolSend(peer, "/api/dew-update", wireContentType(encoded), messageBuf, length,
+                         HTTP_UPDATE_DEADLINE_MS, 3, onDewUpdateDone, (void*)units[i].room, DEW_CAPS_HEADER)) {
+            queued |= 1 << peer;
+        } else {
+            LOG_WARN("HTTP", "DEW_UPDATE→%s ni v vrsti - peer zaseden", units[i].room);
+        }
     }
+    return queued;
+}
 
-    // Sensor data - both rooms (each DEW unit uses its own fields)
-    doc[FIELD_TEMP_BATHROOM]  = currentData.bathroomTemp;      // tbat - KOP_DEW uses this
-    doc[FIELD_HUM_BATHROOM]   = currentData.bathroomHumidity;  // hbat - KOP_DEW uses this
-    doc[FIELD_PRESS_BATHROOM] = currentData.bathroomPressure;  // pbat - KOP_DEW uses this
-    doc[FIELD_TEMP_UTILITY]   = currentData.utilityTemp;       // tutl - UT_DEW uses this
-    doc[FIELD_HUM_UTILITY]    = currentData.utilityHumidity;   // hutl - UT_DEW uses this
-
-    // Weather icon and season (both DEW units use these)
-    doc[FIELD_WEATHER_ICON] = currentWeatherIcon;              // wi (string)
-    doc[FIELD_SEASON_CODE]  = currentSeasonCode;               // ss
+// Zapoznel dogodek (prehod napake) za REW - posnetek stanja z izvirnim časom
+static bool sendStatusEvent(HttpPeerId peer, const OutboxEvent& event) {
+    if (peer != HTTP_PEER_REW) return false;
+    JsonDocument& doc = beginStateDoc();
+    if (deserializeMsgPack(doc, event.state, event.length)) return false;
+    uint32_t seq;
+    size_t length = encodeStatusMessage(doc, peerFormat[HTTP_PEER_REW], seq, messageBuf, sizeof(messageBuf),
+                                        event.timestamp);
+    if (length == 0) return false;
+    LOG_INFO("HTTP", "STATUS_UPDATE: dogodek napake iz %lu (err=%d/%d/%d, dew=%d)", (unsigned long)event.timestamp,
+             (int)doc[FIELD_ERROR_BME280], (int)doc[FIELD_ERROR_SHT41], (int)doc[FIELD_ERROR_POWER],
+             (int)doc[FIELD_ERROR_DEW]);
+    return httpPoolSend(HTTP_PEER_REW, "/api/status-update", wireContentType(peerFormat[HTTP_PEER_REW]),
+                        messageBuf, length, HTTP_UPDATE_DEADLINE_MS, 2,
+                        onStatusUpdateDone, (void*)(uintptr_t)seq, STATUS_CAPS_HEADER);
+}
 
-    // Error flags (both DEW units may use these)
-    doc[FIELD_ERROR_BME280] = currentData.errorFlags & ERR_BME280 ? 1 : 0;  // ebm
-    doc[FIELD_ERROR_SHT41]  = currentData.errorFlags & ERR_SHT41 ? 1 : 0;   // esht
+// Stanje iz outboxa: STATUS_UPDATE za REW, DEW_UPDATE enkrat za obe DEW enoti
+static uint8_t sendOutboxState(uint8_t peers) {
+    uint8_t queued = 0;
+    if ((peers & (1 << HTTP_PEER_REW)) && sendStatusUpdate()) queued |= 1 << HTTP_PEER_REW;
+    return queued | sendDewUpdates(peers & (1 << HTTP_PEER_UT_DEW), peers & (1 << HTTP_PEER_KOP_DEW));
+}
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+void initStatusUpdates() {
+    initOutbox(sendOutboxState, sendStatusEvent);
+}
 
-    // Konsolidirano logiranje z HTTP kodo in JSON payloadom
-    int httpCode = 0;
-    bool success = sendHttpPostWithRetry(room, url.c_str(), jsonString, 3, false, &httpCode);
-    
-    // Vedno logiraj rezultat - uspeh ali napaka
-    if (success) {
-        LOG_INFO("HTTP", "DEW_UPDATE→%s: HTTP %d | %s", room, httpCode, jsonString.c_str());
-    } else {
-        LOG_ERROR("HTTP", "DEW_UPDATE→%s: HTTP %d FAILED | %s", room, httpCode, jsonString.c_str());
+// Multicast objava: STATUS_UPDATE polja + vreme/sezona (unija z DEW_UPDATE), vedno MessagePack.
+// Isto stanje gre REW po /ws, če je povezan (wsctl.h).
+static unsigned long lastStatePublish = 0;
+
+static void publishState(bool heartbeat) {
+    bool mcast = stateMulticastActive();
+    if (!mcast && !controlSocketActive()) return;
+    JsonDocument& doc = beginStateDoc();
+    fillPublishFields(doc);
+    if (mcast) {
+        size_t length = encodeStateDoc(doc, WIRE_MSGPACK, messageBuf, sizeof(messageBuf));
+        if (length > 0) publishStateMulticast(messageBuf, length, myTZ.now(), heartbeat);
     }
-    
-    return success;
+    // Doda tip okvirja - zadnji uporabnik doc. Sprememba, ki ni šla po /ws (poln
+    // izhodni red, prekinjena povezava), gre po HTTP prek outboxa - coveredByPush
+    // jo sicer preskoči do naslednjega periodičnega STATUS_UPDATE.
+    if (controlSocketActive() && !publishStateControlSocket(doc) && !heartbeat) outboxPostState(HTTP_PEER_REW);
+    lastStatePublish = millis();
 }
 
 // Check and send STATUS_UPDATE to REW when states change or periodically
@@ -276,7 +318,10 @@ void checkAndSendStatusUpdate() {
     bool timeToSend = (currentData.lastStatusUpdateTime == 0) ||
                       (now - currentData.lastStatusUpdateTime >= STATUS_UPDATE_INTERVAL);
 
-    if (!changed && !timeToSend) return;
+    if (!changed && !timeToSend) {
+        if (now - lastStatePublish >= MCAST_HEARTBEAT_MS) publishState(true);
+        return;
+    }
 
     // Calculate power and accumulate energy before sending
     calculatePower();
@@ -287,28 +332,26 @@ void checkAndSendStatusUpdate() {
     }
     lastEnergyUpdate = now;
 
-    // Send STATUS_UPDATE only if REW is online
-    bool success = false;
-    if (rewStatus.isOnline) {
-        success = sendStatusUpdate();
-        if (!success) {
-            rewStatus.isOnline = false;
-            LOG_WARN("HTTP", "REW marked offline due to STATUS_UPDATE failure");
-        }
-    }
+    // En datagram za vse enote, ki poslušajo multicast
+    publishState(false);
 
-    // Send DEW updates only if devices are online
-    if (utDewStatus.isOnline) {
-        if (!sendDewUpdate("UT")) {
-            utDewStatus.isOnline = false;
-            LOG_WARN("HTTP", "UT_DEW marked offline due to DEW_UPDATE failure");
-        }
+    // HTTP prek outboxa: spremembe med pošiljanjem se združijo v najnovejše stanje,
+    // nedosegljiva enota dobi zadnje stanje ob ponovnem poskusu (backoff). Enote na
+    // multicastu dobijo HTTP le periodično (potrditev, zmožnosti, zaznava izpada).
+    const HttpPeerId units[3] = {HTTP_PEER_REW, HTTP_PEER_UT_DEW, HTTP_PEER_KOP_DEW};
+    for (HttpPeerId peer : units) {
+        if (timeToSend || !coveredByPush(peer)) outboxPostState(peer);
     }
 
-    if (kopDewStatus.isOnline) {
-        if (!sendDewUpdate("KOP")) {
-            kopDewStatus.isOnline = false;
-            LOG_WARN("HTTP", "KOP_DEW marked offline due to DEW_UPDATE failure");
+    // Prehod napake je dogodek, ki ga novejše stanje ne sme prekriti (REW ga beleži)
+    bool errorTransition = lastErrFlags != 255 &&
+                           (currentErrFlags != lastErrFlags || currentDewErr != lastDewErr);
+    if (errorTransition) {
+        JsonDocument& doc = beginStateDoc();
+        fillStatusFields(doc, fs);
+        size_t length = encodeStateDoc(doc, WIRE_MSGPACK, messageBuf, sizeof(messageBuf));
+        if (length == 0 || !outboxPushEvent(HTTP_PEER_REW, myTZ.now(), messageBuf, length)) {
+            LOG_ERROR("HTTP", "STATUS_UPDATE: dogodka napake ni mogoče shraniti (%u B)", (unsigned)length);
         }
     }
 
@@ -328,166 +371,6 @@ void checkAndSendStatusUpdate() {
     currentData.lastStatusUpdateTime = now;
 }
 
-// Send logs to REW
-bool sendLogsToREW() {
-    if (logBuffer.length() == 0) return true;
-    String url = String(REW_URL) + "/api/logs";
-    float kb = logBuffer.length() / 1024.0;
-
-    // ✅ Zapakira loge v JSON format z "logs" poljem
-    // REW body handler dela samo za JSON, ne za text/plain
-    DynamicJsonDocument doc(logBuffer.length() + 200);
-    doc["logs"] = logBuffer;
-    
-    String jsonString;
-    serializeJson(doc, jsonString);
-    float jsonKb = jsonString.length() / 1024.0;
-
-    // Dynamic timeout: 10s base + 50ms per KB (max 60s)
-    int timeout = 10000 + (jsonString.length() / 1024) * 50;
-    timeout = min(timeout, 60000);  // Cap at 60s for safety
-
-    LOG_INFO("HTTP", "LOGS→REW: pošiljam %.1f kB (JSON %.1f kB, timeout=%d ms)...", kb, jsonKb, timeout);
-
-    // ✅ Pošlji kot application/json (ne več text/plain)
-    HTTPClient http;
-    http.begin(url.c_str());
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(timeout);
-    int httpCode = http.POST(jsonString);
-    String responseBody = http.getString();
-    http.end();
-
-    if (httpCode >= 200 && httpCode < 300) {
-        LOG_INFO("HTTP", "LOGS→REW: uspeh HTTP %d, %.1f kB poslano", httpCode, kb);
-        logBuffer.clear();
-        return true;
-    }
-
-    // Vse napake (4xx, 5xx, 0, negativno) — buffer ohrani, poskusi naslednjič
-    LOG_WARN("HTTP", "LOGS→REW: neuspeh HTTP %d (%.80s) — buffer %.1f kB ohranjen, ponovim naslednjič",
-             httpCode, responseBody.c_str(), kb);
-    return false;
-}
-
-// Helper function to send HTTP POST with raw text/plain content
-int sendHttpPostRaw(const char* url, const String& data, int timeoutMs, String* responseBody) {
-    HTTPClient http;
-    http.begin(url);
-    http.addHeader("Content-Type", "text/plain");
-    // Note: Content-Length is automatically added by HTTPClient.POST()
-    http.setTimeout(timeoutMs);
-    int httpResponseCode = http.POST(data);
-    if (responseBody != nullptr) {
-        *responseBody = http.getString();
-    }
-    http.end();
-    return httpResponseCode;
-}
-
-// Helper function to send HTTP POST
-int sendHttpPost(const char* url, const String& jsonData, int timeoutMs) {
-    HTTPClient http;
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(timeoutMs);
-
-    int httpResponseCode = http.POST(jsonData);
-
-    http.end();
-    return httpResponseCode;
-}
-
-// Helper function with retry logic for raw text/plain POST
-bool sendHttpPostWithRetryRaw(const char* deviceName, const char* url, const String& data, int maxRetries, bool logResult) {
-    const int HTTP_TIMEOUT_MS = 10000;
-    int lastHttpCode = 0;
-
-    for (int attempt = 1; attempt <= maxRetries; attempt++) {
-        int httpCode = sendHttpPostRaw(url, data, HTTP_TIMEOUT_MS);
-        lastHttpCode = httpCode;
-
-        if (httpCode >= 200 && httpCode < 300) {
-            if (logResult) LOG_INFO("HTTP", "POST to %s - Response: %d, Success", deviceName, httpCode);
-            return true;
-        }
-        if (httpCode >= 400 && httpCode < 500) {
-            if (logResult) LOG_INFO("HTTP", "POST to %s - Response: %d, Success", deviceName, httpCode);
-            return true;
-        }
-        if (httpCode <= 0 || httpCode >= 500) {
-            if (attempt < maxRetries) delay(2000);
-        }
-    }
-
-    if (logResult) LOG_ERROR("HTTP", "POST to %s - Failed after %d attempts", deviceName, maxRetries);
-    return false;
-}
-
-// Helper function with retry logic
-bool sendHttpPostWithRetry(const char* deviceName, const char* url, const String& jsonData, int maxRetries, bool logResult, int* outHttpCode) {
-    const int HTTP_TIMEOUT_MS = 10000; // 10 second timeout
-    int lastHttpCode = 0;
-
-    for (int attempt = 1; attempt <= maxRetries; attempt++) {
-        int httpCode = sendHttpPost(url, jsonData, HTTP_TIMEOUT_MS);
-        lastHttpCode = httpCode;
-
-        // Success (200-299)
-        if (httpCode >= 200 && httpCode < 300) {
-            if (logResult) {
-                LOG_INFO("HTTP", "POST to %s - Response: %d, Success", deviceName, httpCode);
-            }
-            if (outHttpCode) *outHttpCode = httpCode;
-            return true;
-        }
-
-        // HTTP client error (400-499) - message invalid but device online
-        if (httpCode >= 400 && httpCode < 500) {
-            LOG_WARN("HTTP", "Request rejected code=%d - message invalid but device online", httpCode);
-            if (logResult) {
-                LOG_INFO("HTTP", "POST to %s - Response: %d, Success", deviceName, httpCode);
-            }
-            if (outHttpCode) *outHttpCode = httpCode;
-            return true; // Don't mark offline, message was processed
-        }
-
-        // Connection error (0, negative) or server error (500+) - device offline
-        if (httpCode <= 0 || httpCode >= 500) {
-            if (attempt < maxRetries) {
-                delay(2000);
-            }
-        }
-    }
-
-    if (logResult) {
-        LOG_ERROR("HTTP", "POST to %s - Failed after %d attempts", deviceName, maxRetries);
-    }
-    if (outHttpCode) *outHttpCode = lastHttpCode;
-    return false;
-}
-
-// Check if a device is online by pinging its /api/ping endpoint
-bool checkDeviceOnline(const char* ip) {
-    String url = String("http://") + ip + "/api/ping";
-    HTTPClient http;
-    http.begin(url);
-    http.setTimeout(2000);
-
-    int httpResponseCode = http.GET();
-
-    if (httpResponseCode == 200) {
-        String response = http.getString();
-        if (response == "pong") {
-            http.end();
-            return true;
-        }
-    }
-
-    http.end();
-    return false;
-}
-
 // Check and reset energy consumption monthly
 void checkAndResetMonthlyEnergy() {
     if (!timeSynced) return;  // Samo če je NTP sinhroniziran
@@ -511,31 +394,3 @@ void checkAndResetMonthlyEnergy() {
                  previousConsumption, previousConsumption / 1000.0f, currentMonth, currentYear);
     }
 }
-
-// Check all devices that are currently offline
-void checkAllDevices() {
-    String statusMessage = "Offline test:";
-
-    // Check REW
-    bool rewOnline = checkDeviceOnline(IP_REW);
-    if (rewOnline != rewStatus.isOnline) {
-        rewStatus.isOnline = rewOnline;
-    }
-    statusMessage += String(" REW ") + (rewOnline ? "online" : "offline");
-
-    // Check UT_DEW
-    bool utOnline = checkDeviceOnline(IP_UT_DEW);
-    if (utOnline != utDewStatus.isOnline) {
-        utDewStatus.isOnline = utOnline;
-    }
-    statusMessage += String(", UT_DEW ") + (utOnline ? "online" : "offline");
-
-    // Check KOP_DEW
-    bool kopOnline = checkDeviceOnline(IP_KOP_DEW);
-    if (kopOnline != kopDewStatus.isOnline) {
-        kopDewStatus.isOnline = kopOnline;
-    }
-    statusMessage += String(", KOP_DEW ") + (kopOnline ? "online" : "offline");
-
-    LOG_INFO("HTTP", "%s", statusMessage.c_str());
-}
@@ -2,22 +2,18 @@
 #define HTTP_H
 
 #include <Arduino.h>
+#include "httppool.h"
 
-// HTTP client functions for sending messages
+// HTTP client functions for sending messages - neblokirajoče prek httppool,
+// vrnejo true (masko enot), ko je zahtevek v vrsti; rezultat obdela callback v http.cpp
 bool sendStatusUpdate();
-bool sendDewUpdate(const char* room);
-bool sendLogsToREW();
-void checkAndSendStatusUpdate();
+uint8_t sendDewUpdates(bool ut, bool kop);
 
-// Device status checking
-bool checkDeviceOnline(const char* ip);
-void checkAllDevices();
+// Spremembe stanja gredo prek outboxa (outbox.h) - poveže ga s pošiljanjem zgoraj
+void initStatusUpdates();
+void checkAndSendStatusUpdate();
 
 // Energy management
 void checkAndResetMonthlyEnergy();
 
-// Helper functions
-int sendHttpPost(const char* url, const String& jsonData, int timeoutMs = 5000);
-bool sendHttpPostWithRetry(const char* deviceName, const char* url, const String& jsonData, int maxRetries = 2, bool logResult = true, int* outHttpCode = nullptr);
-
 #endif // HTTP_H
\ No newline at end of file
@@ -0,0 +1,629 @@
+// httppool.cpp - Asynchronous keep-alive HTTP client for REW and DEW units
+
+#include "httppool.h"
+#include <AsyncTCP.h>
+#include <esp_system.h>
+#include "config.h"
+#include "logging.h"
+#include "metrics.h"
+
+#define HTTP_HEAD_MAX 384
+
+enum HttpSlotState : uint8_t {
+    HTTP_SLOT_IDLE = 0,
+    HTTP_SLOT_CONNECTING,
+    HTTP_SLOT_WAITING,     // zahtevek poslan, čaka odgovor
+    HTTP_SLOT_FINISHED,    // poskus končan, rezultat v code
+    HTTP_SLOT_BACKOFF
+};
+
+// Dekodiranje Transfer-Encoding: chunked
+enum HttpChunkState : uint8_t {
+    HTTP_CHUNK_SIZE = 0,    // heksadecimalna dolžina kosa
+    HTTP_CHUNK_EXT,         // razširitev kosa do konca vrstice
+    HTTP_CHUNK_DATA,
+    HTTP_CHUNK_DATA_END,    // "\r\n" za podatki kosa
+    HTTP_CHUNK_TRAILER,     // glave za zadnjim kosom do prazne vrstice
+    HTTP_CHUNK_DONE,
+    HTTP_CHUNK_ERROR
+};
+
+struct HttpRequest {
+    bool used;
+    char path[32];
+    const char* contentType;    // nullptr = GET
+    const char* headers;
+    uint8_t body[MSG_BODY_MAX];
+    uint16_t bodyLength;
+    uint32_t deadlineMs;
+    uint8_t maxAttempts;
+    HttpDoneCallback callback;
+    void* arg;
+};
+
+struct HttpPeer {
+    const char* name;
+    const char* host;
+    AsyncClient client;
+    volatile uint8_t state;
+    volatile bool open;         // TCP odprt in uporaben za naslednji zahtevek
+    HttpRequest req;            // v teku
+    HttpRequest next;           // čakajoč
+    uint8_t attempts;
+    bool reused;
+    unsigned long started;
+    unsigned long attemptStart;
+    unsigned long retryAt;
+    volatile unsigned long sentAt;      // oddaja zahtevka (loop ali onPeerConnect)
+    volatile unsigned long finishedAt;  // zaključek poskusa (čas callbacka, ne glavne zanke)
+
+    // Razčlenjevanje odgovora. V CONNECTING/WAITING ga piše samo async_tcp task,
+    // glavna zanka ga bere in ponastavi šele, ko je stanje HTTP_SLOT_FINISHED.
+    volatile bool inCallback;   // callback dela s poskusom - zanka ga ne sme zaključiti
+    char head[HTTP_HEAD_MAX];
+    uint16_t headLen;
+    uint8_t headMatch;          // dosežen del "\r\n\r\n"
+    bool headDone;
+    bool gotData;
+    bool closeAfter;
+    bool chunked;
+    uint8_t chunkState;
+    uint8_t chunkLineLen;       // dolžina trenutne vrstice v trailerju
+    uint32_t chunkLeft;
+    int status;
+    int32_t contentLength;
+    uint32_t bodyRead;
+    char response[HTTP_RESPONSE_MAX + 1];
+    uint16_t responseLen;
+    volatile int code;
+
+    HttpPeerStats stats;
+};
+
+#ifdef HTTP_BENCH
+static char benchHost[16] = "";
+#endif
+
+static HttpPeer peers[HTTP_PEER_COUNT] = {
+    {"REW", IP_REW},
+    {"UT_DEW", IP_UT_DEW},
+    {"KOP_DEW", IP_KOP_DEW},
+#ifdef HTTP_BENCH
+    {"BENCH", benchHost},
+#endif
+};
+
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+const char* httpPeerName(HttpPeerId peer) {
+    return peer < HTTP_PEER_COUNT ? peers[peer].name : "?";
+}
+
+const char* httpPeerHost(HttpPeerId peer) {
+    return peer < HTTP_PEER_COUNT ? peers[peer].host : "";
+}
+
+static bool attemptActive(const HttpPeer& p) {
+    return p.state == HTTP_SLOT_CONNECTING || p.state == HTTP_SLOT_WAITING;
+}
+
+// Zaključi poskus, če je še v teku. Po HTTP_SLOT_FINISHED so bufferji poskusa
+// (head, response, req) samo od glavne zanke - callbacki se jih ne dotikajo več.
+static void finishAttempt(HttpPeer& p, int code) {
+    portENTER_CRITICAL(&poolMux);
+    if (attemptActive(p)) {
+        p.code = code;
+        p.finishedAt = millis();
+        p.state = HTTP_SLOT_FINISHED;
+    }
+    portEXIT_CRITICAL(&poolMux);
+}
+
+// Vstop callbacka: false, če poskus ni več v teku (npr. zanka ga je zaključila po roku)
+static bool enterCallback(HttpPeer& p, uint8_t state) {
+    portENTER_CRITICAL(&poolMux);
+    bool active = p.state == state;
+    if (active) p.inCallback = true;
+    portEXIT_CRITICAL(&poolMux);
+    return active;
+}
+
+static void leaveCallback(HttpPeer& p) {
+    portENTER_CRITICAL(&poolMux);
+    p.inCallback = false;
+    portEXIT_CRITICAL(&poolMux);
+}
+
+// Zaključek iz glavne zanke (rok): ne med delom callbacka, sicer ob naslednjem klicu
+static bool finishAttemptFromLoop(HttpPeer& p, int code) {
+    portENTER_CRITICAL(&poolMux);
+    bool done = !p.inCallback && attemptActive(p);
+    if (done) {
+        p.code = code;
+        p.finishedAt = millis();
+        p.state = HTTP_SLOT_FINISHED;
+    }
+    portEXIT_CRITICAL(&poolMux);
+    return done;
+}
+
+// Glava in telo v enem TCP segmentu
+static bool sendRequest(HttpPeer& p) {
+    char head[256];
+    const char* extra = p.req.headers ? p.req.headers : "";
+    int n;
+    if (p.req.contentType) {
+        n = snprintf(head, sizeof(head),
+                     "POST %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n%s"
+                     "Content-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                     p.req.path, p.host, extra, p.req.contentType, p.req.bodyLength);
+    } else {
+        n = snprintf(head, sizeof(head), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n%s\r\n",
+                     p.req.path, p.host, extra);
+    }
+    size_t total = n + p.req.bodyLength;
+    if (n <= 0 || n >= (int)sizeof(head) || p.client.space() < total) return false;
+    if (p.client.add(head, n) != (size_t)n) return false;
+    if (p.req.bodyLength && p.client.add((const char*)p.req.body, p.req.bodyLength) != p.req.bodyLength) return false;
+    p.sentAt = millis();        // pred send() - odgovor ga ne more prehiteti
+    return p.client.send();
+}
+
+static void parseResponseHead(HttpPeer& p) {
+    p.head[p.headLen] = '\0';
+    p.status = -1;
+    if (strncmp(p.head, "HTTP/1.", 7) == 0 && p.headLen > 12) {
+        p.status = atoi(p.head + 9);
+        p.closeAfter = p.head[7] == '0';
+    }
+    for (char* line = strstr(p.head, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            p.contentLength = atol(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            char* value = line + 11;
+            while (*value == ' ') value++;
+            if (strncasecmp(value, "close", 5) == 0) p.closeAfter = true;
+            else if (strncasecmp(value, "keep-alive", 10) == 0) p.closeAfter = false;
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            p.chunked = strstr(line, "chunked") != nullptr;
+        }
+    }
+    // Glava daljša od bufferja ali brez dolžine - telo do konca povezave
+    if (p.headLen >= HTTP_HEAD_MAX - 1 || (p.contentLength < 0 && !p.chunked)) p.closeAfter = true;
+}
+
+static void appendBody(HttpPeer& p, const char* d, size_t n) {
+    size_t room = HTTP_RESPONSE_MAX - p.responseLen;
+    memcpy(p.response + p.responseLen, d, n < room ? n : room);
+    p.responseLen += n < room ? n : room;
+    p.bodyRead += n;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Telo s chunked kodiranjem: v response gredo samo podatki kosov
+static void decodeChunked(HttpPeer& p, const char* d, size_t len) {
+    size_t i = 0;
+    while (i < len && p.chunkState != HTTP_CHUNK_DONE && p.chunkState != HTTP_CHUNK_ERROR) {
+        char c = d[i];
+        switch (p.chunkState) {
+            case HTTP_CHUNK_SIZE:
+            case HTTP_CHUNK_EXT: {
+                i++;
+                if (c == '\n') {
+                    p.chunkLineLen = 0;
+                    p.chunkState = p.chunkLeft ? HTTP_CHUNK_DATA : HTTP_CHUNK_TRAILER;
+                } else if (p.chunkState == HTTP_CHUNK_EXT || c == '\r') {
+                    // preskoči razširitev
+                } else if (c == ';' || c == ' ' || c == '\t') {
+                    p.chunkState = HTTP_CHUNK_EXT;
+                } else {
+                    int v = hexDigit(c);
+                    if (v < 0 || p.chunkLeft > 0x0FFFFFFF) p.chunkState = HTTP_CHUNK_ERROR;
+                    else p.chunkLeft = p.chunkLeft * 16 + v;
+                }
+                break;
+            }
+            case HTTP_CHUNK_DATA: {
+                size_t n = len - i < p.chunkLeft ? len - i : p.chunkLeft;
+                appendBody(p, d + i, n);
+                i += n;
+                p.chunkLeft -= n;
+                if (p.chunkLeft == 0) p.chunkState = HTTP_CHUNK_DATA_END;
+                break;
+            }
+            case HTTP_CHUNK_DATA_END:
+                i++;
+                if (c == '\n') p.chunkState = HTTP_CHUNK_SIZE;
+                else if (c != '\r') p.chunkState = HTTP_CHUNK_ERROR;
+                break;
+            case HTTP_CHUNK_TRAILER:
+                i++;
+                if (c == '\n') {
+                    if (p.chunkLineLen == 0) p.chunkState = HTTP_CHUNK_DONE;
+                    p.chunkLineLen = 0;
+                } else if (c != '\r' && p.chunkLineLen < 255) {
+                    p.chunkLineLen++;
+                }
+                break;
+        }
+    }
+}
+
+static void onPeerData(void* arg, AsyncClient* client, void* data, size_t len) {
+    HttpPeer& p = *(HttpPeer*)arg;
+    if (!enterCallback(p, HTTP_SLOT_WAITING)) return;
+    const char* d = (const char*)data;
+    size_t i = 0;
+    p.gotData = true;
+
+    static const char headEnd[] = "\r\n\r\n";
+    while (!p.headDone && i < len) {
+        char c = d[i++];
+        if (p.headLen < HTTP_HEAD_MAX - 1) p.head[p.headLen++] = c;
+        p.headMatch = (c == headEnd[p.headMatch]) ? p.headMatch + 1 : (c == '\r' ? 1 : 0);
+        if (p.headMatch == 4) {
+            parseResponseHead(p);
+            p.headDone = true;
+        }
+    }
+
+    int code = 0;
+    if (p.headDone) {
+        if (p.chunked) {
+            decodeChunked(p, d + i, len - i);
+            if (p.chunkState == HTTP_CHUNK_DONE) code = p.status;
+            if (p.chunkState == HTTP_CHUNK_ERROR) {
+                p.closeAfter = true;
+                code = HTTP_POOL_ERROR_LOST;
+            }
+        } else {
+            appendBody(p, d + i, len - i);
+            if (p.contentLength >= 0 && p.bodyRead >= (uint32_t)p.contentLength) code = p.status;
+        }
+    }
+    leaveCallback(p);
+    if (code != 0) finishAttempt(p, code);
+}
+
+static void onPeerConnect(void* arg, AsyncClient* client) {
+    HttpPeer& p = *(HttpPeer*)arg;
+    portENTER_CRITICAL(&poolMux);
+    bool connecting = p.state == HTTP_SLOT_CONNECTING;
+    if (connecting) {
+        p.state = HTTP_SLOT_WAITING;
+        p.inCallback = true;    // p.req se bere med pošiljanjem
+    }
+    p.open = true;
+    portEXIT_CRITICAL(&poolMux);
+    client->setNoDelay(true);   // glava in telo gresta takoj, brez čakanja na ACK
+    if (!connecting) return;
+    bool sent = sendRequest(p);
+    leaveCallback(p);
+    if (!sent) finishAttempt(p, HTTP_POOL_ERROR_SEND);
+}
+
+static void onPeerDisconnect(void* arg, AsyncClient* client) {
+    HttpPeer& p = *(HttpPeer*)arg;
+    p.open = false;
+    // Odgovor brez Content-Length se konča z zaprtjem povezave
+    portENTER_CRITICAL(&poolMux);
+    if (attemptActive(p)) {
+        p.code = p.headDone && p.contentLength < 0 && !p.chunked ? p.status : HTTP_POOL_ERROR_LOST;
+        p.finishedAt = millis();
+        p.state = HTTP_SLOT_FINISHED;
+    }
+    portEXIT_CRITICAL(&poolMux);
+}
+
+static void onPeerError(void* arg, AsyncClient* client, int8_t error) {
+    HttpPeer& p = *(HttpPeer*)arg;
+    p.open = false;
+    finishAttempt(p, p.state == HTTP_SLOT_CONNECTING ? HTTP_POOL_ERROR_CONNECT : HTTP_POOL_ERROR_LOST);
+}
+
+void initHttpPool() {
+    for (int i = 0; i < HTTP_PEER_COUNT; i++) {
+        HttpPeer& p = peers[i];
+        p.client.onConnect(onPeerConnect, &p);
+        p.client.onData(onPeerData, &p);
+        p.client.onDisconnect(onPeerDisconnect, &p);
+        p.client.onError(onPeerError, &p);
+    }
+}
+
+static void closePeer(HttpPeer& p) {
+    p.open = false;
+    if (!p.client.disconnected()) p.client.close(true);
+}
+
+static void startAttempt(HttpPeer& p) {
+    unsigned long now = millis();
+    p.attempts++;
+    p.attemptStart = now;
+    p.headLen = 0;
+    p.headMatch = 0;
+    p.headDone = false;
+    p.gotData = false;
+    p.closeAfter = false;
+    p.chunked = false;
+    p.chunkState = HTTP_CHUNK_SIZE;
+    p.chunkLineLen = 0;
+    p.chunkLeft = 0;
+    p.status = 0;
+    p.contentLength = -1;
+    p.bodyRead = 0;
+    p.responseLen = 0;
+
+    if (p.open && p.client.connected() && now - p.stats.lastUsed <= HTTP_KEEPALIVE_IDLE_MS) {
+        p.reused = true;
+        p.stats.reuses++;
+        p.state = HTTP_SLOT_WAITING;
+        if (!sendRequest(p)) finishAttempt(p, HTTP_POOL_ERROR_SEND);
+        return;
+    }
+
+    closePeer(p);
+    p.reused = false;
+    p.stats.connects++;
+    IPAddress ip;
+    p.state = HTTP_SLOT_CONNECTING;
+    if (!ip.fromString(p.host) || !p.client.connect(ip, 80)) finishAttempt(p, HTTP_POOL_ERROR_CONNECT);
+}
+
+static void beginRequest(HttpPeer& p) {
+    p.attempts = 0;
+    p.started = millis();
+    p.stats.requests++;
+    startAttempt(p);
+}
+
+static void fillRequest(HttpRequest& r, const char* path, const char* contentType, const uint8_t* body,
+                        size_t length, uint32_t deadlineMs, uint8_t maxAttempts, HttpDoneCallback callback,
+                        void* arg, const char* headers) {
+    r.used = true;
+    strlcpy(r.path, path, sizeof(r.path));
+    r.contentType = contentType;
+    r.bodyLength = contentType && body ? length : 0;
+    if (r.bodyLength) memcpy(r.body, body, r.bodyLength);
+    r.headers = headers;
+    r.deadlineMs = deadlineMs;
+    r.maxAttempts = maxAttempts < 1 ? 1 : maxAttempts;
+    r.callback = callback;
+    r.arg = arg;
+}
+
+static void notifyResult(HttpPeerId peer, const HttpRequest& r, int code, uint8_t attempts,
+                         uint32_t elapsedMs, uint32_t rttMs, const char* response, const char* headers) {
+    if (!r.callback) return;
+    HttpResult result = {peer, code, attempts, elapsedMs, rttMs, r.body, r.bodyLength, r.contentType, response, headers};
+    r.callback(result, r.arg);
+}
+
+bool httpPoolSend(HttpPeerId peer, const char* path, const char* contentType, const uint8_t* body, size_t length,
+                  uint32_t deadlineMs, uint8_t maxAttempts, HttpDoneCallback callback, void* arg,
+                  const char* headers) {
+    if (peer >= HTTP_PEER_COUNT || length > MSG_BODY_MAX) return false;
+    HttpPeer& p = peers[peer];
+
+    if (!p.req.used) {
+        fillRequest(p.req, path, contentType, body, length, deadlineMs, maxAttempts, callback, arg, headers);
+        beginRequest(p);
+        return true;
+    }
+    if (p.next.used) {
+        if (strcmp(p.next.path, path) != 0) {
+            p.stats.rejected++;
+            return false;
+        }
+        // Zadnje stanje zmaga - starejši čakajoč ni bil nikoli poslan
+        static HttpRequest old;      // samo glavna zanka; ne na sklad (MSG_BODY_MAX)
+        old = p.next;
+        fillRequest(p.next, path, contentType, body, length, deadlineMs, maxAttempts, callback, arg, headers);
+        p.stats.superseded++;
+        notifyResult(peer, old, HTTP_POOL_SUPERSEDED, 0, 0, 0, "", "");
+        return true;
+    }
+    fillRequest(p.next, path, contentType, body, length, deadlineMs, maxAttempts, callback, arg, headers);
+    return true;
+}
+
+bool httpPoolBusy(HttpPeerId peer) {
+    return peer < HTTP_PEER_COUNT && peers[peer].req.used;
+}
+
+uint32_t httpBackoffMs(uint32_t baseMs, uint32_t maxMs, uint8_t failures) {
+    uint32_t delay = baseMs;
+    for (uint8_t i = 1; i < failures && delay < maxMs; i++) delay *= 2;
+    if (delay > maxMs) delay = maxMs;
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+bool httpHeaderValue(const char* headers, const char* name, char* out, size_t size) {
+    size_t nameLen = strlen(name);
+    for (const char* line = strstr(headers, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') continue;
+        const char* value = line + nameLen + 1;
+        while (*value == ' ') value++;
+        const char* end = strstr(value, "\r\n");
+        size_t len = end ? (size_t)(end - value) : strlen(value);
+        if (len >= size) len = size - 1;
+        memcpy(out, value, len);
+        out[len] = '\0';
+        return true;
+    }
+    return false;
+}
+
+void httpPoolGetStats(HttpPeerId peer, HttpPeerStats& stats) {
+    if (peer >= HTTP_PEER_COUNT) {
+        memset(&stats, 0, sizeof(stats));
+        return;
+    }
+    stats = peers[peer].stats;
+    stats.connected = peers[peer].open;
+    stats.busy = peers[peer].req.used;
+}
+
+// Zaključi zahtevek, kliče callback in začne čakajočega
+static void completeRequest(HttpPeerId peer, int code) {
+    HttpPeer& p = peers[peer];
+    unsigned long now = millis();
+    p.state = HTTP_SLOT_IDLE;
+    p.stats.lastUsed = now;
+    if (code <= 0 || code >= 500) p.stats.failures++;
+
+    static HttpRequest done;         // samo glavna zanka; ne na sklad (MSG_BODY_MAX)
+    done = p.req;
+    char response[HTTP_RESPONSE_MAX + 1];
+    uint16_t responseLen = code > 0 ? p.responseLen : 0;
+    memcpy(response, p.response, responseLen);
+    response[responseLen] = '\0';
+    uint8_t attempts = p.attempts;
+    uint32_t elapsedMs = now - p.started;
+    uint32_t rttMs = code > 0 && p.gotData ? p.finishedAt - p.sentAt : 0;
+    // Glava ostane veljavna v callbacku, tudi ko čakajoči zahtevek že teče
+    char headers[HTTP_HEAD_MAX];
+    if (p.headDone && code > 0) {
+        memcpy(headers, p.head, p.headLen);
+        headers[p.headLen] = '\0';
+    } else {
+        headers[0] = '\0';
+    }
+    p.req.used = false;
+    if (p.next.used) {
+        p.req = p.next;
+        p.next.used = false;
+        beginRequest(p);
+    }
+    metricsObserveHttpClient(peer, code, elapsedMs);
+    notifyResult(peer, done, code, attempts, elapsedMs, rttMs, response, headers);
+}
+
+static void servicePeer(HttpPeerId peer, unsigned long now) {
+    HttpPeer& p = peers[peer];
+    uint8_t state = p.state;
+
+    if (state == HTTP_SLOT_CONNECTING || state == HTTP_SLOT_WAITING) {
+        uint32_t limit = state == HTTP_SLOT_CONNECTING ? HTTP_CONNECT_TIMEOUT_MS : HTTP_ATTEMPT_TIMEOUT_MS;
+        if ((now - p.attemptStart >= limit || now - p.started >= p.req.deadlineMs) &&
+            finishAttemptFromLoop(p, HTTP_POOL_ERROR_TIMEOUT)) {
+            p.stats.timeouts++;
+            closePeer(p);       // pozni odgovor ne sme priti v naslednji poskus
+        }
+        return;
+    }
+
+    if (state == HTTP_SLOT_FINISHED) {
+        int code = p.code;
+        if (code <= 0 || p.closeAfter) closePeer(p);
+
+        // Peer je zaprl keep-alive povezavo med zahtevki - takoj po novi, ne šteje kot poskus
+        if (code <= 0 && p.reused && !p.gotData && now - p.started < p.req.deadlineMs) {
+            p.stats.staleRetries++;
+            p.attempts--;
+            startAttempt(p);
+            return;
+        }
+        uint32_t backoff = httpBackoffMs(HTTP_RETRY_BACKOFF_MS, HTTP_RETRY_BACKOFF_MAX_MS, p.attempts);
+        if ((code <= 0 || code >= 500) && p.attempts < p.req.maxAttempts &&
+            now + backoff - p.started < p.req.deadlineMs) {
+            p.stats.retries++;
+            p.retryAt = now + backoff;
+            p.state = HTTP_SLOT_BACKOFF;
+            return;
+        }
+        completeRequest(peer, code);
+        return;
+    }
+
+    if (state == HTTP_SLOT_BACKOFF) {
+        if ((long)(now - p.retryAt) >= 0) startAttempt(p);
+        return;
+    }
+
+    if (p.open && now - p.stats.lastUsed > HTTP_KEEPALIVE_IDLE_MS) closePeer(p);
+}
+
+#ifdef HTTP_BENCH
+static HttpBenchResult benchResult = {};
+static volatile uint16_t benchPending = 0;
+static uint8_t benchPhase;          // 0 = nova povezava, 1 = keep-alive
+static uint16_t benchSent;
+static uint16_t benchFailures;
+static unsigned long benchStart;
+static const char benchPayload[] = "{\"fwc\":0,\"fut\":0,\"fkop\":0,\"fdse\":0,\"tbat\":22.5,\"hbat\":55.1,\"pwr\":12.0}";
+
+void httpBenchRequest(const char* host, uint16_t messages) {
+    if (benchResult.running) return;
+    strlcpy(benchHost, host, sizeof(benchHost));
+    benchResult.running = true;
+    benchPending = messages;
+}
+
+void httpBenchGetResult(HttpBenchResult& result) {
+    result = benchResult;
+}
+
+static void sendBenchMessage();
+
+// Zaporedni STATUS_UPDATE: vsak naslednji se pošlje iz callbacka prejšnjega
+static void onBenchDone(const HttpResult& result, void* arg) {
+    if (result.code < 200 || result.code >= 300) benchFailures++;
+    if (++benchSent < benchResult.messages) {
+        sendBenchMessage();
+        return;
+    }
+
+    float perSec = benchSent * 1000.0f / max(1UL, millis() - benchStart);
+    if (benchPhase == 0) {
+        benchResult.freshPerSec = perSec;
+        benchResult.freshFailures = benchFailures;
+        benchPhase = 1;
+        benchSent = 0;
+        benchFailures = 0;
+        benchStart = millis();
+        sendBenchMessage();
+        return;
+    }
+    benchResult.keepAlivePerSec = perSec;
+    benchResult.keepAliveFailures = benchFailures;
+    closePeer(peers[HTTP_PEER_BENCH]);
+    benchResult.running = false;
+    LOG_INFO("HTTP", "Bench %s: %u sporočil, nova povezava %.1f msg/s (%u napak), keep-alive %.1f msg/s (%u napak)",
+             benchHost, benchResult.messages, benchResult.freshPerSec, benchResult.freshFailures,
+             benchResult.keepAlivePerSec, benchResult.keepAliveFailures);
+}
+
+static void sendBenchMessage() {
+    if (benchPhase == 0) closePeer(peers[HTTP_PEER_BENCH]);
+    httpPoolSend(HTTP_PEER_BENCH, "/api/status-update", "application/json", (const uint8_t*)benchPayload,
+                 sizeof(benchPayload) - 1, 5000, 1, onBenchDone, nullptr);
+}
+
+static void startHttpBench() {
+    if (benchPending == 0 || httpPoolBusy(HTTP_PEER_BENCH)) return;
+    benchResult.messages = benchPending;
+    benchPending = 0;
+    benchPhase = 0;
+    benchSent = 0;
+    benchFailures = 0;
+    benchStart = millis();
+    sendBenchMessage();
+}
+#endif
+
+void httpPoolService() {
+    unsigned long now = millis();
+    for (int i = 0; i < HTTP_PEER_COUNT; i++) servicePeer((HttpPeerId)i, now);
+#ifdef HTTP_BENCH
+    startHttpBench();
+#endif
+}
@@ -0,0 +1,112 @@
+// httppool.h - Asynchronous keep-alive HTTP client for REW and DEW units
+//
+// Vsak peer ima en AsyncClient (AsyncTCP), ki ostane povezan med zahtevki
+// (HTTP/1.1 keep-alive), dokler ga peer ne zapre ali ni neaktiven dlje od
+// HTTP_KEEPALIVE_IDLE_MS. Zahtevki na različne peerje tečejo hkrati; nič ne
+// blokira glavne zanke. Rok (deadline) velja za celoten zahtevek skupaj s
+// ponovitvami, med poskusi je neblokirajoč eksponentni backoff z naključnim
+// zamikom (od HTTP_RETRY_BACKOFF_MS, glej httpBackoffMs).
+//
+// AsyncTCP callbacki tečejo v async_tcp tasku; roke, ponovitve in klic
+// HttpDoneCallback izvaja httpPoolService() v glavni zanki. Predaja poteka pod
+// poolMux: med poskusom (CONNECTING/WAITING) odgovor piše samo callback, zanka
+// se ga dotakne šele, ko je stanje HTTP_SLOT_FINISHED. Zanka poskusa po roku ne
+// zaključi med delom callbacka in povezavo po roku zapre, preden začne
+// naslednji poskus. Chunked odgovori se dekodirajo (response je samo telo).
+//
+// Na peer je en zahtevek v teku in en čakajoč. Nov zahtevek na isto pot
+// zamenja čakajočega (zadnje stanje zmaga, stari dobi HTTP_POOL_SUPERSEDED).
+
+#ifndef HTTPPOOL_H
+#define HTTPPOOL_H
+
+#include <Arduino.h>
+
+enum HttpPeerId : uint8_t {
+    HTTP_PEER_REW = 0,
+    HTTP_PEER_UT_DEW,
+    HTTP_PEER_KOP_DEW,
+#ifdef HTTP_BENCH
+    HTTP_PEER_BENCH,          // nadomestni strežnik za /api/http-bench
+#endif
+    HTTP_PEER_COUNT
+};
+
+// Napake poskusa (< 0, vrednosti kot HTTPC_ERROR_*)
+#define HTTP_POOL_ERROR_CONNECT  -1
+#define HTTP_POOL_ERROR_SEND     -3
+#define HTTP_POOL_ERROR_LOST     -5
+#define HTTP_POOL_ERROR_TIMEOUT  -11
+#define HTTP_POOL_SUPERSEDED     -20   // ni poslan, nadomestil ga je novejši
+
+struct HttpResult {
+    HttpPeerId peer;
+    int code;                 // HTTP koda ali HTTP_POOL_ERROR_*
+    uint8_t attempts;
+    uint32_t elapsedMs;
+    uint32_t rttMs;           // zadnji poskus: od oddaje do konca odgovora v AsyncTCP callbacku (0 = brez odgovora)
+    const uint8_t* request;   // poslano telo
+    size_t requestLength;
+    const char* contentType;  // Content-Type poslanega telesa (nullptr pri GET)
+    const char* response;     // začetek telesa odgovora (do HTTP_RESPONSE_MAX, "" ob napaki)
+    const char* headers;      // statusna vrstica in glave odgovora ("" ob napaki)
+};
+
+typedef void (*HttpDoneCallback)(const HttpResult& result, void* arg);
+
+struct HttpPeerStats {
+    uint32_t requests;
+    uint32_t connects;        // nove TCP povezave
+    uint32_t reuses;          // poskusi po obstoječi povezavi
+    uint32_t staleRetries;    // ponovljeni takoj po zaprti keep-alive povezavi
+    uint32_t retries;         // ponovitve po backoffu
+    uint32_t timeouts;
+    uint32_t failures;        // zahtevki, ki niso uspeli do roka
+    uint32_t superseded;      // čakajoč zahtevek nadomeščen z novejšim
+    uint32_t rejected;        // peer je bil zaseden z drugo potjo
+    unsigned long lastUsed;
+    bool connected;
+    bool busy;
+};
+
+const char* httpPeerName(HttpPeerId peer);
+const char* httpPeerHost(HttpPeerId peer);
+
+void initHttpPool();
+
+// contentType == nullptr -> GET, sicer POST telesa (kopira se v pool, do MSG_BODY_MAX).
+// deadlineMs velja od začetka pošiljanja, headers so dodatne vrstice glave
+// ("Ime: vrednost\r\n", statičen niz). Vrne false, če je peer zaseden z drugo
+// potjo ali je telo preveliko; sicer se callback kliče natanko enkrat iz httpPoolService().
+bool httpPoolSend(HttpPeerId peer, const char* path, const char* contentType, const uint8_t* body, size_t length,
+                  uint32_t deadlineMs, uint8_t maxAttempts, HttpDoneCallback callback, void* arg,
+                  const char* headers = nullptr);
+bool httpPoolBusy(HttpPeerId peer);
+
+// Eksponentni backoff z naključnim zamikom: baseMs * 2^(failures-1), največ maxMs,
+// nato naključno med polovico in celim intervalom - ponovitve se ne poravnajo
+uint32_t httpBackoffMs(uint32_t baseMs, uint32_t maxMs, uint8_t failures);
+
+// Vrednost glave iz HttpResult::headers (ime brez dvopičja, neobčutljivo na velikost črk)
+bool httpHeaderValue(const char* headers, const char* name, char* out, size_t size);
+void httpPoolGetStats(HttpPeerId peer, HttpPeerStats& stats);
+
+#ifdef HTTP_BENCH
+struct HttpBenchResult {
+    bool running;
+    uint16_t messages;
+    float freshPerSec;        // nova povezava za vsako sporočilo
+    float keepAlivePerSec;    // keep-alive
+    uint16_t freshFailures;
+    uint16_t keepAliveFailures;
+};
+
+// Meritev proti host:80 - zaporedni STATUS_UPDATE, najprej brez, nato s keep-alive
+void httpBenchRequest(const char* host, uint16_t messages);
+void httpBenchGetResult(HttpBenchResult& result);
+#endif
+
+// Iz glavne zanke: roki, backoff, idle povezave, callbacki
+void httpPoolService();
+
+#endif // HTTPPOOL_H
@@ -0,0 +1,176 @@
+// liveness.cpp - Liveness monitor for REW and DEW units
+
+#include "liveness.h"
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "outbox.h"
+
+#define LIVENESS_PEERS 3            // REW, UT_DEW, KOP_DEW (bench ni nadzorovan)
+
+struct PeerLiveness {
+    LivenessStats stats;
+    bool probing;
+    bool rttValid;
+    unsigned long nextProbe;
+};
+
+static PeerLiveness monitor[LIVENESS_PEERS];
+static uint8_t roundPending = 0;    // enote v krogu checkAllDevices
+
+// Enote, od katerih je prišel zahtevek (async_tcp); prevzame livenessService
+static uint8_t seenPending = 0;
+static portMUX_TYPE seenMux = portMUX_INITIALIZER_UNLOCKED;
+
+static DeviceStatus& peerStatus(HttpPeerId peer) {
+    if (peer == HTTP_PEER_UT_DEW) return utDewStatus;
+    if (peer == HTTP_PEER_KOP_DEW) return kopDewStatus;
+    return rewStatus;
+}
+
+static void setOnline(HttpPeerId peer, bool online) {
+    monitor[peer].stats.online = online;
+    peerStatus(peer).isOnline = online;
+    if (online) outboxWake(peer);
+}
+
+// SRTT/RTTVAR kot pri TCP (RFC 6298): prva meritev R, R/2
+static void updateRtt(LivenessStats& s, PeerLiveness& m, uint32_t sample) {
+    float r = sample;
+    if (!m.rttValid) {
+        s.rttMs = r;
+        s.jitterMs = r / 2;
+        m.rttValid = true;
+    } else {
+        s.jitterMs += (fabsf(r - s.rttMs) - s.jitterMs) / 4;
+        s.rttMs += (r - s.rttMs) / 8;
+    }
+    s.lastRttMs = sample;
+}
+
+static void scheduleProbe(HttpPeerId peer, unsigned long now) {
+    PeerLiveness& m = monitor[peer];
+    m.nextProbe = now + (m.stats.online ? LIVENESS_INTERVAL_MS
+                                        : httpBackoffMs(LIVENESS_BACKOFF_MIN_MS, LIVENESS_BACKOFF_MAX_MS,
+                                                        m.stats.consecutiveFailures));
+}
+
+static bool recordSuccess(HttpPeerId peer) {
+    LivenessStats& s = monitor[peer].stats;
+    s.consecutiveFailures = 0;
+    s.lastSeen = millis();
+    if (s.online) return false;
+    setOnline(peer, true);
+    return true;
+}
+
+static void recordFailure(HttpPeerId peer) {
+    LivenessStats& s = monitor[peer].stats;
+    if (s.consecutiveFailures < 255) s.consecutiveFailures++;
+    if (s.online && s.consecutiveFailures >= LIVENESS_DOWN_AFTER) {
+        setOnline(peer, false);
+        LOG_WARN("HTTP", "%s marked offline (%u zaporednih neuspehov)", httpPeerName(peer), s.consecutiveFailures);
+    }
+}
+
+static void logRoundSummary() {
+    LOG_INFO("HTTP", "Offline test: REW %s, UT_DEW %s, KOP_DEW %s",
+             monitor[HTTP_PEER_REW].stats.online ? "online" : "offline",
+             monitor[HTTP_PEER_UT_DEW].stats.online ? "online" : "offline",
+             monitor[HTTP_PEER_KOP_DEW].stats.online ? "online" : "offline");
+}
+
+static void onProbeDone(const HttpResult& result, void* arg) {
+    HttpPeerId peer = result.peer;
+    PeerLiveness& m = monitor[peer];
+    m.probing = false;
+    m.stats.probes++;
+    bool inRound = roundPending & (1 << peer);
+
+    if (result.code == 200 && strcmp(result.response, "pong") == 0) {
+        updateRtt(m.stats, m, result.rttMs);
+        if (recordSuccess(peer) && !inRound) {
+            LOG_INFO("HTTP", "%s online (RTT %lu ms)", httpPeerName(peer), (unsigned long)result.rttMs);
+        }
+    } else {
+        m.stats.probeFailures++;
+        recordFailure(peer);
+    }
+    scheduleProbe(peer, millis());
+
+    if (inRound) {
+        roundPending &= ~(1 << peer);
+        if (roundPending == 0) logRoundSummary();
+    }
+}
+
+static bool probe(HttpPeerId peer) {
+    PeerLiveness& m = monitor[peer];
+    if (m.probing) return true;
+    if (!httpPoolSend(peer, "/api/ping", nullptr, nullptr, 0, HTTP_PING_TIMEOUT_MS, 1, onProbeDone, nullptr)) {
+        return false;
+    }
+    m.probing = true;
+    return true;
+}
+
+// Vse enote hkrati - ne blokira; zaseden peer obdrži trenutno stanje
+void checkAllDevices() {
+    if (roundPending != 0) return;   // prejšnji krog še teče
+    for (int i = 0; i < LIVENESS_PEERS; i++) {
+        if (probe((HttpPeerId)i)) roundPending |= 1 << i;
+    }
+    if (roundPending == 0) logRoundSummary();
+}
+
+bool livenessReport(HttpPeerId peer, bool reachable) {
+    if (peer >= LIVENESS_PEERS) return false;
+    if (reachable) return recordSuccess(peer);
+    recordFailure(peer);
+    monitor[peer].nextProbe = millis();     // potrdi s pingom takoj
+    return false;
+}
+
+void livenessSeen(HttpPeerId peer) {
+    if (peer >= LIVENESS_PEERS) return;
+    portENTER_CRITICAL(&seenMux);
+    seenPending |= 1 << peer;
+    portEXIT_CRITICAL(&seenMux);
+}
+
+bool livenessUsable(HttpPeerId peer) {
+    return peer >= LIVENESS_PEERS || monitor[peer].stats.online;
+}
+
+void livenessGetStats(HttpPeerId peer, LivenessStats& stats) {
+    if (peer >= LIVENESS_PEERS) {
+        memset(&stats, 0, sizeof(stats));
+        return;
+    }
+    stats = monitor[peer].stats;
+}
+
+void livenessService() {
+    portENTER_CRITICAL(&seenMux);
+    uint8_t seen = seenPending;
+    seenPending = 0;
+    portEXIT_CRITICAL(&seenMux);
+    for (int i = 0; i < LIVENESS_PEERS; i++) {
+        if ((seen & (1 << i)) && livenessReport((HttpPeerId)i, true)) {
+            LOG_INFO("HTTP", "%s reaktiviran ob prejemu zahtevka", httpPeerName((HttpPeerId)i));
+        }
+    }
+
+    unsigned long now = millis();
+    for (int i = 0; i < LIVENESS_PEERS; i++) {
+        HttpPeerId peer = (HttpPeerId)i;
+        PeerLiveness& m = monitor[i];
+        if (m.probing || (long)(now - m.nextProbe) < 0) continue;
+        // Uspešen promet je dovolj dokaz - ping samo ob tišini
+        if (m.stats.online && now - m.stats.lastSeen < LIVENESS_INTERVAL_MS) {
+            m.nextProbe = m.stats.lastSeen + LIVENESS_INTERVAL_MS;
+            continue;
+        }
+        if (!probe(peer)) m.nextProbe = now + HTTP_PING_TIMEOUT_MS;   // peer zaseden z drugo potjo
+    }
+}
@@ -0,0 +1,54 @@
+// liveness.h - Liveness monitor for REW and DEW units
+//
+// Vse enote se preverjajo hkrati in neblokirajoče z GET /api/ping prek
+// httppool (kratek rok HTTP_PING_TIMEOUT_MS). Dosegljiva enota se preveri
+// vsakih LIVENESS_INTERVAL_MS, a le, če v tem času ni bilo uspešnega prometa.
+// Nedosegljiva se preverja z eksponentnim backoffom (do LIVENESS_BACKOFF_MAX_MS).
+//
+// Iz odgovorov se vodi RTT (EWMA, alfa 1/8) in jitter (povprečno odstopanje,
+// beta 1/4, kot SRTT/RTTVAR pri TCP) ter zaporedni neuspehi. RTT je
+// HttpResult::rttMs - od oddaje zahtevka do konca odgovora, merjeno v AsyncTCP
+// callbackih, zato ne vsebuje TCP rokovanja (ping po LIVENESS_INTERVAL_MS
+// običajno odpre novo povezavo) niti zamika glavne zanke. Enota je offline
+// po LIVENESS_DOWN_AFTER zaporednih neuspehih (ping ali neuspela dostava).
+// Takrat outbox do nje ne pošilja. Ob vrnitvi se outbox takoj sproži.
+//
+// Enota sme biti online (DeviceStatus::isOnline) samo tukaj; ostali moduli
+// sporočajo opažanja z livenessReport().
+
+#ifndef LIVENESS_H
+#define LIVENESS_H
+
+#include <Arduino.h>
+#include "httppool.h"
+
+struct LivenessStats {
+    bool online;
+    uint8_t consecutiveFailures;
+    float rttMs;              // EWMA; 0 = še ni meritve
+    float jitterMs;
+    uint32_t lastRttMs;
+    uint32_t probes;
+    uint32_t probeFailures;
+    unsigned long lastSeen;   // millis() zadnjega uspešnega odziva
+};
+
+// Takojšen krog vseh enot (ob zagonu); povzetek v log, ko odgovorijo vse
+void checkAllDevices();
+
+// Opažanje iz prometa: uspešna/neuspešna dostava ali prejet zahtevek od enote.
+// Vrne true, če je enota s tem prešla v online. Samo iz glavne zanke.
+bool livenessReport(HttpPeerId peer, bool reachable);
+// Prejet zahtevek od enote iz async_tcp (web, /ws): samo zastavica, ki jo
+// livenessService() v glavni zanki preda livenessReport()
+void livenessSeen(HttpPeerId peer);
+
+// Ali naj se enoti pošilja (online); peer brez nadzora (bench) vedno true
+bool livenessUsable(HttpPeerId peer);
+
+void livenessGetStats(HttpPeerId peer, LivenessStats& stats);
+
+// Iz glavne zanke: razpored pingov
+void livenessService();
+
+#endif // LIVENESS_H
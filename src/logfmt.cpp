@@ -0,0 +1,252 @@
+// logfmt.cpp - Deferred log formatting for CEE
+
+#include "logfmt.h"
+
+enum LogArgKind : uint8_t {
+    LOG_ARG_NONE = 0,    // %%
+    LOG_ARG_INT,
+    LOG_ARG_LLONG,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER,
+    LOG_ARG_INVALID
+};
+
+struct LogFormatSpec {
+    const char* start;   // '%'
+    const char* end;     // za znakom pretvorbe
+    uint8_t stars;       // '*' širina/natančnost (int argumenti pred vrednostjo)
+    LogArgKind kind;
+};
+
+#define LOG_SPEC_MAX 24  // najdaljši posamezen format (npr. "%-08.3lf")
+
+// Poišče naslednji format od p naprej; nullptr, če ga ni več
+static const char* nextFormatSpec(const char* p, LogFormatSpec& spec) {
+    p = strchr(p, '%');
+    if (!p) return nullptr;
+
+    spec.start = p++;
+    spec.stars = 0;
+    spec.kind = LOG_ARG_INVALID;
+
+    if (*p == '%') {
+        spec.kind = LOG_ARG_NONE;
+        spec.end = p + 1;
+        return spec.start;
+    }
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') { spec.stars++; p++; }
+    else while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec.stars++; p++; }
+        else while (*p >= '0' && *p <= '9') p++;
+    }
+
+    bool longLong = false;
+    if (*p == 'h') { p++; if (*p == 'h') p++; }
+    else if (*p == 'l') { p++; if (*p == 'l') { longLong = true; p++; } }
+    else if (*p == 'j') { longLong = true; p++; }
+    else if (*p == 'z' || *p == 't' || *p == 'L') p++;
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec.kind = longLong ? LOG_ARG_LLONG : LOG_ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec.kind = LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            spec.kind = LOG_ARG_STRING;
+            break;
+        case 'p':
+            spec.kind = LOG_ARG_POINTER;
+            break;
+        default:
+            spec.kind = LOG_ARG_INVALID;   // %n, neznano ali konec niza
+            break;
+    }
+    spec.end = *p ? p + 1 : p;
+    if (spec.end - spec.start >= LOG_SPEC_MAX) spec.kind = LOG_ARG_INVALID;
+    return spec.start;
+}
+
+size_t logCaptureArgs(uint8_t* out, size_t outSize, const char* format, va_list args) {
+    size_t pos = 0;
+    uint32_t fmtAddr = (uint32_t)(uintptr_t)format;
+    if (outSize < sizeof(fmtAddr)) return 0;
+    memcpy(out, &fmtAddr, sizeof(fmtAddr));
+    pos += sizeof(fmtAddr);
+
+    LogFormatSpec spec;
+    const char* p = format;
+    while (nextFormatSpec(p, spec)) {
+        p = spec.end;
+        if (spec.kind == LOG_ARG_INVALID) return 0;
+
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            int32_t v = va_arg(args, int);
+            if (pos + sizeof(v) > outSize) return 0;
+            memcpy(out + pos, &v, sizeof(v));
+            pos += sizeof(v);
+        }
+
+        switch (spec.kind) {
+            case LOG_ARG_INT: {
+                int32_t v = va_arg(args, int);
+                if (pos + sizeof(v) > outSize) return 0;
+                memcpy(out + pos, &v, sizeof(v));
+                pos += sizeof(v);
+                break;
+            }
+            case LOG_ARG_POINTER: {
+                uint32_t v = (uint32_t)(uintptr_t)va_arg(args, void*);
+                if (pos + sizeof(v) > outSize) return 0;
+                memcpy(out + pos, &v, sizeof(v));
+                pos += sizeof(v);
+                break;
+            }
+            case LOG_ARG_LLONG: {
+                int64_t v = va_arg(args, long long);
+                if (pos + sizeof(v) > outSize) return 0;
+                memcpy(out + pos, &v, sizeof(v));
+                pos += sizeof(v);
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double v = va_arg(args, double);
+                if (pos + sizeof(v) > outSize) return 0;
+                memcpy(out + pos, &v, sizeof(v));
+                pos += sizeof(v);
+                break;
+            }
+            case LOG_ARG_STRING: {
+                const char* s = va_arg(args, const char*);
+                if (!s) s = "(null)";
+                if (pos >= outSize) return 0;
+                size_t len = strnlen(s, outSize - pos - 1);
+                memcpy(out + pos, s, len);
+                out[pos + len] = '\0';
+                pos += len + 1;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return pos;
+}
+
+// Oblikuje en format z že prebranimi '*' argumenti
+template <typename T>
+static int formatOne(char* out, size_t size, const char* spec, uint8_t stars, const int32_t* starArgs, T value) {
+    switch (stars) {
+        case 0:  return snprintf(out, size, spec, value);
+        case 1:  return snprintf(out, size, spec, starArgs[0], value);
+        default: return snprintf(out, size, spec, starArgs[0], starArgs[1], value);
+    }
+}
+
+size_t logRenderDeferred(char* out, size_t outSize, const uint8_t* payload, size_t length) {
+    if (outSize == 0) return 0;
+    out[0] = '\0';
+    if (length < sizeof(uint32_t)) return 0;
+
+    uint32_t fmtAddr;
+    memcpy(&fmtAddr, payload, sizeof(fmtAddr));
+    const char* format = (const char*)(uintptr_t)fmtAddr;
+    size_t in = sizeof(fmtAddr);
+    size_t pos = 0;
+
+    LogFormatSpec spec;
+    const char* p = format;
+    char specBuf[LOG_SPEC_MAX];
+    while (pos < outSize - 1) {
+        const char* next = nextFormatSpec(p, spec);
+        size_t literal = next ? (size_t)(next - p) : strlen(p);
+        if (literal > outSize - 1 - pos) literal = outSize - 1 - pos;
+        memcpy(out + pos, p, literal);
+        pos += literal;
+        if (!next || pos >= outSize - 1) break;
+        p = spec.end;
+
+        if (spec.kind == LOG_ARG_NONE) {
+            out[pos++] = '%';
+            continue;
+        }
+        if (spec.kind == LOG_ARG_INVALID) break;
+
+        int32_t starArgs[2] = {0, 0};
+        for (uint8_t i = 0; i < spec.stars && i < 2; i++) {
+            if (in + sizeof(int32_t) > length) goto truncated;
+            memcpy(&starArgs[i], payload + in, sizeof(int32_t));
+            in += sizeof(int32_t);
+        }
+
+        {
+            size_t specLen = spec.end - spec.start;
+            memcpy(specBuf, spec.start, specLen);
+            specBuf[specLen] = '\0';
+            int n = 0;
+            switch (spec.kind) {
+                case LOG_ARG_INT: {
+                    int32_t v;
+                    if (in + sizeof(v) > length) goto truncated;
+                    memcpy(&v, payload + in, sizeof(v));
+                    in += sizeof(v);
+                    n = formatOne(out + pos, outSize - pos, specBuf, spec.stars, starArgs, (int)v);
+                    break;
+                }
+                case LOG_ARG_POINTER: {
+                    uint32_t v;
+                    if (in + sizeof(v) > length) goto truncated;
+                    memcpy(&v, payload + in, sizeof(v));
+                    in += sizeof(v);
+                    n = formatOne(out + pos, outSize - pos, specBuf, spec.stars, starArgs, (void*)(uintptr_t)v);
+                    break;
+                }
+                case LOG_ARG_LLONG: {
+                    int64_t v;
+                    if (in + sizeof(v) > length) goto truncated;
+                    memcpy(&v, payload + in, sizeof(v));
+                    in += sizeof(v);
+                    n = formatOne(out + pos, outSize - pos, specBuf, spec.stars, starArgs, (long long)v);
+                    break;
+                }
+                case LOG_ARG_DOUBLE: {
+                    double v;
+                    if (in + sizeof(v) > length) goto truncated;
+                    memcpy(&v, payload + in, sizeof(v));
+                    in += sizeof(v);
+                    n = formatOne(out + pos, outSize - pos, specBuf, spec.stars, starArgs, v);
+                    break;
+                }
+                case LOG_ARG_STRING: {
+                    const char* s = (const char*)payload + in;
+                    size_t maxLen = length - in;
+                    size_t len = strnlen(s, maxLen);
+                    if (len == maxLen) goto truncated;   // manjka \0
+                    in += len + 1;
+                    n = formatOne(out + pos, outSize - pos, specBuf, spec.stars, starArgs, s);
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (n > 0) pos += ((size_t)n < outSize - pos) ? (size_t)n : outSize - 1 - pos;
+        }
+    }
+    out[pos] = '\0';
+    return pos;
+
+truncated:
+    // Poškodovan zapis - izpiši, kar je bilo oblikovano
+    if (pos + 4 < outSize) {
+        memcpy(out + pos, "<?>", 3);
+        pos += 3;
+    }
+    out[pos] = '\0';
+    return pos;
+}
@@ -0,0 +1,25 @@
+// logfmt.h - Deferred log formatting for CEE
+//
+// Namesto vsnprintf ob klicu LOG_* se v ring zapiše naslov format niza
+// (literal v flash) in surovi argumenti. Oblikovanje se izvede šele, ko
+// zapis prebere porabnik (serial, /logs, REW). Nize (%s) se kopira, ker
+// kazalec ob branju morda ni več veljaven.
+//
+// Payload: [u32 naslov formata][argumenti po vrsti formata]
+//   cela števila, %c, %p, '*' -> 4 B; %ll/%j -> 8 B; %f/%e/%g -> 8 B (double)
+//   %s -> niz z zaključnim \0 (skrajšan, če zmanjka prostora)
+// Enako obliko dekodira tools/logdecode.py.
+
+#ifndef LOGFMT_H
+#define LOGFMT_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+// Zapiše payload v out; vrne 0, če format ni podprt ali ne gre v out
+size_t logCaptureArgs(uint8_t* out, size_t outSize, const char* format, va_list args);
+
+// Oblikuje payload v besedilo; vrne dolžino besedila
+size_t logRenderDeferred(char* out, size_t outSize, const uint8_t* payload, size_t length);
+
+#endif // LOGFMT_H
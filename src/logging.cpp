@@ -5,65 +5,386 @@
 #include <stdarg.h>
 #include "globals.h"
 #include "config.h"
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "logfmt.h"
+#include "loglimit.h"
+#include "logship.h"
 
-void logEvent(const char* message) {
-    unsigned long timestamp;
+static const char* const logTagNames[LOG_TAG_COUNT] = {
+#define LOG_TAG_NAME(id, name) name,
+    LOG_TAG_LIST(LOG_TAG_NAME)
+#undef LOG_TAG_NAME
+};
+
+uint8_t logTagLevels[LOG_TAG_COUNT] = {};   // privzeto vse od DEBUG naprej
+
+// Kazalci porabnikov ringa (serial, REW)
+static LogCursor consumerCursors[LOG_CONSUMER_COUNT];
+static portMUX_TYPE cursorMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool serialDraining = false;
+static TaskHandle_t serialTask = NULL;
+static LogSerialStats serialStats = {};
+
+const char* logLevelName(uint8_t level) {
+    switch (level) {
+        case LOG_LEVEL_DEBUG: return "DEBUG";
+        case LOG_LEVEL_INFO:  return "INFO";
+        case LOG_LEVEL_WARN:  return "WARN";
+        case LOG_LEVEL_ERROR: return "ERROR";
+    }
+    return "";
+}
+
+const char* logTagName(uint8_t tag) {
+    return tag < LOG_TAG_COUNT ? logTagNames[tag] : "?";
+}
+
+uint8_t logTagId(const char* tag) {
+    for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+        if (logTagNames[i] == tag || strcmp(logTagNames[i], tag) == 0) return i;
+    }
+    return LOG_TAG_OTHER;
+}
+
+// Oblikuje odloženi zapis (surov iz logRingRead) v besedilo
+void renderLogEntry(LogEntry& entry) {
+    if (entry.level & LOG_LEVEL_DEFERRED_FLAG) {
+        uint8_t payload[LOG_RING_MSG_MAX];
+        memcpy(payload, entry.text, entry.length);
+        entry.length = logRenderDeferred(entry.text, sizeof(entry.text), payload, entry.length);
+        entry.level &= ~LOG_LEVEL_DEFERRED_FLAG;
+    }
+}
+
+// Prebere naslednji zapis in ga po potrebi oblikuje (odloženi format)
+bool readLogEntry(LogCursor& cursor, LogEntry& entry) {
+    if (!logRingRead(cursor, entry)) return false;
+    renderLogEntry(entry);
+    return true;
+}
+
+// Besedilo zapisa v obliki "[tag:LEVEL] sporočilo" (CEE/OTHER imata besedilo že v celoti)
+size_t formatLogEntry(const LogEntry& entry, char* buf, size_t size) {
+    int n;
+    if (entry.tag == LOG_TAG_CEE || entry.tag == LOG_TAG_OTHER) {
+        n = snprintf(buf, size, "%s", entry.text);
+    } else {
+        n = snprintf(buf, size, "[%s:%s] %s", logTagName(entry.tag), logLevelName(entry.level), entry.text);
+    }
+    if (n < 0) return 0;
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
+
+// Vrstica "ts|CEE|besedilo\n" za REW/SD; buf mora imeti vsaj LOG_LINE_MAX bajtov
+size_t formatLogLine(const LogEntry& entry, char* buf, size_t size) {
+    int prefix = snprintf(buf, size, "%lu|CEE|", (unsigned long)entry.timestamp);
+    size_t len = prefix + formatLogEntry(entry, buf + prefix, size - prefix - 1);
+    buf[len++] = '\n';
+    buf[len] = '\0';
+    return len;
+}
+
+void getLogCursor(LogConsumer consumer, LogCursor& cursor) {
+    portENTER_CRITICAL(&cursorMux);
+    cursor = consumerCursors[consumer];
+    portEXIT_CRITICAL(&cursorMux);
+}
+
+void commitLogCursor(LogConsumer consumer, const LogCursor& cursor) {
+    portENTER_CRITICAL(&cursorMux);
+    consumerCursors[consumer] = cursor;
+    portEXIT_CRITICAL(&cursorMux);
+}
+
+size_t getLogPendingBytes(LogConsumer consumer) {
+    LogCursor cursor;
+    getLogCursor(consumer, cursor);
+    return logRingPendingBytes(cursor);
+}
+
+static uint32_t currentLogTimestamp() {
     if (timeSynced) {
-        timestamp = myTZ.now();  // Unix čas za zgodovinsko primerjavo
+        return myTZ.now();  // Unix čas za zgodovinsko primerjavo
+    }
+    return millis() / 1000;  // Fallback v sekundah od boot-a
+}
+
+// Izpiše nove zapise na Serial; hkrati izpisuje samo en task.
+// Teče v serial tasku - počasen UART/USB-CDC ne zadržuje klicateljev LOG_*.
+static void drainSerialLog() {
+    bool owner = false;
+    portENTER_CRITICAL(&cursorMux);
+    if (!serialDraining) {
+        serialDraining = true;
+        owner = true;
+    }
+    portEXIT_CRITICAL(&cursorMux);
+    if (!owner) return;
+
+    static LogEntry entry;
+    char text[LOG_RING_MSG_MAX + 32];
+    LogCursor cursor;
+    getLogCursor(LOG_CONSUMER_SERIAL, cursor);
+    uint32_t droppedBefore = cursor.dropped;
+    unsigned long start = millis();
+
+    size_t backlog = logRingPendingBytes(cursor);
+    if (backlog > serialStats.maxBacklogBytes) serialStats.maxBacklogBytes = backlog;
+
+    while (readLogEntry(cursor, entry)) {
+        if (cursor.dropped != droppedBefore) {
+            Serial.printf("[LOG] serial: %lu zapisov izgubljenih\n", (unsigned long)(cursor.dropped - droppedBefore));
+            serialStats.dropped += cursor.dropped - droppedBefore;
+            droppedBefore = cursor.dropped;
+        }
+        formatLogEntry(entry, text, sizeof(text));
+        Serial.printf("[%lu] %s\n", (unsigned long)entry.timestamp, text);
+        serialStats.records++;
+        if (millis() - start > LOG_SERIAL_LAG_MS) serialStats.lagged++;
+
+        // Kazalec sproti, da /current-data kaže dejanski zaostanek
+        commitLogCursor(LOG_CONSUMER_SERIAL, cursor);
+    }
+
+    serialDraining = false;
+}
+
+static void logSerialTask(void* param) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        drainSerialLog();
+    }
+}
+
+// Zbudi serial task; brez taska (napaka pri ustvarjanju) izpiše takoj
+static void notifySerialLog() {
+    if (serialTask != NULL) {
+        xTaskNotifyGive(serialTask);
     } else {
-        timestamp = millis() / 1000;  // Fallback v sekundah od boot-a
+        drainSerialLog();
+    }
+}
+
+void getLogSerialStats(LogSerialStats& stats) {
+    stats = serialStats;
+    LogCursor cursor;
+    getLogCursor(LOG_CONSUMER_SERIAL, cursor);
+    stats.pendingRecords = logRingPendingRecords(cursor);
+}
+
+static void appendLogRecord(uint8_t level, uint8_t tag, const char* text) {
+    uint32_t timestamp = currentLogTimestamp();
+
+    if (!loggingInitialized) {
+        // Pred initLogging() - samo Serial
+        Serial.printf("[%lu] %s\n", (unsigned long)timestamp, text);
+        return;
+    }
+
+    logRingAppend(timestamp, level, tag, text, strlen(text));
+    notifySerialLog();
+}
+
+// Najprej izpiše zapadle povzetke, nato preveri ponovitve in omejitev taga
+static void emitLogLimitSummaries(unsigned long now) {
+    char text[LOG_RING_MSG_MAX];
+    uint8_t level, tag;
+    while (logLimitNextSummary(text, sizeof(text), level, tag, now)) {
+        appendLogRecord(level, tag, text);
     }
+}
+
+static bool admitLogRecord(uint8_t level, uint8_t tag, uint32_t key, const char* text, size_t bytes) {
+    if (!loggingInitialized) return true;
+    unsigned long now = millis();
+    emitLogLimitSummaries(now);
+    return logLimitAdmit(level, tag, key, text, bytes, now);
+}
+
+// Sprejeti zapis je bil oblikovan - omejitev naj upošteva dejansko dolžino
+static void chargeLogRecord(uint8_t level, uint8_t tag, size_t estimate, size_t actual) {
+    if (!loggingInitialized) return;
+    logLimitCharge(level, tag, (int32_t)actual - (int32_t)estimate);
+}
 
-    char entry[256];
-    snprintf(entry, sizeof(entry), "[%lu] %s", timestamp, message);
-    Serial.println(entry);
+// Oblikuje in zapiše že sprejet zapis (estimate = dolžina, uporabljena ob sprejemu)
+static void appendFormatted(LogLevel level, uint8_t tagId, const char* tag, const char* format, va_list args,
+                            size_t estimate) {
+    char message[LOG_RING_MSG_MAX];
+    int length = vsnprintf(message, sizeof(message), format, args);
+    if (length > (int)sizeof(message) - 1) length = sizeof(message) - 1;
+    chargeLogRecord(level, tagId, estimate, length > 0 ? length : 0);
 
-    if (loggingInitialized) {
-        String ts = String(timestamp);
-        String logLine = ts + "|CEE|" + String(message) + "\n";
-        logBuffer += logLine;
+    if (tagId == LOG_TAG_OTHER || !loggingInitialized) {
+        // Tag ni v tabeli - ime ohranimo v besedilu
+        char fullMessage[LOG_RING_MSG_MAX];
+        snprintf(fullMessage, sizeof(fullMessage), "[%s:%s] %s", tag, logLevelName(level), message);
+        appendLogRecord(level, LOG_TAG_OTHER, fullMessage);
+        return;
     }
+    appendLogRecord(level, tagId, message);
+}
+
+// Ključ ponovitev iz surovih argumentov; nepodprt format - samo klicno mesto
+static uint32_t logRepeatKey(uint8_t tagId, const char* format, va_list args) {
+    uint8_t payload[LOG_RING_MSG_MAX - 1];
+    va_list capture;
+    va_copy(capture, args);
+    size_t length = logCaptureArgs(payload, sizeof(payload), format, capture);
+    va_end(capture);
+    return length > 0 ? logLimitPayloadKey(tagId, payload, length) : logLimitSiteKey(tagId, format);
+}
+
+static void logEventFormatted(LogLevel level, uint8_t tagId, const char* tag, const char* format, va_list args) {
+    // Sprejem pred oblikovanjem - zavržen zapis ne plača vsnprintf; dolžina formata je ocena
+    size_t estimate = strlen(format);
+    if (loggingInitialized && !admitLogRecord(level, tagId, logRepeatKey(tagId, format, args), format, estimate)) return;
+    appendFormatted(level, tagId, tag, format, args, estimate);
 }
 
+void logEvent(const char* message) {
+    if (LOG_LEVEL_INFO < logTagLevels[LOG_TAG_CEE]) return;
+    // Besedilo sestavi klicatelj - ključ je hash besedila
+    if (!admitLogRecord(LOG_LEVEL_INFO, LOG_TAG_CEE, logLimitTextKey(LOG_TAG_CEE, message), message, strlen(message))) return;
+    appendLogRecord(LOG_LEVEL_INFO, LOG_TAG_CEE, message);
+}
+
+// Tag iz niza (ne-literal) - id se poišče ob klicu
 void logEvent(LogLevel level, const char* tag, const char* format, ...) {
-    char message[256];
+    uint8_t tagId = logTagId(tag);
+    if (level < LOG_MIN_LEVEL || level < logTagLevels[tagId]) return;
     va_list args;
     va_start(args, format);
-    vsnprintf(message, sizeof(message), format, args);
+    logEventFormatted(level, tagId, tag, format, args);
     va_end(args);
+}
 
-    // Create formatted message with level and tag
-    char fullMessage[256];
-    const char* levelStr = "";
-    switch (level) {
-        case LOG_LEVEL_DEBUG: levelStr = "DEBUG"; break;
-        case LOG_LEVEL_INFO:  levelStr = "INFO";  break;
-        case LOG_LEVEL_WARN:  levelStr = "WARN";  break;
-        case LOG_LEVEL_ERROR: levelStr = "ERROR"; break;
+// Prag preveri že LOG_AT; tagId = logTagIdOf(tag) iz časa prevajanja
+void logEventTagged(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logEventFormatted(level, tagId, tag, format, args);
+    va_end(args);
+}
+
+// Format mora biti literal - v ring gre samo njegov naslov in surovi argumenti
+void logEventDeferred(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    if (tagId != LOG_TAG_OTHER && loggingInitialized) {
+        // Argumenti se zajamejo pred sprejemom - ključ ponovitev vključuje njihove vrednosti
+        size_t estimate = strlen(format);
+        uint8_t payload[LOG_RING_MSG_MAX - 1];
+        va_list capture;
+        va_copy(capture, args);
+        size_t length = logCaptureArgs(payload, sizeof(payload), format, capture);
+        va_end(capture);
+        uint32_t key = length > 0 ? logLimitPayloadKey(tagId, payload, length) : logLimitSiteKey(tagId, format);
+        if (!admitLogRecord(level, tagId, key, format, estimate)) {
+            va_end(args);
+            return;
+        }
+        if (length > 0) {
+            chargeLogRecord(level, tagId, estimate, length);
+            logRingAppend(currentLogTimestamp(), level | LOG_LEVEL_DEFERRED_FLAG, tagId, payload, length);
+            va_end(args);
+            notifySerialLog();
+            return;
+        }
+        // Nepodprt format - zapis je že sprejet, oblikuj takoj
+        appendFormatted(level, tagId, tag, format, args, estimate);
+        va_end(args);
+        return;
+    }
+
+    // Neznan tag ali pred initLogging() - oblikuj takoj
+    logEventFormatted(level, tagId, tag, format, args);
+    va_end(args);
+}
+
+// Nastavi prag taga (LOG_TAG_COUNT = vsi tagi); ne shrani v NVS
+bool setLogTagLevel(uint8_t tag, uint8_t level) {
+    if (level > LOG_LEVEL_ERROR + 1 || tag > LOG_TAG_COUNT) return false;   // ERROR+1 = izklopljen
+    if (tag == LOG_TAG_COUNT) {
+        memset(logTagLevels, level, sizeof(logTagLevels));
+    } else {
+        logTagLevels[tag] = level;
     }
+    return true;
+}
 
-    // Always include the level for consistency
-    snprintf(fullMessage, sizeof(fullMessage), "[%s:%s] %s", tag, levelStr, message);
+// Pragi so v NVS shranjeni po imenu ("Sensors=2,DS=1"), da preživijo spremembe tabele tagov
+void loadLogTagLevels(void) {
+    if (!useNVS) return;
+    Preferences prefs;
+    if (!prefs.begin("logcfg", true)) return;
+    String levels = prefs.getString("levels", "");
+    prefs.end();
 
-    // Use the existing logEvent function to handle the rest
-    logEvent(fullMessage);
+    int start = 0;
+    while (start < (int)levels.length()) {
+        int end = levels.indexOf(',', start);
+        if (end < 0) end = levels.length();
+        int eq = levels.indexOf('=', start);
+        if (eq > start && eq < end) {
+            String name = levels.substring(start, eq);
+            uint8_t tag = logTagId(name.c_str());
+            if (tag != LOG_TAG_OTHER || name == logTagNames[LOG_TAG_OTHER]) setLogTagLevel(tag, levels.substring(eq + 1, end).toInt());
+        }
+        start = end + 1;
+    }
+}
+
+void saveLogTagLevels(void) {
+    if (!useNVS) return;
+    String levels;
+    for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+        if (logTagLevels[i] == LOG_LEVEL_DEBUG) continue;
+        if (levels.length()) levels += ',';
+        levels += logTagNames[i];
+        levels += '=';
+        levels += logTagLevels[i];
+    }
+    Preferences prefs;
+    prefs.begin("logcfg", false);
+    prefs.putString("levels", levels);
+    prefs.end();
 }
 
 void initLogging(void) {
-    logBuffer.clear();
+    if (!logRingInit(LOG_RING_SIZE, LOG_RING_SIZE_NO_PSRAM)) {
+        Serial.println("[LOG] ring buffer alokacija neuspešna - samo Serial");
+        return;
+    }
+    for (int i = 0; i < LOG_CONSUMER_COUNT; i++) {
+        logRingCursorAtOldest(consumerCursors[i]);
+    }
     loggingInitialized = true;
     lastLogFlush = millis();
+    loadLogTagLevels();
+
+    // Nizka prioriteta na jedru 0 - kontrolna zanka (jedro 1) ne čaka na UART
+    if (xTaskCreatePinnedToCore(logSerialTask, "logserial", 4096, NULL, 1, &serialTask, 0) != pdPASS) {
+        serialTask = NULL;
+        LOG_ERROR("LOG", "Serial log task ni bil ustvarjen - izpis sinhrono");
+    }
+
+    LogRingStats stats;
+    logRingGetStats(stats);
+    LOG_INFO("LOG", "Ring buffer: %lu B v %s", (unsigned long)stats.capacity, stats.psram ? "PSRAM" : "notranjem RAM-u");
 }
 
 void flushLogBuffer(void) {
     if (!loggingInitialized) return;
+    emitLogLimitSummaries(millis());   // povzetki ponovitev tudi ko ni novih zapisov
 
-    size_t len = logBuffer.length();
+    size_t len = getLogPendingBytes(LOG_CONSUMER_REW);
     float pct = (len * 100.0f) / LOG_THRESHOLD_IDLE;
-
-    // Static tracking za zaporedne neuspehe
-    static int consecutiveFailures = 0;
-    static unsigned long lastFailureTime = 0;
+    LogShipStats ship;
+    getLogShipStats(ship);
 
     if (len == 0) {
         LOG_DEBUG("LOG", "buffer: prazen");
@@ -71,18 +392,18 @@ void flushLogBuffer(void) {
         return;
     }
 
-    // Dosežen MAX — pošlji v vsakem primeru (OOM zaščita že implementirana)
+    if (ship.busy) {
+        LOG_INFO("LOG", "buffer: %d B (%.0f%%) — pošiljanje že teče", (int)len, pct);
+        lastLogFlush = millis();
+        return;
+    }
+
+    // Dosežen MAX — pošlji v vsakem primeru; ob neuspehu ring sam prepisuje najstarejše
     if (len >= LOG_BUFFER_MAX) {
         float pctMax = (len * 100.0f) / LOG_BUFFER_MAX;
         LOG_WARN("LOG", "buffer MAX: %d B (%.0f%%) — pošiljam v vsakem primeru", (int)len, pctMax);
-        bool success = sendLogsToREW();
-        if (success) {
-            consecutiveFailures = 0;  // Reset counter
-        } else {
-            consecutiveFailures++;
-            lastFailureTime = millis();
-            LOG_ERROR("LOG", "buffer MAX: pošiljanje neuspešno (fail #%d) — buffer izbrisan (OOM zaščita)", consecutiveFailures);
-            logBuffer.clear();
+        if (!requestLogShipping()) {
+            LOG_ERROR("LOG", "buffer MAX: log shipping ni na voljo — najstarejši zapisi se prepisujejo");
         }
         lastLogFlush = millis();
         return;
@@ -92,26 +413,7 @@ void flushLogBuffer(void) {
     if (len >= LOG_THRESHOLD_IDLE) {
         if (isIdle()) {
             LOG_INFO("LOG", "buffer: %d B (%.0f%%) idle=DA — pošiljam", (int)len, pct);
-            bool success = sendLogsToREW();
-            
-            // Track success/failure
-            if (success) {
-                if (consecutiveFailures > 0) {
-                    LOG_INFO("LOG", "Recovery: logs successfully sent after %d failures", consecutiveFailures);
-                }
-                consecutiveFailures = 0;
-            } else {
-                consecutiveFailures++;
-                lastFailureTime = millis();
-                LOG_WARN("HTTP", "Log send failed (fail #%d) - buffer %.1f kB retained, will retry", 
-                         consecutiveFailures, len / 1024.0);
-                
-                // Če dolgotrajno failajo (5+), zmanjšaj agresivnost log-anja
-                if (consecutiveFailures >= 5) {
-                    LOG_ERROR("HTTP", "Persistent log failures (%d consecutive) - REW connectivity issue?", 
-                              consecutiveFailures);
-                }
-            }
+            requestLogShipping();
         } else {
             LOG_INFO("LOG", "buffer: %d B (%.0f%%) idle=NE (wc=%d bat=%d ut=%d luc=%d/%d/%d/%d) — čakam",
                      (int)len, pct,
@@ -128,8 +430,9 @@ void flushLogBuffer(void) {
     }
 
     // Pod pragom — status z info o consecutive failures če obstajajo
-    if (consecutiveFailures > 0) {
-        LOG_INFO("LOG", "buffer: %d B (%.0f%%) - %d consecutive failures", (int)len, pct, consecutiveFailures);
+    if (ship.consecutiveFailures > 0) {
+        LOG_INFO("LOG", "buffer: %d B (%.0f%%) - %lu consecutive failures (HTTP %d)",
+                 (int)len, pct, (unsigned long)ship.consecutiveFailures, ship.lastHttpCode);
     } else {
         LOG_INFO("LOG", "buffer: %d B (%.0f%%)", (int)len, pct);
     }
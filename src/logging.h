@@ -1,7 +1,10 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
+#include <Arduino.h>
 #include <stdarg.h>
+#include "logring.h"
+#include "config.h"
 
 // Log level constants
 enum LogLevel {
@@ -11,16 +14,122 @@ enum LogLevel {
     LOG_LEVEL_ERROR = 3
 };
 
+// Bit v nivoju zapisa: payload je naslov formata + argumenti (logfmt.h)
+#define LOG_LEVEL_DEFERRED_FLAG 0x80
+
+// Največja dolžina vrstice "ts|CEE|[tag:LEVEL] besedilo\n"
+#define LOG_LINE_MAX (LOG_RING_MSG_MAX + 48)
+
+// Tabela tagov - v ringu se hrani samo id (1 B). CEE = stari logEvent(message)
+// brez nivoja, OTHER = tag ni v tabeli (ime se ohrani v besedilu zapisa).
+#define LOG_TAG_LIST(X)        \
+    X(CEE,      "CEE")         \
+    X(OTHER,    "?")           \
+    X(LOG,      "LOG")         \
+    X(SYSTEM,   "System")      \
+    X(ETH,      "ETH")         \
+    X(NTP,      "NTP")         \
+    X(SD,       "SD")          \
+    X(HTTP,     "HTTP")        \
+    X(WEB,      "Web")         \
+    X(OTA,      "OTA")         \
+    X(SETTINGS, "Settings")    \
+    X(SENSORS,  "Sensors")     \
+    X(I2C,      "I2C")         \
+    X(SHT41,    "SHT41")       \
+    X(BME280,   "BME280")      \
+    X(SUPPLY,   "Supply")      \
+    X(INPUTS,   "Inputs")      \
+    X(ENERGY,   "Energy")      \
+    X(DS,       "DS")          \
+    X(DS_VENT,  "DS Vent")     \
+    X(HEXDUMP,  "Hexdump")
+
+enum LogTagId : uint8_t {
+#define LOG_TAG_ENUM(id, name) LOG_TAG_##id,
+    LOG_TAG_LIST(LOG_TAG_ENUM)
+#undef LOG_TAG_ENUM
+    LOG_TAG_COUNT
+};
+
+// Neodvisni porabniki ringa z lastnim kazalcem (web bere s sprotnim kazalcem)
+enum LogConsumer {
+    LOG_CONSUMER_SERIAL = 0,
+    LOG_CONSUMER_REW,
+    LOG_CONSUMER_SD,
+    LOG_CONSUMER_COUNT
+};
+
+// Tag id iz literala v času prevajanja (neznan tag -> LOG_TAG_OTHER)
+constexpr bool logTagEq(const char* a, const char* b) {
+    return *a == *b && (*a == '\0' || logTagEq(a + 1, b + 1));
+}
+
+constexpr uint8_t logTagIdOf(const char* tag) {
+    return
+#define LOG_TAG_MATCH(id, name) logTagEq(tag, name) ? (uint8_t)LOG_TAG_##id :
+        LOG_TAG_LIST(LOG_TAG_MATCH)
+#undef LOG_TAG_MATCH
+        (uint8_t)LOG_TAG_OTHER;
+}
+
+// Najnižji zapisani nivo po tagu (runtime, shranjeno v NVS "logcfg")
+extern uint8_t logTagLevels[LOG_TAG_COUNT];
+
+// Izpis ringa na Serial (logserial task)
+struct LogSerialStats {
+    uint32_t records;          // izpisani zapisi
+    uint32_t dropped;          // prepisani preden jih je task izpisal
+    uint32_t lagged;           // izpisani več kot LOG_SERIAL_LAG_MS po začetku praznjenja
+    uint32_t pendingRecords;   // trenutno čakajo na izpis
+    size_t maxBacklogBytes;    // največji zaostanek ob prebujenju taska
+};
+
 void logEvent(const char* message);
 void logEvent(LogLevel level, const char* tag, const char* format, ...);
+void logEventTagged(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...);
+void logEventDeferred(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...);
 void initLogging(void);
 void flushLogBuffer(void);
-bool sendLogsToREW(void);
+
+bool setLogTagLevel(uint8_t tag, uint8_t level);
+void loadLogTagLevels(void);
+void saveLogTagLevels(void);
+
+const char* logLevelName(uint8_t level);
+const char* logTagName(uint8_t tag);
+uint8_t logTagId(const char* tag);
+bool readLogEntry(LogCursor& cursor, LogEntry& entry);
+void renderLogEntry(LogEntry& entry);
+size_t formatLogEntry(const LogEntry& entry, char* buf, size_t size);
+size_t formatLogLine(const LogEntry& entry, char* buf, size_t size);
+void getLogCursor(LogConsumer consumer, LogCursor& cursor);
+void commitLogCursor(LogConsumer consumer, const LogCursor& cursor);
+size_t getLogPendingBytes(LogConsumer consumer);
+void getLogSerialStats(LogSerialStats& stats);
 
 // Convenience macros for common logging patterns
-#define LOG_INFO(tag, format, ...) logEvent((LogLevel)LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
-#define LOG_WARN(tag, format, ...) logEvent((LogLevel)LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
-#define LOG_ERROR(tag, format, ...) logEvent((LogLevel)LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
-#define LOG_DEBUG(tag, format, ...) logEvent((LogLevel)LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+// Z LOG_DEFERRED_FORMAT se format ne oblikuje ob klicu; "" format "" zagotovi,
+// da je format literal (naslov mora ostati veljaven do branja zapisa).
+#if LOG_DEFERRED_FORMAT
+#define LOG_EVENT_FN(level, tagId, tag, format, ...) logEventDeferred((LogLevel)level, tagId, tag, "" format "", ##__VA_ARGS__)
+#else
+#define LOG_EVENT_FN(level, tagId, tag, format, ...) logEventTagged((LogLevel)level, tagId, tag, format, ##__VA_ARGS__)
+#endif
+
+// Nivo pod LOG_MIN_LEVEL prevajalnik odstrani v celoti; sicer klic stane
+// eno primerjavo s pragom taga, argumenti se ovrednotijo šele nad pragom.
+#define LOG_AT(level, tag, format, ...) do {                                   \
+    if ((level) >= LOG_MIN_LEVEL) {                                            \
+        constexpr uint8_t logTagId_ = logTagIdOf(tag);                         \
+        if ((level) >= logTagLevels[logTagId_])                                \
+            LOG_EVENT_FN(level, logTagId_, tag, format, ##__VA_ARGS__);        \
+    }                                                                          \
+} while (0)
+
+#define LOG_INFO(tag, format, ...) LOG_AT(LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define LOG_WARN(tag, format, ...) LOG_AT(LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define LOG_ERROR(tag, format, ...) LOG_AT(LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, format, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,178 @@
+// loglimit.cpp - Repeat suppression and per-tag rate limiting for CEE logs
+
+#include "loglimit.h"
+#include "config.h"
+#include "logging.h"
+
+#define LOG_REPEAT_TEXT_MAX 64
+
+struct LogRepeatSlot {
+    uint32_t key;               // 0 = prost
+    unsigned long firstMs;      // začetek intervala (zadnji izpisan zapis)
+    uint16_t suppressed;
+    uint8_t level;
+    uint8_t tag;
+    char text[LOG_REPEAT_TEXT_MAX];
+};
+
+struct LogRateBucket {
+    int32_t tokens;             // razpoložljivi bajti
+    unsigned long lastRefill;
+    uint32_t dropped;           // zavrženi od zadnjega povzetka
+    uint32_t droppedBytes;
+};
+
+static LogRepeatSlot repeatSlots[LOG_REPEAT_SLOTS];
+static LogRateBucket rateBuckets[LOG_TAG_COUNT];
+static bool bucketsReady = false;
+static uint16_t pendingSummaries = 0;   // sloti s ponovitvami + bucketi z izgubami
+static LogLimitStats limitStats = {};
+static portMUX_TYPE limitMux = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t logLimitSiteKey(uint8_t tag, const void* site) {
+    uint32_t key = ((uint32_t)(uintptr_t)site * 2654435761u) ^ tag;
+    return key ? key : 1;
+}
+
+// FNV-1a
+uint32_t logLimitTextKey(uint8_t tag, const char* text) {
+    uint32_t h = 2166136261u ^ tag;
+    while (*text) {
+        h ^= (uint8_t)*text++;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+uint32_t logLimitPayloadKey(uint8_t tag, const uint8_t* payload, size_t length) {
+    uint32_t h = 2166136261u ^ tag;
+    for (size_t i = 0; i < length; i++) {
+        h ^= payload[i];
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static void refillBucket(LogRateBucket& bucket, unsigned long now) {
+    uint32_t elapsed = now - bucket.lastRefill;
+    if (elapsed == 0) return;
+    uint64_t add = (uint64_t)elapsed * LOG_TAG_BYTES_PER_MIN / 60000UL;
+    if (add == 0) return;          // lastRefill ostane - drobni intervali se seštevajo
+    bucket.lastRefill = now;
+    int64_t tokens = bucket.tokens + add;
+    bucket.tokens = tokens > LOG_TAG_BYTES_PER_MIN ? LOG_TAG_BYTES_PER_MIN : tokens;
+}
+
+bool logLimitAdmit(uint8_t level, uint8_t tag, uint32_t key, const char* text, size_t bytes, unsigned long now) {
+    if (level >= LOG_LEVEL_ERROR || tag >= LOG_TAG_COUNT) return true;
+
+    bool admit = true;
+    portENTER_CRITICAL(&limitMux);
+
+    if (!bucketsReady) {
+        for (int i = 0; i < LOG_TAG_COUNT; i++) {
+            rateBuckets[i].tokens = LOG_TAG_BYTES_PER_MIN;
+            rateBuckets[i].lastRefill = now;
+        }
+        bucketsReady = true;
+    }
+
+    LogRepeatSlot& slot = repeatSlots[key % LOG_REPEAT_SLOTS];
+    bool expired = now - slot.firstMs >= LOG_REPEAT_INTERVAL;
+    if (slot.key == key && !expired) {
+        if (slot.suppressed == 0) pendingSummaries++;
+        if (slot.suppressed < UINT16_MAX) slot.suppressed++;
+        limitStats.suppressed++;
+        admit = false;
+    } else if (slot.key == 0 || slot.suppressed == 0 || (slot.key == key && expired)) {
+        // Prost slot, neaktiven tuj ključ ali zapadel lasten ključ brez povzetka
+        if (slot.suppressed > 0) pendingSummaries--;
+        slot.key = key;
+        slot.firstMs = now;
+        slot.suppressed = 0;
+        slot.level = level;
+        slot.tag = tag;
+        strlcpy(slot.text, text, sizeof(slot.text));
+    }
+
+    if (admit) {
+        LogRateBucket& bucket = rateBuckets[tag];
+        refillBucket(bucket, now);
+        if (bucket.tokens < (int32_t)bytes) {
+            if (bucket.dropped == 0) pendingSummaries++;
+            bucket.dropped++;
+            bucket.droppedBytes += bytes;
+            limitStats.rateDropped++;
+            limitStats.rateDroppedBytes += bytes;
+            admit = false;
+        } else {
+            bucket.tokens -= bytes;
+        }
+    }
+
+    portEXIT_CRITICAL(&limitMux);
+    return admit;
+}
+
+void logLimitCharge(uint8_t level, uint8_t tag, int32_t extraBytes) {
+    if (level >= LOG_LEVEL_ERROR || tag >= LOG_TAG_COUNT || extraBytes == 0) return;
+    portENTER_CRITICAL(&limitMux);
+    // Dolg (negativni žetoni) zavrne naslednje zapise taga, dokler se bucket ne napolni
+    int32_t tokens = rateBuckets[tag].tokens - extraBytes;
+    if (tokens < -LOG_TAG_BYTES_PER_MIN) tokens = -LOG_TAG_BYTES_PER_MIN;
+    if (tokens > LOG_TAG_BYTES_PER_MIN) tokens = LOG_TAG_BYTES_PER_MIN;
+    rateBuckets[tag].tokens = tokens;
+    portEXIT_CRITICAL(&limitMux);
+}
+
+bool logLimitNextSummary(char* buf, size_t size, uint8_t& level, uint8_t& tag, unsigned long now) {
+    if (pendingSummaries == 0) return false;
+
+    char text[LOG_REPEAT_TEXT_MAX];
+    uint32_t count = 0, bytes = 0, seconds = 0;
+    bool repeat = false;
+
+    portENTER_CRITICAL(&limitMux);
+    for (int i = 0; i < LOG_REPEAT_SLOTS && count == 0; i++) {
+        LogRepeatSlot& slot = repeatSlots[i];
+        if (slot.suppressed == 0 || now - slot.firstMs < LOG_REPEAT_INTERVAL) continue;
+        count = slot.suppressed;
+        seconds = (now - slot.firstMs) / 1000;
+        level = slot.level;
+        tag = slot.tag;
+        memcpy(text, slot.text, sizeof(text));
+        repeat = true;
+        slot.key = 0;             // naslednji klic istega mesta se spet izpiše
+        slot.suppressed = 0;
+        pendingSummaries--;
+    }
+    for (int i = 0; i < LOG_TAG_COUNT && count == 0; i++) {
+        LogRateBucket& bucket = rateBuckets[i];
+        if (bucket.dropped == 0) continue;
+        refillBucket(bucket, now);
+        if (bucket.tokens < LOG_TAG_BYTES_PER_MIN / 4) continue;
+        count = bucket.dropped;
+        bytes = bucket.droppedBytes;
+        level = LOG_LEVEL_WARN;
+        tag = i;
+        bucket.dropped = 0;
+        bucket.droppedBytes = 0;
+        pendingSummaries--;
+    }
+    portEXIT_CRITICAL(&limitMux);
+
+    if (count == 0) return false;
+    if (repeat) {
+        snprintf(buf, size, "ponovljeno %lu× v %lu s: %s", (unsigned long)count, (unsigned long)seconds, text);
+    } else {
+        snprintf(buf, size, "omejitev %d B/min: zavrženih %lu zapisov (%lu B)",
+                 LOG_TAG_BYTES_PER_MIN, (unsigned long)count, (unsigned long)bytes);
+    }
+    return true;
+}
+
+void logLimitGetStats(LogLimitStats& stats) {
+    portENTER_CRITICAL(&limitMux);
+    stats = limitStats;
+    portEXIT_CRITICAL(&limitMux);
+}
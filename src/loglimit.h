@@ -0,0 +1,42 @@
+// loglimit.h - Repeat suppression and per-tag rate limiting for CEE logs
+//
+// Ponovitve: ključ zapisa je hash taga in surovih argumentov (payload iz
+// logCaptureArgs, ki se začne z naslovom formata) - isto klicno mesto z
+// drugačnimi vrednostmi se ne omejuje. Za format, ki ga logCaptureArgs ne
+// podpira, je ključ tag + naslov formata, za logEvent(message) pa hash
+// besedila. Ponovljen ključ znotraj
+// LOG_REPEAT_INTERVAL se zavrže in prešteje; po izteku intervala se izpiše
+// en povzetek "ponovljeno N×". Tabela je direktno preslikana (LOG_REPEAT_SLOTS);
+// ob trku z drugim aktivnim ključem se novo sporočilo samo ne omejuje.
+//
+// Omejitev hitrosti: token bucket po tagu, LOG_TAG_BYTES_PER_MIN bajtov na
+// minuto z enominutnim burstom. Zavrženi zapisi se povzamejo, ko se bucket
+// dovolj napolni. Nivo ERROR gre vedno skozi.
+
+#ifndef LOGLIMIT_H
+#define LOGLIMIT_H
+
+#include <Arduino.h>
+
+struct LogLimitStats {
+    uint32_t suppressed;        // zavrženih ponovitev
+    uint32_t rateDropped;       // zavrženih zaradi omejitve hitrosti
+    uint32_t rateDroppedBytes;
+};
+
+uint32_t logLimitSiteKey(uint8_t tag, const void* site);
+uint32_t logLimitPayloadKey(uint8_t tag, const uint8_t* payload, size_t length);
+uint32_t logLimitTextKey(uint8_t tag, const char* text);
+
+// false = zapis zavrži; text je kratek opis za povzetek (format ali besedilo).
+// bytes je lahko ocena (dolžina formata) - zapis se oblikuje šele po sprejemu.
+bool logLimitAdmit(uint8_t level, uint8_t tag, uint32_t key, const char* text, size_t bytes, unsigned long now);
+// Popravek ocene po oblikovanju sprejetega zapisa (dejanska - ocenjena dolžina)
+void logLimitCharge(uint8_t level, uint8_t tag, int32_t extraBytes);
+
+// Naslednji zapadli povzetek (ponovitve ali omejitev); false ko jih ni več
+bool logLimitNextSummary(char* buf, size_t size, uint8_t& level, uint8_t& tag, unsigned long now);
+
+void logLimitGetStats(LogLimitStats& stats);
+
+#endif // LOGLIMIT_H
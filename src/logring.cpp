@@ -0,0 +1,259 @@
+// logring.cpp - Binary ring log for CEE
+
+#include "logring.h"
+#include <freertos/FreeRTOS.h>
+
+#define LOG_RECORD_WRAP 0xFFFF   // oznaka: nadaljuj na začetku bufferja
+#define LOG_INDEX_STRIDE 32      // vsak LOG_INDEX_STRIDE-ti seq ima vnos v indeksu zamikov
+
+struct LogRecordHeader {
+    uint16_t length;         // celotna dolžina zapisa (glava + payload + poravnava)
+    uint8_t level;
+    uint8_t tag;
+    uint16_t payloadLength;
+    uint16_t reserved;
+    uint32_t seq;
+    uint32_t timestamp;
+};
+
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t* ring = nullptr;
+static uint32_t ringCapacity = 0;
+static bool ringInPsram = false;
+static uint32_t ringHead = 0;        // naslednji zapis
+static uint32_t ringTail = 0;        // najstarejši zapis (vedno normaliziran)
+static uint32_t ringFirstSeq = 0;    // seq najstarejšega zapisa
+static uint32_t ringNextSeq = 0;     // seq naslednjega zapisa
+static uint32_t ringOverwritten = 0;
+
+// Groba tabela seq -> zamik za seq, deljive z LOG_INDEX_STRIDE. Slotov (potenca 2)
+// je več, kot je v ringu lahko takih zapisov, zato je vnos veljaven, dokler je
+// njegov zapis v ringu; iskanje tako prehodi največ LOG_INDEX_STRIDE - 1 zapisov.
+static uint32_t* ringIndex = nullptr;
+static uint32_t ringIndexSlots = 0;
+
+// Zamik zapisa -> dejanski zamik (preskok na 0 ob oznaki ali premalo prostora za glavo)
+static inline uint32_t normalizeOffset(uint32_t off) {
+    if (off >= ringCapacity || ringCapacity - off < sizeof(LogRecordHeader)) return 0;
+    if (((LogRecordHeader*)(ring + off))->length == LOG_RECORD_WRAP) return 0;
+    return off;
+}
+
+static inline uint32_t recordCount() {
+    return ringNextSeq - ringFirstSeq;
+}
+
+// Zamik zapisa s podanim seq (ringFirstSeq <= seq <= ringNextSeq): hoja od
+// najbližjega vnosa v indeksu (ali od repa, če ta zapis ni več v ringu)
+static uint32_t offsetOfSeq(uint32_t seq) {
+    if (seq == ringNextSeq) return ringHead;
+    uint32_t s = ringFirstSeq;
+    uint32_t off = ringTail;
+    uint32_t base = seq - seq % LOG_INDEX_STRIDE;
+    if (ringIndex && (int32_t)(base - ringFirstSeq) > 0) {
+        s = base;
+        off = ringIndex[(base / LOG_INDEX_STRIDE) & (ringIndexSlots - 1)];
+    }
+    for (; s != seq; s++) {
+        off = normalizeOffset(off);
+        off += ((const LogRecordHeader*)(ring + off))->length;
+    }
+    return normalizeOffset(off);
+}
+
+// Normaliziran zamik kazalca, ki je v ringu. Kazalec na koncu bufferja (za
+// oznako LOG_RECORD_WRAP) postane neveljaven, ko pisec v naslednjem krogu
+// prepiše to mesto, še preden izrine zapis cursor.seq na začetku - glava na
+// zamiku se mora ujemati s seq, sicer se zamik poišče znova od repa.
+static uint32_t cursorOffset(const LogCursor& cursor) {
+    uint32_t off = normalizeOffset(cursor.offset);
+    if (((const LogRecordHeader*)(ring + off))->seq == cursor.seq) return off;
+    return offsetOfSeq(cursor.seq);
+}
+
+static void evictOldest() {
+    LogRecordHeader* hdr = (LogRecordHeader*)(ring + ringTail);
+    ringTail += hdr->length;
+    ringFirstSeq++;
+    ringOverwritten++;
+    if (recordCount() > 0) ringTail = normalizeOffset(ringTail);
+}
+
+bool logRingInit(size_t capacity, size_t fallbackCapacity) {
+    if (ring) return true;
+
+    capacity &= ~3u;
+    fallbackCapacity &= ~3u;
+    uint8_t* buf = nullptr;
+    if (psramFound()) {
+        buf = (uint8_t*)ps_malloc(capacity);
+        ringInPsram = buf != nullptr;
+    }
+    if (!buf) {
+        capacity = fallbackCapacity;
+        buf = (uint8_t*)malloc(capacity);
+    }
+    if (!buf) return false;
+
+    // Najmanjši zapis je sama glava; brez indeksa offsetOfSeq hodi od repa
+    uint32_t slots = 1;
+    while (slots * LOG_INDEX_STRIDE * sizeof(LogRecordHeader) <= capacity) slots <<= 1;
+    uint32_t* index = (uint32_t*)malloc(slots * sizeof(uint32_t));
+
+    portENTER_CRITICAL(&ringMux);
+    ring = buf;
+    ringIndex = index;
+    ringIndexSlots = index ? slots : 0;
+    ringCapacity = capacity;
+    ringHead = ringTail = 0;
+    ringFirstSeq = ringNextSeq = 0;
+    ringOverwritten = 0;
+    portEXIT_CRITICAL(&ringMux);
+    return true;
+}
+
+bool logRingReady() {
+    return ring != nullptr;
+}
+
+void logRingAppend(uint32_t timestamp, uint8_t level, uint8_t tag, const void* payload, size_t length) {
+    if (!ring) return;
+    if (length > LOG_RING_MSG_MAX - 1) length = LOG_RING_MSG_MAX - 1;
+    uint32_t need = (sizeof(LogRecordHeader) + length + 3) & ~3u;
+
+    portENTER_CRITICAL(&ringMux);
+    uint32_t pos = ringHead;
+    if (ringCapacity - pos < need) {
+        // Zapis ne gre do konca - sprosti rep za pos in nadaljuj na začetku
+        while (recordCount() > 0 && ringTail >= pos) evictOldest();
+        if (ringCapacity - pos >= sizeof(LogRecordHeader)) {
+            ((LogRecordHeader*)(ring + pos))->length = LOG_RECORD_WRAP;
+        }
+        pos = 0;
+    }
+    while (recordCount() > 0 && ringTail >= pos && ringTail < pos + need) evictOldest();
+    if (recordCount() == 0) ringTail = pos;
+
+    LogRecordHeader* hdr = (LogRecordHeader*)(ring + pos);
+    hdr->length = need;
+    hdr->level = level;
+    hdr->tag = tag;
+    hdr->payloadLength = length;
+    hdr->reserved = 0;
+    hdr->seq = ringNextSeq;
+    hdr->timestamp = timestamp;
+    memcpy(hdr + 1, payload, length);
+    if (ringIndex && ringNextSeq % LOG_INDEX_STRIDE == 0) {
+        ringIndex[(ringNextSeq / LOG_INDEX_STRIDE) & (ringIndexSlots - 1)] = pos;
+    }
+
+    ringHead = pos + need;
+    ringNextSeq++;
+    portEXIT_CRITICAL(&ringMux);
+}
+
+void logRingCursorAtOldest(LogCursor& cursor) {
+    portENTER_CRITICAL(&ringMux);
+    cursor.seq = ringFirstSeq;
+    cursor.offset = ringTail;
+    cursor.dropped = 0;
+    portEXIT_CRITICAL(&ringMux);
+}
+
+void logRingCursorAtNewest(LogCursor& cursor) {
+    portENTER_CRITICAL(&ringMux);
+    cursor.seq = ringNextSeq;
+    cursor.offset = ringHead;
+    cursor.dropped = 0;
+    portEXIT_CRITICAL(&ringMux);
+}
+
+// Postavi kazalec na zapis s podanim seq (omejeno na zapise v ringu).
+// cursor.dropped se ohrani; že prepisani zapisi od seq naprej se prištejejo.
+void logRingSeek(LogCursor& cursor, uint32_t seq) {
+    portENTER_CRITICAL(&ringMux);
+    if ((int32_t)(seq - ringFirstSeq) < 0) cursor.dropped += ringFirstSeq - seq;
+    if ((int32_t)(seq - ringFirstSeq) <= 0) {
+        cursor.seq = ringFirstSeq;
+        cursor.offset = ringTail;
+    } else if ((int32_t)(seq - ringNextSeq) >= 0) {
+        cursor.seq = ringNextSeq;
+        cursor.offset = ringHead;
+    } else {
+        cursor.seq = seq;
+        cursor.offset = offsetOfSeq(seq);
+    }
+    portEXIT_CRITICAL(&ringMux);
+}
+
+// Prebere naslednji zapis za porabnika; false, če ni novih zapisov
+bool logRingRead(LogCursor& cursor, LogEntry& out) {
+    if (!ring) return false;
+
+    portENTER_CRITICAL(&ringMux);
+    if (cursor.seq == ringNextSeq) {
+        portEXIT_CRITICAL(&ringMux);
+        return false;
+    }
+    if ((int32_t)(cursor.seq - ringFirstSeq) < 0 || (int32_t)(cursor.seq - ringNextSeq) > 0) {
+        // Porabnik je zaostal za prepisanimi zapisi - nadaljuj pri najstarejšem
+        if ((int32_t)(cursor.seq - ringFirstSeq) < 0) cursor.dropped += ringFirstSeq - cursor.seq;
+        cursor.seq = ringFirstSeq;
+        cursor.offset = ringTail;
+    }
+
+    uint32_t off = cursorOffset(cursor);
+    const LogRecordHeader* hdr = (const LogRecordHeader*)(ring + off);
+    size_t len = hdr->payloadLength;
+    if (len > LOG_RING_MSG_MAX - 1) len = LOG_RING_MSG_MAX - 1;
+    out.seq = hdr->seq;
+    out.timestamp = hdr->timestamp;
+    out.level = hdr->level;
+    out.tag = hdr->tag;
+    out.length = len;
+    memcpy(out.text, hdr + 1, len);
+    out.text[len] = '\0';
+
+    cursor.offset = off + hdr->length;
+    cursor.seq++;
+    portEXIT_CRITICAL(&ringMux);
+    return true;
+}
+
+// Približno število bajtov, ki jih porabnik še ni prebral
+size_t logRingPendingBytes(const LogCursor& cursor) {
+    if (!ring) return 0;
+
+    portENTER_CRITICAL(&ringMux);
+    size_t pending = 0;
+    if (cursor.seq != ringNextSeq) {
+        bool lost = (int32_t)(cursor.seq - ringFirstSeq) < 0 || (int32_t)(cursor.seq - ringNextSeq) > 0;
+        uint32_t off = lost ? ringTail : cursorOffset(cursor);
+        pending = ringHead > off ? ringHead - off : ringCapacity - off + ringHead;
+    }
+    portEXIT_CRITICAL(&ringMux);
+    return pending;
+}
+
+uint32_t logRingPendingRecords(const LogCursor& cursor) {
+    portENTER_CRITICAL(&ringMux);
+    uint32_t pending;
+    if ((int32_t)(cursor.seq - ringFirstSeq) < 0) pending = recordCount();
+    else pending = ringNextSeq - cursor.seq;
+    portEXIT_CRITICAL(&ringMux);
+    return pending;
+}
+
+void logRingGetStats(LogRingStats& stats) {
+    portENTER_CRITICAL(&ringMux);
+    stats.capacity = ringCapacity;
+    stats.records = recordCount();
+    if (stats.records == 0) stats.used = 0;
+    else stats.used = ringHead > ringTail ? ringHead - ringTail : ringCapacity - ringTail + ringHead;
+    stats.firstSeq = ringFirstSeq;
+    stats.nextSeq = ringNextSeq;
+    stats.overwritten = ringOverwritten;
+    stats.psram = ringInPsram;
+    portEXIT_CRITICAL(&ringMux);
+}
@@ -0,0 +1,53 @@
+// logring.h - Binary ring log for CEE
+//
+// Prealociran krožni buffer (PSRAM) zapisov z dolžinsko predpono:
+// [dolžina][nivo][tag id][dolžina payloada][seq][timestamp][payload] poravnano
+// na 4 B. Payload je besedilo ali binarni zapis (glej logfmt.h).
+// Pisanje je O(1) brez alokacij, najstarejši zapisi se prepišejo.
+// Vsak porabnik (serial, web, REW) bere s svojim LogCursor.
+
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <Arduino.h>
+
+#define LOG_RING_MSG_MAX 256     // največja dolžina payloada zapisa (z \0)
+
+// Pozicija porabnika v ringu; seq = naslednji zapis za branje
+struct LogCursor {
+    uint32_t seq;
+    uint32_t offset;
+    uint32_t dropped;    // zapisi, prepisani preden jih je porabnik prebral
+};
+
+struct LogEntry {
+    uint32_t seq;
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t tag;
+    uint16_t length;     // dolžina payloada (besedilo brez \0)
+    char text[LOG_RING_MSG_MAX];   // payload + \0
+};
+
+struct LogRingStats {
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t records;
+    uint32_t firstSeq;
+    uint32_t nextSeq;
+    uint32_t overwritten;
+    bool psram;
+};
+
+bool logRingInit(size_t capacity, size_t fallbackCapacity);
+bool logRingReady();
+void logRingAppend(uint32_t timestamp, uint8_t level, uint8_t tag, const void* payload, size_t length);
+void logRingCursorAtOldest(LogCursor& cursor);
+void logRingCursorAtNewest(LogCursor& cursor);
+void logRingSeek(LogCursor& cursor, uint32_t seq);
+bool logRingRead(LogCursor& cursor, LogEntry& out);
+size_t logRingPendingBytes(const LogCursor& cursor);
+uint32_t logRingPendingRecords(const LogCursor& cursor);
+void logRingGetStats(LogRingStats& stats);
+
+#endif // LOGRING_H
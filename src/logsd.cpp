@@ -0,0 +1,821 @@
+// logsd.cpp - Persistent log sink on SD card for CEE
+
+#include "logsd.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "globals.h"
+#include "logging.h"
+#include "sd.h"
+
+#define LOG_SD_SECTOR 512
+#define LOG_SD_DATA_CAPACITY (LOG_SD_FILE_SIZE - LOG_SD_FOOTER_SIZE)
+#define LOG_SD_RETRY_MS 60000
+
+static bool fileOpen = false;
+static char filePath[32] = "";
+static uint32_t fileDay = 0;
+static uint32_t fileFirstSector = 0;
+static uint32_t dataOffset = 0;          // zapisano na kartico (poravnano na sektor)
+static uint32_t lastIndexOffset = 0;
+static unsigned long lastSectorWrite = 0;
+static unsigned long retryAfter = 0;
+
+static uint8_t staging[LOG_SD_STAGING_SIZE] __attribute__((aligned(4)));
+static size_t stagingLen = 0;
+static LogSdFooter footer;               // živ povzetek in indeks odprte datoteke
+
+static uint32_t bytesWritten = 0;
+static uint32_t filesCreated = 0;
+static uint32_t writeErrors = 0;
+static uint32_t totalDropped = 0;
+
+static portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t queryTask = NULL;
+static void logQueryTask(void* param);
+static void getQueryStatus(SdLogStatus& status);
+
+// Lokalni čas, ki ga nastavlja glavna zanka (sdLogService) - ezTime ni varen
+// za klic iz SD taska; 0 = čas še ni sinhroniziran
+static volatile uint32_t loopLocalTime = 0;
+
+// Datum (YYYYMMDD) iz ts; ts je lokalni čas (myTZ.now()), kot ime datoteke
+static uint32_t logDayOf(uint32_t ts) {
+    int32_t z = ts / 86400 + 719468;
+    int32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t y = yoe + era * 400 + (m <= 2);
+    return y * 10000 + m * 100 + d;
+}
+
+// Datum iz enega posnetka časa - ločeni klici year()/month()/day() bi ob
+// polnoči lahko sestavili dva različna dneva
+static uint32_t currentLogDay() {
+    uint32_t now = loopLocalTime;
+    return now ? logDayOf(now) : 0;
+}
+
+static bool writeFileSectors(uint32_t offset, const uint8_t* buf, size_t count) {
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(5000)) != pdTRUE) return false;
+    bool ok = SD.card()->writeSectors(fileFirstSector + offset / LOG_SD_SECTOR, buf, count);
+    xSemaphoreGive(sdMutex);
+    return ok;
+}
+
+static void abandonFile(const char* reason) {
+    writeErrors++;
+    LOG_ERROR("SD", "Log datoteka %s: %s - ponovni poskus čez %d s", filePath, reason, LOG_SD_RETRY_MS / 1000);
+    portENTER_CRITICAL(&statusMux);
+    fileOpen = false;
+    portEXIT_CRITICAL(&statusMux);
+    stagingLen = 0;
+    retryAfter = millis() + LOG_SD_RETRY_MS;
+}
+
+// Zapiše vse cele sektorje iz staginga, ostanek premakne na začetek
+static bool flushFullSectors() {
+    size_t n = (stagingLen / LOG_SD_SECTOR) * LOG_SD_SECTOR;
+    if (n == 0) return true;
+    if (!writeFileSectors(dataOffset, staging, n / LOG_SD_SECTOR)) {
+        abandonFile("napaka pisanja");
+        return false;
+    }
+    memmove(staging, staging + n, stagingLen - n);
+    stagingLen -= n;
+    bytesWritten += n;
+    lastSectorWrite = millis();
+    portENTER_CRITICAL(&statusMux);
+    dataOffset += n;
+    portEXIT_CRITICAL(&statusMux);
+    return true;
+}
+
+// Dopolni nepopoln sektor s presledki in '\n' ter ga zapiše
+static bool padAndFlush() {
+    size_t rem = stagingLen % LOG_SD_SECTOR;
+    if (rem != 0) {
+        size_t pad = LOG_SD_SECTOR - rem;
+        memset(staging + stagingLen, ' ', pad - 1);
+        staging[stagingLen + pad - 1] = '\n';
+        stagingLen += pad;
+    }
+    return flushFullSectors();
+}
+
+static void pruneOldFiles() {
+    for (;;) {
+        FsFile dir;
+        if (!dir.open(LOG_SD_DIR, O_RDONLY)) return;
+
+        FsFile entry;
+        char name[32];
+        char oldest[32] = "";
+        uint16_t count = 0;
+        while (entry.openNext(&dir, O_RDONLY)) {
+            if (!entry.isDir() && entry.getName(name, sizeof(name)) && strstr(name, ".log")) {
+                count++;
+                if (!oldest[0] || strcmp(name, oldest) < 0) strcpy(oldest, name);
+            }
+            entry.close();
+        }
+        dir.close();
+
+        if (count < LOG_SD_MAX_FILES || !oldest[0]) return;
+        char path[48];
+        snprintf(path, sizeof(path), "%s/%s", LOG_SD_DIR, oldest);
+        if (!SD.remove(path)) return;
+        LOG_INFO("SD", "Izbrisana stara log datoteka %s", path);
+    }
+}
+
+static bool openLogFile(uint32_t day) {
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(5000)) != pdTRUE) return false;
+
+    if (!SD.exists(LOG_SD_DIR)) SD.mkdir(LOG_SD_DIR);
+    pruneOldFiles();
+
+    char path[32];
+    bool found = false;
+    for (uint8_t n = 0; n < 100 && !found; n++) {
+        snprintf(path, sizeof(path), "%s/%08lu_%02u.log", LOG_SD_DIR, (unsigned long)day, n);
+        found = !SD.exists(path);
+    }
+
+    // Prealokacija zveznega bloka - edina sprememba FAT za to datoteko
+    FsFile file;
+    uint32_t firstSector = 0, lastSector = 0;
+    bool ok = found && file.open(path, O_RDWR | O_CREAT | O_EXCL);
+    if (ok && !file.preAllocate(LOG_SD_FILE_SIZE)) {
+        file.close();
+        SD.remove(path);
+        ok = false;
+    }
+    if (ok) {
+        ok = file.contiguousRange(&firstSector, &lastSector);
+        file.close();
+    }
+    if (ok) {
+        // Neuporabljen del bere kot 0x00/0xFF - konec podatkov je viden tudi brez footerja
+        SD.card()->erase(firstSector, firstSector + LOG_SD_FILE_SIZE / LOG_SD_SECTOR - 1);
+    }
+    xSemaphoreGive(sdMutex);
+
+    if (!ok) {
+        writeErrors++;
+        LOG_ERROR("SD", "Prealokacija log datoteke %s ni uspela", found ? path : LOG_SD_DIR);
+        retryAfter = millis() + LOG_SD_RETRY_MS;
+        return false;
+    }
+
+    memset(&footer, 0, sizeof(footer));
+    memcpy(footer.magic, LOG_SD_FOOTER_MAGIC, sizeof(footer.magic));
+    stagingLen = 0;
+    lastIndexOffset = 0;
+    lastSectorWrite = millis();
+    filesCreated++;
+
+    portENTER_CRITICAL(&statusMux);
+    strlcpy(filePath, path, sizeof(filePath));
+    fileDay = day;
+    fileFirstSector = firstSector;
+    dataOffset = 0;
+    fileOpen = true;
+    portEXIT_CRITICAL(&statusMux);
+
+    LOG_INFO("SD", "Log datoteka %s (%lu kB prealocirano)", path, (unsigned long)(LOG_SD_FILE_SIZE / 1024));
+    return true;
+}
+
+// Dopolni zadnji sektor in zapiše footer na fiksno mesto na koncu datoteke
+static void closeLogFile(LogSdCloseReason reason) {
+    if (!fileOpen) return;
+    if (!padAndFlush()) return;
+
+    footer.dataBytes = dataOffset;
+    footer.closeReason = reason;
+    memset(staging, 0, LOG_SD_FOOTER_SIZE);
+    memcpy(staging, &footer, sizeof(footer));
+    if (!writeFileSectors(LOG_SD_DATA_CAPACITY, staging, LOG_SD_FOOTER_SIZE / LOG_SD_SECTOR)) {
+        abandonFile("napaka pisanja footerja");
+        return;
+    }
+
+    LOG_INFO("SD", "Log datoteka %s zaprta (%s): %lu zapisov, %lu kB",
+             filePath, reason == LOG_SD_CLOSE_DAY ? "dan" : "polna",
+             (unsigned long)footer.records, (unsigned long)(footer.dataBytes / 1024));
+    portENTER_CRITICAL(&statusMux);
+    fileOpen = false;
+    portEXIT_CRITICAL(&statusMux);
+}
+
+// Doda vrstico v staging in posodobi povzetek/indeks
+static void stageLine(const LogEntry& entry, const char* line, size_t len) {
+    uint32_t lineOffset = dataOffset + stagingLen;
+    portENTER_CRITICAL(&statusMux);     // footer bere tudi /api/logs/query
+    if (footer.records == 0 ||
+        (lineOffset - lastIndexOffset >= LOG_SD_INDEX_STRIDE && footer.indexCount < LOG_SD_INDEX_MAX)) {
+        if (footer.indexCount < LOG_SD_INDEX_MAX) {
+            LogSdIndexEntry& idx = footer.index[footer.indexCount++];
+            idx.timestamp = entry.timestamp;
+            idx.seq = entry.seq;
+            idx.offset = lineOffset;
+            lastIndexOffset = lineOffset;
+        }
+    }
+    if (footer.records == 0) {
+        footer.firstSeq = entry.seq;
+        footer.firstTimestamp = entry.timestamp;
+        footer.minTimestamp = footer.maxTimestamp = entry.timestamp;
+    } else if (entry.timestamp > footer.maxTimestamp) {
+        footer.maxTimestamp = entry.timestamp;
+    } else {
+        // Ura je šla nazaj (konec poletnega časa, NTP popravek)
+        if (entry.timestamp < footer.minTimestamp) footer.minTimestamp = entry.timestamp;
+        uint32_t drop = footer.maxTimestamp - entry.timestamp;
+        if (drop > footer.timestampDrop) footer.timestampDrop = drop;
+    }
+    footer.lastSeq = entry.seq;
+    footer.lastTimestamp = entry.timestamp;
+    footer.records++;
+    portEXIT_CRITICAL(&statusMux);
+
+    memcpy(staging + stagingLen, line, len);
+    stagingLen += len;
+}
+
+static bool lineFits(size_t len) {
+    size_t pending = stagingLen + len;
+    size_t rounded = ((pending + LOG_SD_SECTOR - 1) / LOG_SD_SECTOR) * LOG_SD_SECTOR;
+    return dataOffset + rounded <= LOG_SD_DATA_CAPACITY;
+}
+
+static void sdLogTask(void* param) {
+    LogEntry entry;
+    char line[LOG_LINE_MAX];
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(LOG_SD_POLL_MS));
+        if ((long)(millis() - retryAfter) < 0) continue;
+
+        uint32_t today = currentLogDay();
+        if (fileOpen && today != 0 && today != fileDay) closeLogFile(LOG_SD_CLOSE_DAY);
+        if (!fileOpen && !openLogFile(today)) continue;
+
+        LogCursor cursor;
+        getLogCursor(LOG_CONSUMER_SD, cursor);
+        uint32_t droppedBefore = cursor.dropped;
+        LogCursor before = cursor;
+        while (fileOpen && readLogEntry(cursor, entry)) {
+            size_t len = formatLogLine(entry, line, sizeof(line));
+            if (!lineFits(len)) {
+                closeLogFile(LOG_SD_CLOSE_SIZE);
+                if (!fileOpen && !openLogFile(today)) {
+                    cursor = before;   // zapis ostane v ringu za naslednji poskus
+                    break;
+                }
+            }
+            stageLine(entry, line, len);
+            before = cursor;
+            if (stagingLen + LOG_LINE_MAX > LOG_SD_STAGING_SIZE && !flushFullSectors()) break;
+        }
+        if (cursor.dropped != droppedBefore) {
+            footer.dropped += cursor.dropped - droppedBefore;
+            totalDropped += cursor.dropped - droppedBefore;
+        }
+        commitLogCursor(LOG_CONSUMER_SD, cursor);
+
+        if (!fileOpen) continue;
+        if (!flushFullSectors()) continue;
+        if (stagingLen > 0 && millis() - lastSectorWrite >= LOG_SD_PAD_MS) padAndFlush();
+    }
+}
+
+void initSdLog() {
+    if (!isSDReady()) {
+        LOG_WARN("SD", "Ni kartice - log na SD onemogočen");
+        return;
+    }
+    sdLogService();
+    BaseType_t ok = xTaskCreatePinnedToCore(sdLogTask, "sdlog", 6144, NULL, 1, NULL, 0);
+    if (ok != pdPASS) {
+        LOG_ERROR("SD", "Log task ni bil ustvarjen!");
+        return;
+    }
+    if (xTaskCreatePinnedToCore(logQueryTask, "logquery", 4096, NULL, 1, &queryTask, 0) != pdPASS) {
+        queryTask = NULL;
+        LOG_ERROR("SD", "Task za poizvedbe ni bil ustvarjen - /api/logs/query onemogočen");
+    }
+    LOG_INFO("SD", "Log na SD: %lu kB/datoteko, največ %d datotek", (unsigned long)(LOG_SD_FILE_SIZE / 1024), LOG_SD_MAX_FILES);
+}
+
+void sdLogService() {
+    loopLocalTime = timeSynced ? (uint32_t)myTZ.now() : 0;
+}
+
+void getSdLogStatus(SdLogStatus& status) {
+    portENTER_CRITICAL(&statusMux);
+    status.active = fileOpen;
+    strlcpy(status.path, filePath, sizeof(status.path));
+    status.dataBytes = dataOffset;
+    portEXIT_CRITICAL(&statusMux);
+    status.capacity = LOG_SD_DATA_CAPACITY;
+    status.bytesWritten = bytesWritten;
+    status.filesCreated = filesCreated;
+    status.writeErrors = writeErrors;
+    status.dropped = totalDropped;
+    getQueryStatus(status);
+}
+
+// ---- Poizvedba po času ----
+
+#define LOG_SD_QUERY_LOCK_MS 500
+#define LOG_SD_QUERY_SPACE_MS 100          // čakanje na prostor v izhodnem vmesniku
+// ts pod to mejo so sekunde od zagona (vrstice pred NTP, datoteke 00000000_NN)
+#define LOG_SD_UPTIME_TS_MAX 1000000000UL
+
+// Stanje branja (~5 kB); uporablja ga samo logquery task
+struct LogSdQuery {
+    uint32_t from;
+    uint32_t to;
+    uint32_t seekFrom;         // from - timestampDrop tekoče datoteke
+    uint32_t stopAfter;        // to + timestampDrop tekoče datoteke
+    char files[LOG_SD_MAX_FILES][16];
+    uint8_t fileCount;
+    uint8_t fileIndex;
+    bool fileActive;
+    bool failed;
+    uint32_t firstSector;
+    uint32_t dataEnd;
+    uint32_t offset;           // naslednji neprebran bajt datoteke
+    uint16_t bufLen;
+    uint16_t bufPos;
+    uint32_t filesOpened;
+    uint32_t bytesRead;
+    uint32_t waitMs;           // čakanje na prostor v izhodnem vmesniku
+    LogSdFooter footer;
+    uint8_t buf[LOG_SD_QUERY_BUF] __attribute__((aligned(4)));
+    char line[LOG_LINE_MAX];
+};
+
+enum QueryState : uint8_t {
+    QUERY_IDLE = 0,
+    QUERY_PENDING,             // čaka na task
+    QUERY_RUNNING,
+    QUERY_DONE                 // task končal, vmesnik se še prazni
+};
+
+// Izhodni vmesnik: zapisi [ts:4][len:2][besedilo]; head/tail sta naraščajoča števca bajtov.
+// Task piše samo med head in tail+LOG_SD_QUERY_OUT, bralec samo med tail in head.
+static struct {
+    QueryState state;
+    uint32_t id;
+    uint32_t from;
+    uint32_t to;
+    bool cancel;
+    bool failed;
+    uint32_t head;
+    uint32_t tail;
+    uint8_t out[LOG_SD_QUERY_OUT];
+} channel;
+
+static LogSdQuery query;
+static uint32_t nextQueryId = 1;
+static portMUX_TYPE queryMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Meritev zadnje poizvedbe (queryMux)
+static struct {
+    uint32_t window;
+    uint32_t ms;
+    uint32_t readMs;
+    uint32_t firstLineMs;
+    uint32_t bytes;
+    uint32_t files;
+    uint32_t lines;
+} lastQuery;
+
+static void getQueryStatus(SdLogStatus& status) {
+    portENTER_CRITICAL(&queryMux);
+    status.queryWindow = lastQuery.window;
+    status.queryMs = lastQuery.ms;
+    status.queryReadMs = lastQuery.readMs;
+    status.queryFirstLineMs = lastQuery.firstLineMs;
+    status.queryBytes = lastQuery.bytes;
+    status.queryFiles = lastQuery.files;
+    status.queryLines = lastQuery.lines;
+    portEXIT_CRITICAL(&queryMux);
+}
+
+static bool queryCancelled() {
+    portENTER_CRITICAL(&queryMux);
+    bool cancel = channel.cancel;
+    portEXIT_CRITICAL(&queryMux);
+    return cancel;
+}
+
+static bool readQuerySectors(LogSdQuery& q, uint32_t offset, uint8_t* buf, size_t count) {
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(LOG_SD_QUERY_LOCK_MS)) != pdTRUE) return false;
+    bool ok = SD.card()->readSectors(q.firstSector + offset / LOG_SD_SECTOR, buf, count);
+    xSemaphoreGive(sdMutex);
+    if (ok) q.bytesRead += count * LOG_SD_SECTOR;
+    return ok;
+}
+
+// ts na začetku vrstice "ts|CEE|..."; false za polnilo ali poškodovano vrstico
+static bool parseLineTimestamp(const char* p, const char* end, uint32_t& ts) {
+    uint32_t v = 0;
+    const char* start = p;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    if (p == start || p >= end || *p != '|') return false;
+    ts = v;
+    return true;
+}
+
+// Sektor je zapisan, če se ne začne z izbrisano vrednostjo (besedilo ne vsebuje 0x00/0xFF)
+static bool sectorHasData(uint8_t first) {
+    return first != 0x00 && first != 0xFF;
+}
+
+// Konec podatkov datoteke brez footerja (izpad napajanja) - bisekcija po sektorjih
+static bool findDataEnd(LogSdQuery& q) {
+    uint32_t lo = 0, hi = LOG_SD_DATA_CAPACITY / LOG_SD_SECTOR;   // [lo, hi) = neznano
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (!readQuerySectors(q, mid * LOG_SD_SECTOR, q.buf, 1)) return false;
+        if (sectorHasData(q.buf[0])) lo = mid + 1;
+        else hi = mid;
+    }
+    q.dataEnd = lo * LOG_SD_SECTOR;
+    return true;
+}
+
+// Začetek branja pred prvo vrstico s ts >= from: indeks zoži na LOG_SD_INDEX_STRIDE,
+// bisekcija na LOG_SD_QUERY_BUF. Meja je seekFrom - pred vrstico s ts < seekFrom so
+// zaradi omejenega padca vse vrstice starejše od from. lo je vedno začetek vrstice.
+static bool seekQueryStart(LogSdQuery& q) {
+    uint32_t lo = 0, hi = q.dataEnd;
+    for (uint16_t i = 0; i < q.footer.indexCount && i < LOG_SD_INDEX_MAX; i++) {
+        const LogSdIndexEntry& idx = q.footer.index[i];
+        if (idx.offset >= q.dataEnd) break;
+        if (idx.timestamp < q.seekFrom) {
+            lo = idx.offset;
+        } else {
+            hi = idx.offset;
+            break;
+        }
+    }
+
+    while (hi > lo && hi - lo > LOG_SD_QUERY_BUF) {
+        uint32_t mid = ((lo + hi) / 2) & ~(uint32_t)(LOG_SD_SECTOR - 1);
+        if (mid <= lo) break;
+        size_t sectors = (q.dataEnd - mid) / LOG_SD_SECTOR;
+        if (sectors > LOG_SD_QUERY_BUF / LOG_SD_SECTOR) sectors = LOG_SD_QUERY_BUF / LOG_SD_SECTOR;
+        if (sectors == 0 || !readQuerySectors(q, mid, q.buf, sectors)) return false;
+
+        // Prva cela vrstica z veljavnim ts za mid
+        const char* p = (const char*)q.buf;
+        const char* end = p + sectors * LOG_SD_SECTOR;
+        uint32_t ts = 0;
+        bool found = false;
+        while (!found) {
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            if (!nl) break;
+            p = nl + 1;
+            found = parseLineTimestamp(p, end, ts);
+        }
+        if (found && ts < q.seekFrom) lo = mid + (p - (const char*)q.buf);
+        else hi = mid;   // brez ts (polnilo) - začni levo, filter preskoči starejše
+    }
+
+    q.offset = lo;
+    q.bufLen = q.bufPos = 0;
+    return true;
+}
+
+// Naslednja datoteka, ki lahko vsebuje zapise iz [from, to]
+static bool openQueryFile(LogSdQuery& q) {
+    while (q.fileIndex < q.fileCount) {
+        if (queryCancelled()) return false;
+        char path[48];
+        snprintf(path, sizeof(path), "%s/%s", LOG_SD_DIR, q.files[q.fileIndex++]);
+
+        if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(LOG_SD_QUERY_LOCK_MS)) != pdTRUE) {
+            q.failed = true;
+            return false;
+        }
+        FsFile file;
+        uint32_t firstSector = 0, lastSector = 0;
+        bool ok = file.open(path, O_RDONLY) && file.contiguousRange(&firstSector, &lastSector);
+        file.close();
+        xSemaphoreGive(sdMutex);
+        if (!ok) continue;
+        q.firstSector = firstSector;
+        q.filesOpened++;
+
+        // Odprta datoteka: footer je v RAM-u, na kartici je le do dataOffset
+        bool live = false;
+        portENTER_CRITICAL(&statusMux);
+        if (fileOpen && strcmp(path, filePath) == 0) {
+            memcpy(&q.footer, &footer, sizeof(footer));
+            q.dataEnd = dataOffset;
+            live = true;
+        }
+        portEXIT_CRITICAL(&statusMux);
+
+        if (!live) {
+            if (!readQuerySectors(q, LOG_SD_DATA_CAPACITY, q.buf, LOG_SD_FOOTER_SIZE / LOG_SD_SECTOR)) {
+                q.failed = true;
+                return false;
+            }
+            memcpy(&q.footer, q.buf, sizeof(q.footer));
+            if (memcmp(q.footer.magic, LOG_SD_FOOTER_MAGIC, sizeof(q.footer.magic)) == 0) {
+                q.dataEnd = q.footer.dataBytes;
+            } else {
+                // Brez footerja (izpad napajanja, starejši format) padec ts ni znan
+                memset(&q.footer, 0, sizeof(q.footer));
+                q.footer.timestampDrop = UINT32_MAX;
+                if (!findDataEnd(q)) {
+                    q.failed = true;
+                    return false;
+                }
+            }
+        }
+
+        if (q.footer.records > 0 && (q.footer.maxTimestamp < q.from || q.footer.minTimestamp > q.to)) continue;
+        if (q.dataEnd == 0) continue;
+        uint32_t drop = q.footer.timestampDrop;
+        q.seekFrom = q.from > drop ? q.from - drop : 0;
+        q.stopAfter = q.to < UINT32_MAX - drop ? q.to + drop : UINT32_MAX;
+        if (!seekQueryStart(q)) {
+            q.failed = true;
+            return false;
+        }
+        q.fileActive = true;
+        return true;
+    }
+    return false;
+}
+
+static bool queryBegin(LogSdQuery& q, uint32_t from, uint32_t to) {
+    q.from = from;
+    q.to = to;
+    q.fileCount = q.fileIndex = 0;
+    q.fileActive = false;
+    q.failed = false;
+    q.filesOpened = 0;
+    q.bytesRead = 0;
+    q.waitMs = 0;
+    if (!isSDReady()) return false;
+
+    // Zapis iz dneva D lahko zaradi zamika ringa pristane v datoteki D+1
+    uint32_t firstDay = logDayOf(from);
+    uint32_t lastDay = logDayOf(to + 86400UL > to ? to + 86400UL : to);
+    // Datoteke pred NTP (dan 0) imajo ts v sekundah od zagona - ne ujemajo se z
+    // datumom, zato pridejo v poštev, kadar razpon sega v to območje (razpon v
+    // footerju nato izloči neustrezne zagone)
+    bool uptimeRange = from < LOG_SD_UPTIME_TS_MAX;
+
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(LOG_SD_QUERY_LOCK_MS)) != pdTRUE) return false;
+    FsFile dir;
+    if (dir.open(LOG_SD_DIR, O_RDONLY)) {
+        FsFile entry;
+        char name[32];
+        while (entry.openNext(&dir, O_RDONLY)) {
+            if (!entry.isDir() && entry.getName(name, sizeof(name)) && strlen(name) == 15 && strstr(name, ".log")) {
+                uint32_t day = strtoul(name, nullptr, 10);
+                bool match = day == 0 ? uptimeRange : day >= firstDay && day <= lastDay;
+                if (match && q.fileCount < LOG_SD_MAX_FILES) {
+                    strlcpy(q.files[q.fileCount++], name, sizeof(q.files[0]));
+                }
+            }
+            entry.close();
+        }
+        dir.close();
+    }
+    xSemaphoreGive(sdMutex);
+
+    // Imena YYYYMMDD_NN so kronološka (00000000_NN pred vsemi)
+    qsort(q.files, q.fileCount, sizeof(q.files[0]),
+          [](const void* a, const void* b) { return strcmp((const char*)a, (const char*)b); });
+    return true;
+}
+
+static bool queryNext(LogSdQuery& q, uint32_t& timestamp, const char*& line, size_t& length) {
+    size_t len = 0;
+    for (;;) {
+        if (!q.fileActive) {
+            if (q.failed || !openQueryFile(q)) return false;
+            len = 0;
+        }
+
+        if (q.bufPos == q.bufLen) {
+            if (q.offset >= q.dataEnd) {
+                q.fileActive = false;
+                continue;
+            }
+            if (queryCancelled()) return false;
+            uint32_t aligned = q.offset & ~(uint32_t)(LOG_SD_SECTOR - 1);
+            size_t sectors = (q.dataEnd - aligned + LOG_SD_SECTOR - 1) / LOG_SD_SECTOR;
+            if (sectors > LOG_SD_QUERY_BUF / LOG_SD_SECTOR) sectors = LOG_SD_QUERY_BUF / LOG_SD_SECTOR;
+            if (!readQuerySectors(q, aligned, q.buf, sectors)) {
+                q.failed = true;
+                return false;
+            }
+            q.bufPos = q.offset - aligned;
+            q.bufLen = sectors * LOG_SD_SECTOR;
+            if (aligned + q.bufLen > q.dataEnd) q.bufLen = q.dataEnd - aligned;
+        }
+
+        uint8_t c = q.buf[q.bufPos++];
+        q.offset++;
+        if (!sectorHasData(c)) {          // izbrisan del - konec zapisanih podatkov
+            q.fileActive = false;
+            continue;
+        }
+        if (c != '\n') {
+            if (len < sizeof(q.line) - 1) q.line[len++] = c;
+            continue;
+        }
+
+        q.line[len] = '\0';
+        uint32_t ts;
+        size_t lineLen = len;
+        len = 0;
+        if (!parseLineTimestamp(q.line, q.line + lineLen, ts)) continue;
+        if (ts > q.stopAfter) {
+            q.fileActive = false;          // naprej je ts > to (padec je omejen s timestampDrop)
+            continue;
+        }
+        if (ts < q.from || ts > q.to) continue;
+        timestamp = ts;
+        line = q.line;
+        length = lineLen;
+        return true;
+    }
+}
+
+static void copyToChannel(uint32_t pos, const void* src, size_t len) {
+    uint32_t at = pos % LOG_SD_QUERY_OUT;
+    size_t first = len < LOG_SD_QUERY_OUT - at ? len : LOG_SD_QUERY_OUT - at;
+    memcpy(channel.out + at, src, first);
+    memcpy(channel.out, (const uint8_t*)src + first, len - first);
+}
+
+static void copyFromChannel(uint32_t pos, void* dst, size_t len) {
+    uint32_t at = pos % LOG_SD_QUERY_OUT;
+    size_t first = len < LOG_SD_QUERY_OUT - at ? len : LOG_SD_QUERY_OUT - at;
+    memcpy(dst, channel.out + at, first);
+    memcpy((uint8_t*)dst + first, channel.out, len - first);
+}
+
+// Doda vrstico v izhodni vmesnik; čaka, da bralec sprosti prostor. false = preklicano.
+static bool pushQueryLine(uint32_t timestamp, const char* line, size_t length) {
+    uint16_t len = length;
+    size_t need = 6 + len;
+    for (;;) {
+        portENTER_CRITICAL(&queryMux);
+        bool cancel = channel.cancel;
+        uint32_t head = channel.head;
+        uint32_t used = head - channel.tail;
+        portEXIT_CRITICAL(&queryMux);
+        if (cancel) return false;
+        if (LOG_SD_QUERY_OUT - used >= need) {
+            copyToChannel(head, &timestamp, 4);
+            copyToChannel(head + 4, &len, 2);
+            copyToChannel(head + 6, line, len);
+            portENTER_CRITICAL(&queryMux);
+            channel.head = head + need;
+            portEXIT_CRITICAL(&queryMux);
+            return true;
+        }
+        unsigned long waitStart = millis();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_SD_QUERY_SPACE_MS));
+        query.waitMs += millis() - waitStart;
+    }
+}
+
+static void runQuery(uint32_t from, uint32_t to) {
+    unsigned long start = millis();
+    bool ok = queryBegin(query, from, to);
+    uint32_t ts;
+    const char* line;
+    size_t length;
+    uint32_t lines = 0;
+    uint32_t firstLineMs = 0;
+    while (ok && queryNext(query, ts, line, length)) {
+        if (lines == 0) firstLineMs = millis() - start;
+        if (!pushQueryLine(ts, line, length)) break;
+        lines++;
+    }
+    uint32_t elapsed = millis() - start;
+    uint32_t readMs = elapsed - query.waitMs;
+    bool failed = !ok || query.failed;
+
+    portENTER_CRITICAL(&queryMux);
+    channel.failed = failed;
+    bool cancelled = channel.cancel;
+    channel.state = cancelled ? QUERY_IDLE : QUERY_DONE;
+    lastQuery.window = to - from;
+    lastQuery.ms = elapsed;
+    lastQuery.readMs = readMs;
+    lastQuery.firstLineMs = firstLineMs;
+    lastQuery.bytes = query.bytesRead;
+    lastQuery.files = query.filesOpened;
+    lastQuery.lines = lines;
+    portEXIT_CRITICAL(&queryMux);
+    LOG_DEBUG("SD", "Poizvedba %lu-%lu: %u/%lu datotek, %lu vrstic, %lu kB, %lu ms (branje %lu ms, prva vrstica %lu ms)%s",
+              (unsigned long)from, (unsigned long)to, query.fileCount, (unsigned long)query.filesOpened,
+              (unsigned long)lines, (unsigned long)(query.bytesRead / 1024), (unsigned long)elapsed,
+              (unsigned long)readMs, (unsigned long)firstLineMs,
+              failed ? " (napaka)" : cancelled ? " (preklicano)" : "");
+    if (!failed && !cancelled && to - from <= LOG_SD_QUERY_WINDOW && readMs > LOG_SD_QUERY_TARGET_MS) {
+        LOG_WARN("SD", "Poizvedba okna %lu s: %lu ms branja (cilj %d ms), %lu kB iz %lu datotek",
+                 (unsigned long)(to - from), (unsigned long)readMs, LOG_SD_QUERY_TARGET_MS,
+                 (unsigned long)(query.bytesRead / 1024), (unsigned long)query.filesOpened);
+    }
+}
+
+static void logQueryTask(void* param) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        bool pending = false;
+        uint32_t from = 0, to = 0;
+        portENTER_CRITICAL(&queryMux);
+        if (channel.state == QUERY_PENDING) {
+            channel.state = QUERY_RUNNING;
+            from = channel.from;
+            to = channel.to;
+            pending = true;
+        }
+        portEXIT_CRITICAL(&queryMux);
+        if (pending) runQuery(from, to);
+    }
+}
+
+uint32_t logSdQueryStart(uint32_t from, uint32_t to) {
+    if (!queryTask || !isSDReady()) return 0;
+    uint32_t id = 0;
+    portENTER_CRITICAL(&queryMux);
+    if (channel.state == QUERY_IDLE) {
+        id = nextQueryId++;
+        if (nextQueryId == 0) nextQueryId = 1;
+        channel.state = QUERY_PENDING;
+        channel.id = id;
+        channel.from = from;
+        channel.to = to;
+        channel.cancel = false;
+        channel.failed = false;
+        channel.head = channel.tail = 0;
+    }
+    portEXIT_CRITICAL(&queryMux);
+    if (id) xTaskNotifyGive(queryTask);
+    return id;
+}
+
+LogSdQueryPoll logSdQueryPoll(uint32_t id, uint32_t& timestamp, char* line, size_t size, size_t& length) {
+    portENTER_CRITICAL(&queryMux);
+    bool own = channel.id == id && channel.state != QUERY_IDLE && !channel.cancel;
+    QueryState state = channel.state;
+    bool failed = channel.failed;
+    uint32_t head = channel.head;
+    uint32_t tail = channel.tail;
+    portEXIT_CRITICAL(&queryMux);
+    if (!own) return LOG_SD_QUERY_ERROR;
+    // head in state sta prebrana skupaj - v QUERY_DONE je head dokončen
+    if (head == tail) {
+        if (state != QUERY_DONE) return LOG_SD_QUERY_WAIT;
+        return failed ? LOG_SD_QUERY_ERROR : LOG_SD_QUERY_END;
+    }
+
+    uint16_t len;
+    copyFromChannel(tail, &timestamp, 4);
+    copyFromChannel(tail + 4, &len, 2);
+    length = len < size ? len : size - 1;
+    copyFromChannel(tail + 6, line, length);
+    line[length] = '\0';
+
+    portENTER_CRITICAL(&queryMux);
+    channel.tail = tail + 6 + len;
+    portEXIT_CRITICAL(&queryMux);
+    xTaskNotifyGive(queryTask);
+    return LOG_SD_QUERY_LINE;
+}
+
+void logSdQueryRelease(uint32_t id) {
+    bool wake = false;
+    portENTER_CRITICAL(&queryMux);
+    if (channel.id == id) {
+        if (channel.state == QUERY_RUNNING) {
+            channel.cancel = true;     // task sprosti kanal, ko opazi preklic
+            wake = true;
+        } else {
+            channel.state = QUERY_IDLE;
+        }
+    }
+    portEXIT_CRITICAL(&queryMux);
+    if (wake) xTaskNotifyGive(queryTask);
+}
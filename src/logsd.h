@@ -0,0 +1,105 @@
+// logsd.h - Persistent log sink on SD card for CEE
+//
+// Ločen task bere log ring (LOG_CONSUMER_SD) in piše vrstice v dnevne datoteke
+// /logs/YYYYMMDD_NN.log. Datoteka je ob nastanku prealocirana kot zvezen blok
+// (LOG_SD_FILE_SIZE) in izbrisana; podatki se pišejo s celimi sektorji
+// neposredno na kartico, zato se FAT in vnos v imeniku med pisanjem ne
+// spreminjata - izpad napajanja ne more pokvariti datotečnega sistema.
+// Zadnjih LOG_SD_FOOTER_SIZE bajtov datoteke je footer s povzetkom in redkim
+// indeksom čas -> odmik (zapiše se ob zaprtju datoteke).
+//
+// Poizvedba po času (logSdQuery*) izbere datoteke po datumu v imenu, preveri
+// razpon v footerju, z indeksom in bisekcijo po sektorjih poišče prvo vrstico
+// s ts >= from in nato bere samo do prve vrstice s ts > to. ts v datoteki lahko
+// pade (premik ure ob koncu poletnega časa, NTP popravek) - footer hrani
+// največji padec pod dotlejšnji maksimum (timestampDrop), za katerega se meji
+// iskanja razširita. Brez footerja padec ni znan in se bere cela datoteka.
+// Poizvedba se meri (čas branja brez čakanja na bralca, prva vrstica, bajti;
+// getSdLogStatus) in opozori, če okno LOG_SD_QUERY_WINDOW preseže
+// LOG_SD_QUERY_TARGET_MS. Vse branje s kartice teče v tasku "logquery", ki
+// vrstice nalaga v vmesnik LOG_SD_QUERY_OUT; klicatelj (web callback v
+// async_tcp) jih le pobira in nikoli ne čaka na sdMutex.
+
+#ifndef LOGSD_H
+#define LOGSD_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "logging.h"
+
+#define LOG_SD_FOOTER_MAGIC "CEELOGF2"
+#define LOG_SD_INDEX_MAX (LOG_SD_FILE_SIZE / LOG_SD_INDEX_STRIDE)
+
+enum LogSdCloseReason : uint8_t {
+    LOG_SD_CLOSE_NONE = 0,     // datoteka še odprta / izpad napajanja
+    LOG_SD_CLOSE_DAY,          // dnevna rotacija
+    LOG_SD_CLOSE_SIZE          // datoteka polna
+};
+
+struct LogSdIndexEntry {
+    uint32_t timestamp;
+    uint32_t seq;
+    uint32_t offset;           // odmik začetka vrstice v datoteki
+};
+
+struct LogSdFooter {
+    char magic[8];
+    uint32_t dataBytes;        // zapisani podatki (vključno s polnilom do sektorja)
+    uint32_t records;
+    uint32_t firstSeq;
+    uint32_t lastSeq;
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+    uint32_t minTimestamp;
+    uint32_t maxTimestamp;
+    uint32_t timestampDrop;    // največji padec ts pod dotlejšnji maksimum (s)
+    uint32_t dropped;          // zapisi, prepisani v ringu pred zapisom na SD
+    uint8_t closeReason;
+    uint8_t reserved;
+    uint16_t indexCount;
+    LogSdIndexEntry index[LOG_SD_INDEX_MAX];
+};
+
+static_assert(sizeof(LogSdFooter) <= LOG_SD_FOOTER_SIZE, "LogSdFooter ne gre v LOG_SD_FOOTER_SIZE");
+
+struct SdLogStatus {
+    bool active;
+    char path[32];
+    uint32_t dataBytes;
+    uint32_t capacity;
+    uint32_t bytesWritten;     // od zagona
+    uint32_t filesCreated;
+    uint32_t writeErrors;
+    uint32_t dropped;
+    // Zadnja poizvedba po času
+    uint32_t queryWindow;      // to - from (s)
+    uint32_t queryMs;          // od začetka do konca, vključno s čakanjem na bralca
+    uint32_t queryReadMs;      // samo delo taska (brez čakanja na prostor v vmesniku)
+    uint32_t queryFirstLineMs; // do prve najdene vrstice
+    uint32_t queryBytes;       // prebrano s kartice
+    uint32_t queryFiles;       // odprte datoteke
+    uint32_t queryLines;
+};
+
+// Rezultat logSdQueryPoll
+enum LogSdQueryPoll : uint8_t {
+    LOG_SD_QUERY_LINE = 0,     // vrstica prebrana
+    LOG_SD_QUERY_WAIT,         // task še bere - poskusi znova
+    LOG_SD_QUERY_END,          // ni več vrstic
+    LOG_SD_QUERY_ERROR         // konec zaradi napake branja SD
+};
+
+void initSdLog();
+// Iz glavne zanke: posnetek lokalnega časa za dnevno rotacijo v SD tasku
+void sdLogService();
+void getSdLogStatus(SdLogStatus& status);
+
+// from/to v istem času kot ts v vrsticah. Naenkrat teče ena poizvedba;
+// 0 = ni kartice ali poizvedba že teče, sicer id za Poll/Release
+uint32_t logSdQueryStart(uint32_t from, uint32_t to);
+// Naslednja vrstica v [from, to] (brez '\n', skrajšana na size-1); ne blokira
+LogSdQueryPoll logSdQueryPoll(uint32_t id, uint32_t& timestamp, char* line, size_t size, size_t& length);
+// Sprosti poizvedbo (tudi nedokončano); task jo prekine ob naslednji vrstici
+void logSdQueryRelease(uint32_t id);
+
+#endif // LOGSD_H
@@ -0,0 +1,285 @@
+// logship.cpp - Compressed log shipping to REW for CEE
+
+#include "logship.h"
+#include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "deflate.h"
+
+static TaskHandle_t shipTask = NULL;
+static DeflateState deflater;          // ~7 kB, samo ship task
+static LogShipStats shipStats = {};
+static portMUX_TYPE shipMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t shipBootId = 0;        // X-Log-Boot, nastavi initLogShipping()
+
+// REW je gzip zavrnil s 415 - do ponovnega zagona pošiljaj nestisnjeno telo
+static bool shipGzip = true;
+static WiFiClient* plainClient = nullptr;
+static uint8_t plainOut[DEFLATE_OUT_SIZE];
+static size_t plainLen = 0;
+
+enum ShipResult {
+    SHIP_OK,
+    SHIP_FAILED,
+    SHIP_RETRY          // takoj znova (preklop na nestisnjeno telo)
+};
+
+// Stisnjene bajte zapiše kot en HTTP chunk
+static bool writeHttpChunk(const uint8_t* data, size_t length, void* ctx) {
+    WiFiClient* client = (WiFiClient*)ctx;
+    char size[12];
+    int n = snprintf(size, sizeof(size), "%x\r\n", (unsigned)length);
+    if (client->write((const uint8_t*)size, n) != (size_t)n) return false;
+    if (client->write(data, length) != length) return false;
+    return client->write((const uint8_t*)"\r\n", 2) == 2;
+}
+
+static bool flushPlain() {
+    if (plainLen == 0) return true;
+    bool ok = writeHttpChunk(plainOut, plainLen, plainClient);
+    plainLen = 0;
+    return ok;
+}
+
+// Stisne (ali brez gzip samo zbere v chunk) del telesa
+static bool compressString(const char* text, size_t length) {
+    shipStats.bytesRaw += length;
+    if (shipGzip) return deflateWrite(deflater, (const uint8_t*)text, length);
+    while (length > 0) {
+        size_t n = length < sizeof(plainOut) - plainLen ? length : sizeof(plainOut) - plainLen;
+        memcpy(plainOut + plainLen, text, n);
+        plainLen += n;
+        text += n;
+        length -= n;
+        if (plainLen == sizeof(plainOut) && !flushPlain()) return false;
+    }
+    return true;
+}
+
+// JSON escape vrstice in stiskanje
+static bool compressJsonLine(const char* line, size_t length) {
+    char esc[128];
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = line[i];
+        if (n + 6 >= sizeof(esc)) {
+            if (!compressString(esc, n)) return false;
+            n = 0;
+        }
+        if (c == '"' || c == '\\') {
+            esc[n++] = '\\';
+            esc[n++] = c;
+        } else if (c == '\n') {
+            esc[n++] = '\\';
+            esc[n++] = 'n';
+        } else if ((uint8_t)c < 0x20) {
+            n += snprintf(esc + n, sizeof(esc) - n, "\\u%04x", (uint8_t)c);
+        } else {
+            esc[n++] = c;
+        }
+    }
+    return n == 0 || compressString(esc, n);
+}
+
+// Prebere statusno vrstico in glave odgovora; vrne HTTP kodo (<0 napaka)
+static int readShipResponse(WiFiClient& client, uint32_t& ackSeq, bool& hasAck) {
+    hasAck = false;
+    unsigned long start = millis();
+    while (!client.available()) {
+        if (!client.connected() || millis() - start > LOG_SHIP_RESPONSE_TIMEOUT_MS) return -1;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    String status = client.readStringUntil('\n');
+    int code = -2;
+    int sp = status.indexOf(' ');
+    if (status.startsWith("HTTP/") && sp > 0) code = status.substring(sp + 1).toInt();
+
+    for (int i = 0; i < 32; i++) {
+        String header = client.readStringUntil('\n');
+        header.trim();
+        if (header.length() == 0) break;
+        if (header.startsWith("X-Log-Ack:") || header.startsWith("x-log-ack:")) {
+            ackSeq = strtoul(header.c_str() + 10, nullptr, 10);
+            hasAck = true;
+        }
+    }
+    return code;
+}
+
+// Pošlje en paket (do LOG_SHIP_BATCH_RECORDS zapisov)
+static ShipResult shipBatch(uint32_t targetSeq) {
+    LogCursor cursor;
+    getLogCursor(LOG_CONSUMER_REW, cursor);
+    LogRingStats ring;
+    logRingGetStats(ring);
+    bool behind = (int32_t)(cursor.seq - ring.firstSeq) < 0;
+    uint32_t firstSeq = behind ? ring.firstSeq : cursor.seq;
+    uint32_t lastSeq = firstSeq + LOG_SHIP_BATCH_RECORDS - 1;
+    if ((int32_t)(lastSeq - (targetSeq - 1)) > 0) lastSeq = targetSeq - 1;
+    // Vsi zapisi, prepisani preden jih je REW prejel (od zagona, narašča)
+    uint32_t dropped = cursor.dropped + (behind ? ring.firstSeq - cursor.seq : 0);
+
+    WiFiClient client;
+    if (!client.connect(IP_REW, 80, LOG_SHIP_CONNECT_TIMEOUT_MS)) {
+        shipStats.lastHttpCode = -1;
+        return SHIP_FAILED;
+    }
+    client.setTimeout(LOG_SHIP_IO_TIMEOUT_S);
+
+    char headers[384];
+    int n = snprintf(headers, sizeof(headers),
+                     "POST /api/logs HTTP/1.1\r\n"
+                     "Host: " IP_REW "\r\n"
+                     "Content-Type: application/json\r\n"
+                     "%s"
+                     "Transfer-Encoding: chunked\r\n"
+                     "X-Log-First-Seq: %lu\r\n"
+                     "X-Log-Last-Seq: %lu\r\n"
+                     "X-Log-Dropped: %lu\r\n"
+                     "X-Log-Boot: %08lx\r\n"
+                     "Connection: close\r\n\r\n",
+                     shipGzip ? "Content-Encoding: gzip\r\n" : "",
+                     (unsigned long)firstSeq, (unsigned long)lastSeq, (unsigned long)dropped,
+                     (unsigned long)shipBootId);
+    bool ok = client.write((const uint8_t*)headers, n) == (size_t)n;
+
+    uint32_t rawBefore = shipStats.bytesRaw;
+    uint32_t records = 0;
+    uint32_t droppedBefore = cursor.dropped;
+    bool gzip = shipGzip;
+    if (gzip) {
+        ok = ok && deflateBegin(deflater, writeHttpChunk, &client);
+    } else {
+        plainClient = &client;
+        plainLen = 0;
+    }
+    ok = ok && compressString("{\"logs\":\"", 9);
+
+    LogEntry entry;
+    char line[LOG_LINE_MAX];
+    while (ok && (int32_t)(cursor.seq - lastSeq) <= 0 && readLogEntry(cursor, entry)) {
+        size_t len = formatLogLine(entry, line, sizeof(line));
+        ok = compressJsonLine(line, len);
+        records++;
+    }
+    ok = ok && compressString("\"}", 2);
+    ok = ok && (gzip ? deflateFinish(deflater) : flushPlain());
+    ok = ok && client.write((const uint8_t*)"0\r\n\r\n", 5) == 5;
+    plainClient = nullptr;
+
+    uint32_t ackSeq = 0;
+    bool hasAck = false;
+    int code = ok ? readShipResponse(client, ackSeq, hasAck) : -3;
+    client.stop();
+    shipStats.lastHttpCode = code;
+
+    if (code == 415 && gzip) {
+        shipGzip = false;
+        LOG_WARN("HTTP", "LOGS→REW: gzip zavrnjen (HTTP 415) - pošiljam nestisnjeno");
+        return SHIP_RETRY;
+    }
+    if (code < 200 || code >= 300) {
+        LOG_WARN("HTTP", "LOGS→REW: neuspeh HTTP %d pri zapisih %lu-%lu — ponovim od %lu",
+                 code, (unsigned long)firstSeq, (unsigned long)lastSeq, (unsigned long)firstSeq);
+        return SHIP_FAILED;
+    }
+
+    // Potrditev REW ima prednost - lahko je sprejel le del paketa (dropped se ohrani).
+    // Ack izven [firstSeq - 1, lastSeq] bi preskočil neposlane zapise ali pa
+    // zavrtel takojšnje ponovno pošiljanje istega paketa - omeji ga na paket.
+    if (hasAck) {
+        uint32_t acked = ackSeq;
+        if ((int32_t)(ackSeq - (firstSeq - 1)) < 0) acked = firstSeq - 1;
+        else if ((int32_t)(ackSeq - lastSeq) > 0) acked = lastSeq;
+        if (acked != ackSeq) {
+            LOG_WARN("HTTP", "LOGS→REW: X-Log-Ack %lu izven paketa %lu-%lu - upoštevam %lu",
+                     (unsigned long)ackSeq, (unsigned long)firstSeq, (unsigned long)lastSeq,
+                     (unsigned long)acked);
+        }
+        if (acked == firstSeq - 1) {
+            LOG_WARN("HTTP", "LOGS→REW: REW ni potrdil nobenega zapisa %lu-%lu — ponovim ob naslednji zahtevi",
+                     (unsigned long)firstSeq, (unsigned long)lastSeq);
+            return SHIP_FAILED;
+        }
+        logRingSeek(cursor, acked + 1);
+    }
+    commitLogCursor(LOG_CONSUMER_REW, cursor);
+
+    uint32_t raw = shipStats.bytesRaw - rawBefore;
+    uint32_t sent = gzip ? deflater.bytesOut : raw;
+    shipStats.bytesCompressed += sent;
+    shipStats.recordsSent += records;
+    shipStats.batchesSent++;
+    LOG_INFO("HTTP", "LOGS→REW: uspeh HTTP %d, %lu zapisov, %.1f kB → %.1f kB %s%s",
+             code, (unsigned long)records, raw / 1024.0, sent / 1024.0, gzip ? "gzip" : "brez stiskanja",
+             cursor.dropped != droppedBefore ? " (del prepisan pred pošiljanjem)" : "");
+    return SHIP_OK;
+}
+
+static void logShipTask(void* param) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Pošlji do stanja ob zahtevi - lastni logi med pošiljanjem gredo naslednjič
+        LogRingStats ring;
+        logRingGetStats(ring);
+        uint32_t targetSeq = ring.nextSeq;
+
+        portENTER_CRITICAL(&shipMux);
+        shipStats.busy = true;
+        portEXIT_CRITICAL(&shipMux);
+
+        for (;;) {
+            LogCursor cursor;
+            getLogCursor(LOG_CONSUMER_REW, cursor);
+            if ((int32_t)(cursor.seq - targetSeq) >= 0) break;
+
+            ShipResult result = shipBatch(targetSeq);
+            if (result == SHIP_RETRY) continue;
+            if (result == SHIP_FAILED) {
+                shipStats.failures++;
+                shipStats.consecutiveFailures++;
+                if (shipStats.consecutiveFailures >= 5) {
+                    LOG_ERROR("HTTP", "Persistent log failures (%lu consecutive) - REW connectivity issue?",
+                              (unsigned long)shipStats.consecutiveFailures);
+                }
+                break;
+            }
+            if (shipStats.consecutiveFailures > 0) {
+                LOG_INFO("LOG", "Recovery: logs successfully sent after %lu failures",
+                         (unsigned long)shipStats.consecutiveFailures);
+            }
+            shipStats.consecutiveFailures = 0;
+        }
+
+        portENTER_CRITICAL(&shipMux);
+        shipStats.busy = false;
+        portEXIT_CRITICAL(&shipMux);
+    }
+}
+
+void initLogShipping() {
+    shipBootId = esp_random();
+    BaseType_t ok = xTaskCreatePinnedToCore(logShipTask, "logship", 6144, NULL, 1, &shipTask, 0);
+    if (ok != pdPASS) {
+        shipTask = NULL;
+        LOG_ERROR("LOG", "Log shipping task ni bil ustvarjen!");
+    }
+}
+
+// Sproži pošiljanje; ne blokira klicatelja
+bool requestLogShipping() {
+    if (shipTask == NULL) return false;
+    xTaskNotifyGive(shipTask);
+    return true;
+}
+
+void getLogShipStats(LogShipStats& stats) {
+    portENTER_CRITICAL(&shipMux);
+    stats = shipStats;
+    portEXIT_CRITICAL(&shipMux);
+}
@@ -0,0 +1,35 @@
+// logship.h - Compressed log shipping to REW for CEE
+//
+// Ločen task ob zahtevi (flushLogBuffer) pošlje neposlane zapise iz log ringa
+// na REW /api/logs: telo {"logs":"..."} se sproti stiska (gzip, deflate.h) in
+// pošilja s chunked transfer encoding, brez kopije celotnega paketa v RAM.
+// Paketi imajo X-Log-First-Seq/X-Log-Last-Seq; kazalec LOG_CONSUMER_REW se
+// premakne po vsakem uspešnem paketu (ali na X-Log-Ack iz odgovora), zato
+// prekinjeno pošiljanje nadaljuje pri prvem nepotrjenem zapisu.
+// X-Log-Dropped je skupno število zapisov, prepisanih v ringu preden so bili
+// poslani. X-Log-Boot (naključen ob zagonu) loči seq različnih zagonov, ker se
+// seq ob zagonu začne pri 0. Potrditev izven poslanega paketa se omeji nanj;
+// paket brez potrjenega zapisa šteje kot neuspeh (ponovitev ob naslednji
+// zahtevi). Če REW gzip zavrne s 415, se telo pošilja nestisnjeno.
+
+#ifndef LOGSHIP_H
+#define LOGSHIP_H
+
+#include <Arduino.h>
+
+struct LogShipStats {
+    uint32_t batchesSent;
+    uint32_t recordsSent;
+    uint32_t bytesRaw;           // nestisnjeno JSON telo
+    uint32_t bytesCompressed;
+    uint32_t failures;
+    uint32_t consecutiveFailures;
+    int lastHttpCode;
+    bool busy;
+};
+
+void initLogShipping();
+bool requestLogShipping();
+void getLogShipStats(LogShipStats& stats);
+
+#endif // LOGSHIP_H
@@ -14,8 +14,16 @@
 #include "sens.h"
 #include "vent.h"
 #include "http.h"
+#include "mcast.h"
+#include "outbox.h"
+#include "liveness.h"
+#include "dashpush.h"
+#include "wsctl.h"
+#include "mqtt.h"
 #include "web.h"
 #include "sd.h"
+#include "logsd.h"
+#include "logship.h"
 #include "message_fields.h"
 
 #define ETH ETH2
@@ -240,6 +248,7 @@ void setup() {
     LOG_INFO("SD", "Initializing SD card...");
     initSD();
     LOG_INFO("SD", "Initialization complete");
+    initSdLog();
 
     // Initialize sensors
     initSensors();
@@ -259,8 +268,17 @@ void setup() {
     // Setup and start web server
     setupWebServer();
 
-    // Initial device status check
+    // Start log shipping task (REW)
+    initLogShipping();
+
+    // Multicast objava stanja, asinhroni HTTP odjemalec in outbox do REW/DEW ter začetni ping (rezultat v loop)
+    initStateMulticast();
+    initHttpPool();
+    initStatusUpdates();
     checkAllDevices();
+#ifdef MQTT_TELEMETRY
+    initMqtt();
+#endif
 
     // Hardware watchdog - reset if loop freezes for WDT_TIMEOUT_SEC seconds
     esp_task_wdt_init(WDT_TIMEOUT_SEC, true);
@@ -278,11 +296,14 @@ void loop() {
         performPeriodicSensorCheck();
         performSmartI2CMaintenance();
         lastSensorRead = now;
+    } else {
+        // Pospešeno branje prostorov v aktivnem sušenju
+        readSensorsAdaptive();
     }
 
     // Periodic input reading and vent control - every 200ms
     static unsigned long lastInputRead = 0;
-    if (now - lastInputRead >= 200) {  // Every 200ms
+    if (now - lastInputRead >= CONTROL_TICK_MS) {  // Every 200ms
         readInputs();
         controlBathroom();
         controlUtility();
@@ -296,6 +317,15 @@ void loop() {
 
     // Check and send STATUS_UPDATE to REW
     checkAndSendStatusUpdate();
+    livenessService();
+    outboxService();
+    httpPoolService();
+    dashboardService();
+    controlSocketService();
+    sdLogService();
+#ifdef MQTT_TELEMETRY
+    mqttService();
+#endif
 
     // Check REW sensor data timeout
     static unsigned long lastDataTimeoutCheck = 0;
@@ -313,7 +343,6 @@ void loop() {
     if (now - lastDeviceCheck > DEVICE_CHECK_INTERVAL) {
         lastDeviceCheck = now;
         flushLogBuffer();
-        checkAllDevices();
     }
 
     // Periodic monthly energy reset check - every 10 minutes
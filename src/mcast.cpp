@@ -0,0 +1,53 @@
+// mcast.cpp - UDP multicast publication of CEE state
+
+#include "mcast.h"
+#include <AsyncUDP.h>
+#include "config.h"
+#include "logging.h"
+
+static AsyncUDP mcastUdp;
+static IPAddress mcastGroup;
+static McastStats mcastStats = {};
+static uint8_t datagram[sizeof(McastHeader) + MSG_BODY_MAX];
+
+bool initStateMulticast() {
+    if (!mcastGroup.fromString(MCAST_GROUP)) {
+        LOG_ERROR("HTTP", "Neveljavna multicast skupina %s", MCAST_GROUP);
+        return false;
+    }
+    mcastStats.active = true;
+    LOG_INFO("HTTP", "Stanje se objavlja na %s:%d (heartbeat %d s)", MCAST_GROUP, MCAST_PORT, MCAST_HEARTBEAT_MS / 1000);
+    return true;
+}
+
+bool stateMulticastActive() {
+    return mcastStats.active;
+}
+
+bool publishStateMulticast(const uint8_t* body, size_t length, uint32_t timestamp, bool heartbeat) {
+    if (!mcastStats.active || length > MSG_BODY_MAX) return false;
+
+    McastHeader header;
+    header.magic[0] = MCAST_MAGIC0;
+    header.magic[1] = MCAST_MAGIC1;
+    header.version = MCAST_VERSION;
+    header.flags = heartbeat ? MCAST_FLAG_HEARTBEAT : 0;
+    header.seq = ++mcastStats.seq;       // ESP32 je little endian
+    header.timestamp = timestamp;
+    memcpy(datagram, &header, sizeof(header));
+    memcpy(datagram + sizeof(header), body, length);
+
+    size_t total = sizeof(header) + length;
+    if (mcastUdp.writeTo(datagram, total, mcastGroup, MCAST_PORT) != total) {
+        mcastStats.errors++;
+        return false;
+    }
+    mcastStats.datagrams++;
+    if (heartbeat) mcastStats.heartbeats++;
+    mcastStats.lastSent = millis();
+    return true;
+}
+
+void getStateMulticastStats(McastStats& stats) {
+    stats = mcastStats;
+}
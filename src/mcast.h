@@ -0,0 +1,43 @@
+// mcast.h - UDP multicast publication of CEE state
+//
+// En datagram na spremembo stanja na MCAST_GROUP:MCAST_PORT, ki ga prejmejo
+// vse enote hkrati (REW, UT_DEW, KOP_DEW). Datagram je 12 B glave
+// (McastHeader) + MessagePack s ključi iz message_fields.h (unija STATUS_UPDATE
+// in DEW_UPDATE). seq narašča z vsakim datagramom, zato prejemnik zazna izgubo;
+// heartbeat (MCAST_HEARTBEAT_MS) ponovi trenutno stanje za nove in zamujene
+// prejemnike. Enota, ki posluša, to sporoči z "mcast" v X-Vent-Caps - takim
+// gre HTTP le še ob periodičnem STATUS_UPDATE_INTERVAL.
+
+#ifndef MCAST_H
+#define MCAST_H
+
+#include <Arduino.h>
+
+#define MCAST_MAGIC0 'V'
+#define MCAST_MAGIC1 'S'
+#define MCAST_VERSION 1
+#define MCAST_FLAG_HEARTBEAT 0x01
+
+struct __attribute__((packed)) McastHeader {
+    char magic[2];
+    uint8_t version;
+    uint8_t flags;
+    uint32_t seq;           // little endian
+    uint32_t timestamp;     // Unix čas (lokalni, kot offTimes)
+};
+
+struct McastStats {
+    bool active;
+    uint32_t seq;
+    uint32_t datagrams;
+    uint32_t heartbeats;
+    uint32_t errors;
+    unsigned long lastSent;
+};
+
+bool initStateMulticast();
+bool stateMulticastActive();
+bool publishStateMulticast(const uint8_t* body, size_t length, uint32_t timestamp, bool heartbeat);
+void getStateMulticastStats(McastStats& stats);
+
+#endif // MCAST_H
@@ -0,0 +1,405 @@
+// metrics.cpp - OpenMetrics /metrics endpoint
+
+#include "metrics.h"
+#include <math.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "liveness.h"
+#include "outbox.h"
+#include "mcast.h"
+#include "dashpush.h"
+#include "wsctl.h"
+
+#define METRICS_LINE_MAX 160
+#define METRICS_PEERS 3             // REW, UT_DEW, KOP_DEW (bench ni vključen)
+#define METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+// Meje vedrov v µs; oznaka le je v sekundah
+static const uint32_t clientBoundsUs[] = {10000, 25000, 50000, 100000, 250000, 500000,
+                                          1000000, 2500000, 5000000, 10000000};
+static const uint32_t serverBoundsUs[] = {500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000};
+
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+static MetricsHistogram clientDuration[METRICS_PEERS];
+static MetricsHistogram serverDuration;
+static uint32_t serverRequests[4];          // 2xx, 4xx, 5xx, ostalo (brez odgovora, 1xx, 3xx)
+
+static const char* const peerLabels[METRICS_PEERS] = {"rew", "ut_dew", "kop_dew"};
+static const char* const codeLabels[4] = {"2xx", "4xx", "5xx", "other"};
+
+static void initHistogram(MetricsHistogram& h, const uint32_t* bounds, uint8_t count) {
+    memset(&h, 0, sizeof(h));
+    h.boundsUs = bounds;
+    h.bucketCount = count;
+}
+
+static void observe(MetricsHistogram& h, uint32_t us) {
+    uint8_t b = 0;
+    while (b < h.bucketCount && us > h.boundsUs[b]) b++;
+    portENTER_CRITICAL(&metricsMux);
+    h.counts[b]++;
+    h.count++;
+    h.sumUs += us;
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsObserveHttpClient(HttpPeerId peer, int code, uint32_t elapsedMs) {
+    if (peer >= METRICS_PEERS || code == HTTP_POOL_SUPERSEDED) return;
+    observe(clientDuration[peer], elapsedMs * 1000);
+}
+
+// ---- Formatiranje vzorcev ----
+
+// Stanje enega odgovora: trenutna družina, vzorec in delno poslana vrstica
+struct ScrapeState {
+    uint8_t family;
+    uint8_t phase;              // 0 = TYPE, 1 = UNIT, 2 = HELP, 3 = vzorci, 4 = # EOF, 5 = konec
+    uint16_t sample;
+    uint16_t lineLen;
+    uint16_t lineOff;
+    char line[METRICS_LINE_MAX];
+    MetricsHistogram hist;      // posnetek histograma za dosledne vrstice ene oznake
+};
+
+static const char* fmtValue(char* out, size_t size, double value) {
+    if (isnan(value)) snprintf(out, size, "NaN");
+    else if (value == floor(value) && fabs(value) < 1e15) snprintf(out, size, "%lld", (long long)value);
+    else snprintf(out, size, "%.6g", value);
+    return out;
+}
+
+// name{labelName="labelValue"} value - labelName nullptr = brez oznak
+static int sampleLine(char* out, size_t size, const char* name, const char* suffix,
+                      const char* labelName, const char* labelValue, double value) {
+    char v[24];
+    fmtValue(v, sizeof(v), value);
+    if (!labelName) return snprintf(out, size, "%s%s %s\n", name, suffix, v);
+    return snprintf(out, size, "%s%s{%s=\"%s\"} %s\n", name, suffix, labelName, labelValue, v);
+}
+
+struct MetricFamily;
+typedef int (*SampleFn)(const MetricFamily& f, ScrapeState& st, uint16_t i, char* out, size_t size);
+
+struct MetricFamily {
+    const char* name;
+    const char* type;           // gauge, counter, histogram
+    const char* unit;           // nullptr = brez; sicer konec imena
+    const char* help;
+    SampleFn sample;            // i-ti vzorec; 0 = ni več vzorcev
+};
+
+static int sampleTemperature(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const rooms[] = {"kop", "ut", "ds", "ext"};
+    const float values[] = {currentData.bathroomTemp, currentData.utilityTemp, currentData.livingTemp,
+                            currentData.externalTemp};
+    return i < 4 ? sampleLine(out, size, f.name, "", "room", rooms[i], values[i]) : 0;
+}
+
+static int sampleHumidity(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const rooms[] = {"kop", "ut", "ds", "ext"};
+    const float values[] = {currentData.bathroomHumidity, currentData.utilityHumidity, currentData.livingHumidity,
+                            currentData.externalHumidity};
+    return i < 4 ? sampleLine(out, size, f.name, "", "room", rooms[i], values[i]) : 0;
+}
+
+static int samplePressure(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i == 0) return sampleLine(out, size, f.name, "", "room", "kop", currentData.bathroomPressure);
+    if (i == 1) return sampleLine(out, size, f.name, "", "room", "ext", currentData.externalPressure);
+    return 0;
+}
+
+static int sampleCo2(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "", "room", "ds", currentData.livingCO2) : 0;
+}
+
+static int sampleFanOn(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const rooms[] = {"wc", "ut", "kop"};
+    const bool values[] = {currentData.wcFan, currentData.utilityFan, currentData.bathroomFan};
+    return i < 3 ? sampleLine(out, size, f.name, "", "room", rooms[i], values[i]) : 0;
+}
+
+static int sampleFanLevel(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "", "room", "ds", currentData.livingExhaustLevel) : 0;
+}
+
+static int sampleDisabled(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const rooms[] = {"wc", "ut", "kop", "ds"};
+    const bool values[] = {currentData.disableWc, currentData.disableUtility, currentData.disableBathroom,
+                           currentData.disableLivingRoom};
+    return i < 4 ? sampleLine(out, size, f.name, "", "room", rooms[i], values[i]) : 0;
+}
+
+static int sampleDrying(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i == 0) return sampleLine(out, size, f.name, "", "room", "ut", currentData.utilityDryingMode);
+    if (i == 1) return sampleLine(out, size, f.name, "", "room", "kop", currentData.bathroomDryingMode);
+    return 0;
+}
+
+static int sampleSupply(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const rails[] = {"3v3", "5v", "5v_min", "5v_max"};
+    const float values[] = {currentData.supply3V3, currentData.supply5V, currentData.supply5VMin,
+                            currentData.supply5VMax};
+    return i < 4 ? sampleLine(out, size, f.name, "", "rail", rails[i], values[i]) : 0;
+}
+
+static int sampleSags(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "_total", nullptr, nullptr, currentData.supplySagCount) : 0;
+}
+
+static int samplePower(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "", nullptr, nullptr, currentData.currentPower) : 0;
+}
+
+static int sampleEnergy(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "", nullptr, nullptr, currentData.energyConsumption) : 0;
+}
+
+static int sampleSensorError(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    static const char* const sensors[] = {"bme280", "sht41", "power", "dew", "time_sync"};
+    static const uint8_t flags[] = {ERR_BME280, ERR_SHT41, ERR_POWER, ERR_DEW, ERR_TIME_SYNC};
+    return i < 5 ? sampleLine(out, size, f.name, "", "sensor", sensors[i], (currentData.errorFlags & flags[i]) != 0) : 0;
+}
+
+static int sampleUptime(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    return i == 0 ? sampleLine(out, size, f.name, "", nullptr, nullptr, (double)(esp_timer_get_time() / 1000000)) : 0;
+}
+
+static int sampleHeap(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    switch (i) {
+        case 0: return sampleLine(out, size, f.name, "", "kind", "size", ESP.getHeapSize());
+        case 1: return sampleLine(out, size, f.name, "", "kind", "free", ESP.getFreeHeap());
+        case 2: return sampleLine(out, size, f.name, "", "kind", "min_free", ESP.getMinFreeHeap());
+        case 3: return sampleLine(out, size, f.name, "", "kind", "max_alloc", ESP.getMaxAllocHeap());
+        default: return 0;
+    }
+}
+
+static int samplePsram(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    switch (i) {
+        case 0: return sampleLine(out, size, f.name, "", "kind", "size", ESP.getPsramSize());
+        case 1: return sampleLine(out, size, f.name, "", "kind", "free", ESP.getFreePsram());
+        default: return 0;
+    }
+}
+
+static int samplePeerOnline(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= METRICS_PEERS) return 0;
+    LivenessStats l;
+    livenessGetStats((HttpPeerId)i, l);
+    return sampleLine(out, size, f.name, "", "peer", peerLabels[i], l.online);
+}
+
+static int samplePeerRtt(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= METRICS_PEERS) return 0;
+    LivenessStats l;
+    livenessGetStats((HttpPeerId)i, l);
+    return sampleLine(out, size, f.name, "", "peer", peerLabels[i], l.rttMs > 0 ? l.rttMs / 1000.0 : NAN);
+}
+
+static int sampleOutboxEvents(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= METRICS_PEERS) return 0;
+    OutboxStats o;
+    outboxGetStats((HttpPeerId)i, o);
+    return sampleLine(out, size, f.name, "", "peer", peerLabels[i], o.events);
+}
+
+static int sampleOutboxDropped(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= METRICS_PEERS) return 0;
+    OutboxStats o;
+    outboxGetStats((HttpPeerId)i, o);
+    return sampleLine(out, size, f.name, "_total", "peer", peerLabels[i], o.dropped);
+}
+
+// Števec HttpPeerStats po enotah - polje izbere f.name
+static int sampleHttpClient(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= METRICS_PEERS) return 0;
+    HttpPeerStats s;
+    httpPoolGetStats((HttpPeerId)i, s);
+    uint32_t value;
+    if (strstr(f.name, "requests")) value = s.requests;
+    else if (strstr(f.name, "connects")) value = s.connects;
+    else if (strstr(f.name, "retries")) value = s.retries + s.staleRetries;
+    else if (strstr(f.name, "timeouts")) value = s.timeouts;
+    else value = s.failures;
+    return sampleLine(out, size, f.name, "_total", "peer", peerLabels[i], value);
+}
+
+// Vrstice histograma ene oznake: vedra (kumulativno), +Inf, _count, _sum
+static int histogramLine(const MetricFamily& f, ScrapeState& st, uint16_t j, const char* labelName,
+                         const char* labelValue, const MetricsHistogram& source, char* out, size_t size) {
+    MetricsHistogram& h = st.hist;
+    if (j == 0) {
+        portENTER_CRITICAL(&metricsMux);
+        h = source;
+        portEXIT_CRITICAL(&metricsMux);
+    }
+    char labels[48] = "";
+    if (labelName) snprintf(labels, sizeof(labels), "%s=\"%s\",", labelName, labelValue);
+    if (j <= h.bucketCount) {
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b <= j; b++) cumulative += h.counts[b];
+        char le[16];
+        if (j < h.bucketCount) snprintf(le, sizeof(le), "%g", h.boundsUs[j] / 1e6);
+        else snprintf(le, sizeof(le), "+Inf");
+        return snprintf(out, size, "%s_bucket{%sle=\"%s\"} %lu\n", f.name, labels, le, (unsigned long)cumulative);
+    }
+    labels[strlen(labels) ? strlen(labels) - 1 : 0] = '\0';   // brez zadnje vejice
+    const char* open = labels[0] ? "{" : "";
+    const char* close = labels[0] ? "}" : "";
+    if (j == h.bucketCount + 1) {
+        return snprintf(out, size, "%s_count%s%s%s %lu\n", f.name, open, labels, close, (unsigned long)h.count);
+    }
+    return snprintf(out, size, "%s_sum%s%s%s %.6f\n", f.name, open, labels, close, h.sumUs / 1e6);
+}
+
+static int sampleClientDuration(const MetricFamily& f, ScrapeState& st, uint16_t i, char* out, size_t size) {
+    uint16_t perPeer = clientDuration[0].bucketCount + 3;
+    uint16_t peer = i / perPeer;
+    if (peer >= METRICS_PEERS) return 0;
+    return histogramLine(f, st, i % perPeer, "peer", peerLabels[peer], clientDuration[peer], out, size);
+}
+
+static int sampleServerRequests(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i >= 4) return 0;
+    portENTER_CRITICAL(&metricsMux);
+    uint32_t value = serverRequests[i];
+    portEXIT_CRITICAL(&metricsMux);
+    return sampleLine(out, size, f.name, "_total", "code", codeLabels[i], value);
+}
+
+static int sampleServerDuration(const MetricFamily& f, ScrapeState& st, uint16_t i, char* out, size_t size) {
+    if (i > serverDuration.bucketCount + 2) return 0;
+    return histogramLine(f, st, i, nullptr, nullptr, serverDuration, out, size);
+}
+
+static int samplePush(const MetricFamily& f, ScrapeState&, uint16_t i, char* out, size_t size) {
+    if (i > 0) return 0;
+    if (strstr(f.name, "mcast")) {
+        McastStats m;
+        getStateMulticastStats(m);
+        return sampleLine(out, size, f.name, "_total", nullptr, nullptr, m.datagrams);
+    }
+    if (strstr(f.name, "sse")) {
+        DashPushStats d;
+        getDashPushStats(d);
+        return sampleLine(out, size, f.name, "_total", nullptr, nullptr, d.events);
+    }
+    ControlSocketStats w;
+    getControlSocketStats(w);
+    return sampleLine(out, size, f.name, "_total", nullptr, nullptr, w.frames);
+}
+
+static const MetricFamily families[] = {
+    {"vent_temperature_celsius", "gauge", "celsius", "Temperatura prostora", sampleTemperature},
+    {"vent_humidity_percent", "gauge", "percent", "Relativna vlaga prostora", sampleHumidity},
+    {"vent_pressure_hpa", "gauge", "hpa", "Zračni tlak", samplePressure},
+    {"vent_co2_ppm", "gauge", "ppm", "CO2 v dnevnem prostoru", sampleCo2},
+    {"vent_fan_on", "gauge", nullptr, "Ventilator vklopljen (1/0)", sampleFanOn},
+    {"vent_fan_level", "gauge", nullptr, "Stopnja odvoda dnevnega prostora", sampleFanLevel},
+    {"vent_room_disabled", "gauge", nullptr, "Prostor ročno izklopljen (1/0)", sampleDisabled},
+    {"vent_drying_mode", "gauge", nullptr, "Način sušenja aktiven (1/0)", sampleDrying},
+    {"vent_sensor_error", "gauge", nullptr, "Napaka senzorja ali sistema (1/0)", sampleSensorError},
+    {"vent_supply_volts", "gauge", "volts", "Napajalne napetosti", sampleSupply},
+    {"vent_supply_sags", "counter", nullptr, "Padci 5 V od zagona", sampleSags},
+    {"vent_power_watts", "gauge", "watts", "Trenutna moč ventilatorjev", samplePower},
+    {"vent_energy_watthours", "gauge", "watthours", "Poraba v tekočem mesecu", sampleEnergy},
+    {"vent_uptime_seconds", "gauge", "seconds", "Čas od zagona", sampleUptime},
+    {"vent_heap_bytes", "gauge", "bytes", "Notranji heap", sampleHeap},
+    {"vent_psram_bytes", "gauge", "bytes", "PSRAM", samplePsram},
+    {"vent_peer_online", "gauge", nullptr, "Enota dosegljiva po liveness (1/0)", samplePeerOnline},
+    {"vent_peer_rtt_seconds", "gauge", "seconds", "Glajen RTT pinga (SRTT)", samplePeerRtt},
+    {"vent_outbox_events", "gauge", nullptr, "Dogodki, ki čakajo dostavo", sampleOutboxEvents},
+    {"vent_outbox_dropped", "counter", nullptr, "Dogodki zavrženi ob prelivu outboxa", sampleOutboxDropped},
+    {"vent_http_client_requests", "counter", nullptr, "Zahtevki httppool", sampleHttpClient},
+    {"vent_http_client_connects", "counter", nullptr, "Nove TCP povezave httppool", sampleHttpClient},
+    {"vent_http_client_retries", "counter", nullptr, "Ponovljeni poskusi httppool", sampleHttpClient},
+    {"vent_http_client_timeouts", "counter", nullptr, "Poskusi s pretečenim rokom", sampleHttpClient},
+    {"vent_http_client_failures", "counter", nullptr, "Zahtevki, ki niso uspeli do roka", sampleHttpClient},
+    {"vent_http_client_duration_seconds", "histogram", "seconds", "Trajanje zahtevka s ponovitvami",
+     sampleClientDuration},
+    {"vent_http_server_requests", "counter", nullptr, "Zahtevki web strežnika po razredu kode", sampleServerRequests},
+    {"vent_http_server_duration_seconds", "histogram", "seconds", "Čas v handlerju web strežnika",
+     sampleServerDuration},
+    {"vent_mcast_datagrams", "counter", nullptr, "Multicast datagrami stanja", samplePush},
+    {"vent_sse_events", "counter", nullptr, "Sporočila /events nadzorni plošči", samplePush},
+    {"vent_ws_frames", "counter", nullptr, "Prejeti okvirji /ws", samplePush},
+};
+#define METRICS_FAMILY_COUNT (sizeof(families) / sizeof(families[0]))
+
+// Naslednja vrstica odgovora v st.line; false, ko je telo končano
+static bool nextLine(ScrapeState& st) {
+    int n = 0;
+    while (n <= 0) {
+        if (st.phase == 5) return false;
+        if (st.phase == 4) {
+            n = snprintf(st.line, sizeof(st.line), "# EOF\n");
+            st.phase = 5;
+            break;
+        }
+        const MetricFamily& f = families[st.family];
+        switch (st.phase) {
+            case 0:
+                n = snprintf(st.line, sizeof(st.line), "# TYPE %s %s\n", f.name, f.type);
+                st.phase = f.unit ? 1 : 2;
+                break;
+            case 1:
+                n = snprintf(st.line, sizeof(st.line), "# UNIT %s %s\n", f.name, f.unit);
+                st.phase = 2;
+                break;
+            case 2:
+                n = snprintf(st.line, sizeof(st.line), "# HELP %s %s\n", f.name, f.help);
+                st.phase = 3;
+                st.sample = 0;
+                break;
+            default:
+                n = f.sample(f, st, st.sample++, st.line, sizeof(st.line));
+                if (n <= 0) {
+                    st.phase = ++st.family < METRICS_FAMILY_COUNT ? 0 : 4;
+                }
+                break;
+        }
+    }
+    st.lineLen = n < (int)sizeof(st.line) ? n : sizeof(st.line) - 1;
+    st.lineOff = 0;
+    return true;
+}
+
+static void handleMetrics(AsyncWebServerRequest* request) {
+    ScrapeState st = {};
+    AsyncWebServerResponse* response = request->beginChunkedResponse(METRICS_CONTENT_TYPE,
+        [st](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+            size_t written = 0;
+            while (written < maxLen) {
+                if (st.lineOff == st.lineLen && !nextLine(st)) break;
+                size_t n = min((size_t)(st.lineLen - st.lineOff), maxLen - written);
+                memcpy(buffer + written, st.line + st.lineOff, n);
+                written += n;
+                st.lineOff += n;
+            }
+            return written;
+        });
+    request->send(response);
+}
+
+void initMetrics(AsyncWebServer& server) {
+    for (int i = 0; i < METRICS_PEERS; i++) {
+        initHistogram(clientDuration[i], clientBoundsUs, sizeof(clientBoundsUs) / sizeof(clientBoundsUs[0]));
+    }
+    initHistogram(serverDuration, serverBoundsUs, sizeof(serverBoundsUs) / sizeof(serverBoundsUs[0]));
+
+    // Čas handlerja do request->send(); pošiljanje telesa teče kasneje v async_tcp
+    server.addMiddleware([](AsyncWebServerRequest* request, ArMiddlewareNext next) {
+        int64_t start = esp_timer_get_time();
+        next();
+        observe(serverDuration, (uint32_t)(esp_timer_get_time() - start));
+        AsyncWebServerResponse* response = request->getResponse();
+        int code = response ? response->code() : 0;
+        int cls = code >= 200 && code < 300 ? 0 : code >= 400 && code < 500 ? 1 : code >= 500 ? 2 : 3;
+        portENTER_CRITICAL(&metricsMux);
+        serverRequests[cls]++;
+        portEXIT_CRITICAL(&metricsMux);
+    });
+    server.on("/metrics", HTTP_GET, handleMetrics);
+}
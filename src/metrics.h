@@ -0,0 +1,36 @@
+// metrics.h - OpenMetrics /metrics endpoint
+//
+// /metrics vrne stanje v besedilnem formatu OpenMetrics (Prometheus): senzorje,
+// ventilatorje, napajanje in energijo, heap/PSRAM, enote (liveness, outbox),
+// števce HTTP odjemalca (httppool) in strežnika ter histograme trajanja.
+// Družine metrik so statična tabela; telo se pošilja po kosih (chunked) in
+// vsaka vrstica se formatira šele, ko je prostor v TCP bufferju - brez Stringa,
+// ki bi rasel z velikostjo odgovora.
+//
+// Histogrami se polnijo iz glavne zanke (httppool, metricsObserveHttpClient)
+// in iz async_tcp taska (middleware strežnika), zato je dostop zaščiten s portMUX.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "httppool.h"
+
+#define METRICS_HISTOGRAM_BUCKETS 10
+
+struct MetricsHistogram {
+    const uint32_t* boundsUs;           // zgornje meje vedrov (le), naraščajoče
+    uint8_t bucketCount;                // brez +Inf
+    uint32_t counts[METRICS_HISTOGRAM_BUCKETS + 1];   // nekumulativno, zadnji = +Inf
+    uint32_t count;
+    uint64_t sumUs;
+};
+
+// Registrira /metrics in merjenje zahtevkov strežnika (iz setupWebServer)
+void initMetrics(AsyncWebServer& server);
+
+// Zaključen zahtevek httppool (HTTP_POOL_SUPERSEDED ni bil poslan - se ne šteje)
+void metricsObserveHttpClient(HttpPeerId peer, int code, uint32_t elapsedMs);
+
+#endif // METRICS_H
@@ -0,0 +1,240 @@
+// mqtt.cpp - MQTT telemetry publisher and command subscriber
+
+#include "mqtt.h"
+
+#ifdef MQTT_TELEMETRY
+
+#include <AsyncMqttClient.h>
+#include <math.h>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "httppool.h"
+#include "wirearena.h"
+#include "message_fields.h"
+#include "web.h"
+#include "http.h"
+#include "statemsg.h"
+
+#define MQTT_PAYLOAD_MAX 256
+#define MQTT_TOPIC_MAX 64
+#define MQTT_STATUS_TOPIC MQTT_TOPIC_PREFIX "/status"
+#define MQTT_CMD_TOPIC MQTT_TOPIC_PREFIX "/cmd/"
+
+static AsyncMqttClient mqtt;
+static volatile bool connected = false;
+static volatile bool connecting = false;
+static volatile bool resync = false;        // po povezavi objavi vse skupine
+static uint8_t failures = 0;
+static unsigned long nextConnect = 0;
+static unsigned long lastTick = 0;
+static MqttStats stats;
+
+// Samo async_tcp task (onMessage)
+static WireDocument<128> cmdDoc;
+
+// Float na decimals mest; NaN (senzor še ni prebran) kot null
+static const char* fmtFloat(char* out, size_t size, float value, int decimals) {
+    if (!isfinite(value)) snprintf(out, size, "null");
+    else snprintf(out, size, "%.*f", decimals, value);
+    return out;
+}
+
+static const char* fmtBool(bool value) {
+    return value ? "true" : "false";
+}
+
+static int formatBathroom(char* out, size_t size) {
+    char t[12], h[12], p[12];
+    return snprintf(out, size,
+        "{\"temp\":%s,\"humidity\":%s,\"pressure\":%s,\"fan\":%s,\"disabled\":%s,\"light1\":%s,\"light2\":%s,"
+        "\"button\":%s,\"drying\":%s,\"cycle_mode\":%d,\"off_time\":%lu}",
+        fmtFloat(t, sizeof(t), currentData.bathroomTemp, 1), fmtFloat(h, sizeof(h), currentData.bathroomHumidity, 1),
+        fmtFloat(p, sizeof(p), currentData.bathroomPressure, 0), fmtBool(currentData.bathroomFan),
+        fmtBool(currentData.disableBathroom), fmtBool(currentData.bathroomLight1), fmtBool(currentData.bathroomLight2),
+        fmtBool(currentData.bathroomButton), fmtBool(currentData.bathroomDryingMode), currentData.bathroomCycleMode,
+        (unsigned long)bathroomReportedOffTime());
+}
+
+static int formatUtility(char* out, size_t size) {
+    char t[12], h[12];
+    return snprintf(out, size,
+        "{\"temp\":%s,\"humidity\":%s,\"fan\":%s,\"disabled\":%s,\"light\":%s,\"switch\":%s,"
+        "\"drying\":%s,\"cycle_mode\":%d,\"off_time\":%lu}",
+        fmtFloat(t, sizeof(t), currentData.utilityTemp, 1), fmtFloat(h, sizeof(h), currentData.utilityHumidity, 1),
+        fmtBool(currentData.utilityFan), fmtBool(currentData.disableUtility), fmtBool(currentData.utilityLight),
+        fmtBool(currentData.utilitySwitch), fmtBool(currentData.utilityDryingMode), currentData.utilityCycleMode,
+        (unsigned long)utilityReportedOffTime());
+}
+
+static int formatWc(char* out, size_t size) {
+    return snprintf(out, size, "{\"fan\":%s,\"disabled\":%s,\"light\":%s,\"off_time\":%lu}",
+        fmtBool(currentData.wcFan), fmtBool(currentData.disableWc), fmtBool(currentData.wcLight),
+        (unsigned long)currentData.offTimes[2]);
+}
+
+static int formatLiving(char* out, size_t size) {
+    char t[12], h[12], d[12];
+    return snprintf(out, size,
+        "{\"temp\":%s,\"humidity\":%s,\"co2\":%u,\"fan_level\":%u,\"duty_cycle\":%s,\"disabled\":%s,"
+        "\"window1\":%s,\"window2\":%s,\"off_time\":%lu}",
+        fmtFloat(t, sizeof(t), currentData.livingTemp, 1), fmtFloat(h, sizeof(h), currentData.livingHumidity, 1),
+        currentData.livingCO2, currentData.livingExhaustLevel, fmtFloat(d, sizeof(d), currentData.livingRoomDutyCycle, 1),
+        fmtBool(currentData.disableLivingRoom), fmtBool(currentData.windowSensor1), fmtBool(currentData.windowSensor2),
+        (unsigned long)currentData.offTimes[4]);
+}
+
+static int formatExternal(char* out, size_t size) {
+    char t[12], h[12], p[12];
+    return snprintf(out, size, "{\"temp\":%s,\"humidity\":%s,\"pressure\":%s,\"valid\":%s}",
+        fmtFloat(t, sizeof(t), currentData.externalTemp, 1), fmtFloat(h, sizeof(h), currentData.externalHumidity, 1),
+        fmtFloat(p, sizeof(p), currentData.externalPressure, 1), fmtBool(externalDataValid));
+}
+
+// Analogne meritve zaokrožene, da šum ne sproži objave vsak tick
+static int formatPower(char* out, size_t size) {
+    char v3[12], v5[12], w[12], e[12];
+    return snprintf(out, size, "{\"supply_3v3\":%s,\"supply_5v\":%s,\"power\":%s,\"energy\":%s,\"sags\":%lu}",
+        fmtFloat(v3, sizeof(v3), currentData.supply3V3, 1), fmtFloat(v5, sizeof(v5), currentData.supply5V, 1),
+        fmtFloat(w, sizeof(w), currentData.currentPower, 0), fmtFloat(e, sizeof(e), currentData.energyConsumption, 0),
+        (unsigned long)currentData.supplySagCount);
+}
+
+static int formatSystem(char* out, size_t size) {
+    return snprintf(out, size,
+        "{\"error_flags\":%u,\"time_synced\":%s,\"rew_online\":%s,\"ut_dew_online\":%s,\"kop_dew_online\":%s}",
+        currentData.errorFlags, fmtBool(timeSynced), fmtBool(rewStatus.isOnline), fmtBool(utDewStatus.isOnline),
+        fmtBool(kopDewStatus.isOnline));
+}
+
+struct MqttGroup {
+    const char* name;
+    int (*format)(char* out, size_t size);
+};
+
+static const MqttGroup groups[] = {
+    {"kop", formatBathroom},
+    {"ut", formatUtility},
+    {"wc", formatWc},
+    {"ds", formatLiving},
+    {"ext", formatExternal},
+    {"power", formatPower},
+    {"system", formatSystem},
+};
+#define MQTT_GROUP_COUNT (sizeof(groups) / sizeof(groups[0]))
+
+static uint32_t lastHash[MQTT_GROUP_COUNT];     // 0 = še ni objavljeno
+
+// FNV-1a - sprememba skupine brez hranjenja celega besedila
+static uint32_t payloadHash(const char* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static void publishChangedGroups() {
+    char payload[MQTT_PAYLOAD_MAX];
+    char topic[MQTT_TOPIC_MAX];
+    for (size_t i = 0; i < MQTT_GROUP_COUNT; i++) {
+        int length = groups[i].format(payload, sizeof(payload));
+        if (length <= 0 || length >= (int)sizeof(payload)) {
+            LOG_ERROR("MQTT", "Skupina %s presega %d B", groups[i].name, MQTT_PAYLOAD_MAX);
+            continue;
+        }
+        uint32_t hash = payloadHash(payload, length);
+        if (hash == lastHash[i]) continue;
+        snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/state/%s", groups[i].name);
+        if (mqtt.publish(topic, MQTT_QOS, true, payload, length) == 0) {
+            stats.deferred++;       // TCP buffer poln - preostale skupine naslednji tick
+            return;
+        }
+        lastHash[i] = hash;
+        stats.published++;
+    }
+}
+
+static void onMqttConnect(bool sessionPresent) {
+    connected = true;
+    connecting = false;
+    resync = true;
+    stats.connects++;
+    mqtt.subscribe(MQTT_CMD_TOPIC "+", MQTT_QOS);
+    mqtt.publish(MQTT_STATUS_TOPIC, 1, true, "online");
+    LOG_INFO("MQTT", "Povezan z %s:%d", MQTT_HOST, MQTT_PORT);
+}
+
+static void onMqttDisconnect(AsyncMqttClientDisconnectReason reason) {
+    if (connected) LOG_WARN("MQTT", "Povezava prekinjena (razlog %d)", (int)reason);
+    connected = false;
+    connecting = false;
+}
+
+// Ukaz: <prefix>/cmd/<soba>, telo = akcija (kot MANUAL_CONTROL)
+static void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties,
+                          size_t len, size_t index, size_t total) {
+    if (strncmp(topic, MQTT_CMD_TOPIC, strlen(MQTT_CMD_TOPIC)) != 0) return;
+    if (index != 0 || len != total) return;     // ukaz je kratek - razdeljen ni veljaven
+    stats.commands++;
+
+    char action[16];
+    size_t n = len < sizeof(action) - 1 ? len : sizeof(action) - 1;
+    memcpy(action, payload, n);             // payload ni zaključen z ničlo
+    action[n] = '\0';
+    while (n > 0 && isspace((unsigned char)action[n - 1])) action[--n] = '\0';
+
+    cmdDoc.clear();
+    cmdDoc[FIELD_ROOM] = (const char*)(topic + strlen(MQTT_CMD_TOPIC));
+    cmdDoc[FIELD_ACTION] = (const char*)action;
+    const char* error = applyManualControl(cmdDoc);
+    if (error) {
+        stats.commandsRejected++;
+        LOG_WARN("MQTT", "Ukaz %s='%s' zavrnjen: %s", topic, action, error);
+    }
+}
+
+void initMqtt() {
+    IPAddress broker;
+    broker.fromString(MQTT_HOST);
+    mqtt.setServer(broker, MQTT_PORT);
+    mqtt.setClientId(MQTT_CLIENT_ID);
+    mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+    if (strlen(MQTT_USER) > 0) mqtt.setCredentials(MQTT_USER, MQTT_PASSWORD);
+    mqtt.setWill(MQTT_STATUS_TOPIC, 1, true, "offline");
+    mqtt.onConnect(onMqttConnect);
+    mqtt.onDisconnect(onMqttDisconnect);
+    mqtt.onMessage(onMqttMessage);
+    LOG_INFO("MQTT", "Broker %s:%d, teme %s/#, QoS %d", MQTT_HOST, MQTT_PORT, MQTT_TOPIC_PREFIX, MQTT_QOS);
+}
+
+void mqttService() {
+    unsigned long now = millis();
+    if (!connected) {
+        if (connecting || (long)(now - nextConnect) < 0) return;
+        // Naslednji poskus po backoffu; uspešna povezava ga ponastavi
+        nextConnect = now + httpBackoffMs(MQTT_RECONNECT_MIN_MS, MQTT_RECONNECT_MAX_MS, failures);
+        if (failures < 16) failures++;
+        connecting = true;
+        mqtt.connect();
+        return;
+    }
+    failures = 0;
+
+    if (resync) {
+        resync = false;
+        memset(lastHash, 0, sizeof(lastHash));
+        lastTick = 0;
+    }
+    if (lastTick != 0 && now - lastTick < MQTT_TICK_MS) return;
+    lastTick = now ? now : 1;
+    publishChangedGroups();
+}
+
+void getMqttStats(MqttStats& out) {
+    out = stats;
+    out.connected = connected;
+}
+
+#endif // MQTT_TELEMETRY
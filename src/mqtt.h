@@ -0,0 +1,39 @@
+// mqtt.h - MQTT telemetry publisher and command subscriber
+//
+// Vklop z okoljem esp32-s3-eth-mqtt (-DMQTT_TELEMETRY, broker in teme v config.h). Stanje
+// CEE je razdeljeno v skupine (kop, ut, wc, ds, ext, power, system); vsaka je
+// en JSON na retained temi MQTT_TOPIC_PREFIX "/state/<skupina>". Vsak
+// MQTT_TICK_MS se vse skupine formatirajo in objavijo le spremenjene - ena
+// objava na skupino, vse v istem prehodu. Ob (ponovni) povezavi gredo vse.
+//
+// Ukazi: MQTT_TOPIC_PREFIX "/cmd/<wc|ut|kop|ds>" s telesom manual, toggle ali
+// drying - isto kot MANUAL_CONTROL (applyManualControl v web.h).
+// Razpoložljivost: MQTT_TOPIC_PREFIX "/status" = online / offline (LWT).
+//
+// Nič ne blokira: povezava in objave gredo prek AsyncTCP, nedosegljiv broker
+// se poskuša znova z backoffom (MQTT_RECONNECT_MIN_MS .. MQTT_RECONNECT_MAX_MS),
+// objava, ki ne gre v TCP buffer, počaka na naslednji tick.
+// Preverjanje z mosquitto na računalniku: tools/mqtt_check.py.
+
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <Arduino.h>
+
+struct MqttStats {
+    bool connected;
+    uint32_t connects;
+    uint32_t published;       // objave skupin
+    uint32_t deferred;        // objava ni šla v buffer - ponovno naslednji tick
+    uint32_t commands;
+    uint32_t commandsRejected;
+};
+
+void initMqtt();
+
+// Iz glavne zanke: povezovanje in objava spremenjenih skupin
+void mqttService();
+
+void getMqttStats(MqttStats& stats);
+
+#endif // MQTT_H
@@ -0,0 +1,171 @@
+// outbox.cpp - Coalescing store-and-forward queue for REW and DEW units
+
+#include "outbox.h"
+#include "config.h"
+#include "logging.h"
+#include "liveness.h"
+
+#define OUTBOX_NO_SLOT 0xFF
+
+struct OutboxPeer {
+    bool statePending;
+    bool inFlight;
+    uint8_t sending;            // slot dogodka v teku; OUTBOX_NO_SLOT = stanje
+    uint8_t head;
+    uint8_t count;
+    uint8_t order[OUTBOX_EVENTS_MAX];       // sloti neposlanih dogodkov, najstarejši v head
+    uint8_t failures;
+    unsigned long nextAt;       // backoff ali tempo praznjenja
+    OutboxStats stats;
+};
+
+static OutboxPeer boxes[HTTP_PEER_COUNT];
+static OutboxEvent eventPool[OUTBOX_EVENTS_MAX];     // skupen za vse enote
+static bool slotUsed[OUTBOX_EVENTS_MAX];
+static OutboxStateSender sendState = nullptr;
+static OutboxEventSender sendEvent = nullptr;
+
+void initOutbox(OutboxStateSender stateSender, OutboxEventSender eventSender) {
+    sendState = stateSender;
+    sendEvent = eventSender;
+    for (int i = 0; i < HTTP_PEER_COUNT; i++) boxes[i].sending = OUTBOX_NO_SLOT;
+}
+
+void outboxPostState(HttpPeerId peer) {
+    if (peer < HTTP_PEER_COUNT) boxes[peer].statePending = true;
+}
+
+static void dropEvent(HttpPeerId peer, uint8_t slot) {
+    boxes[peer].stats.dropped++;
+    slotUsed[slot] = false;
+    LOG_WARN("HTTP", "%s: outbox poln (%d), zavržen dogodek iz %lu",
+             httpPeerName(peer), OUTBOX_EVENTS_MAX, (unsigned long)eventPool[slot].timestamp);
+}
+
+static uint8_t popEvent(OutboxPeer& b) {
+    uint8_t slot = b.order[b.head];
+    b.head = (b.head + 1) % OUTBOX_EVENTS_MAX;
+    b.count--;
+    return slot;
+}
+
+bool outboxPushEvent(HttpPeerId peer, uint32_t timestamp, const uint8_t* state, size_t length) {
+    if (peer >= HTTP_PEER_COUNT || length > sizeof(eventPool[0].state)) return false;
+    OutboxPeer& b = boxes[peer];
+    int slot = 0;
+    while (slot < OUTBOX_EVENTS_MAX && slotUsed[slot]) slot++;
+    if (slot == OUTBOX_EVENTS_MAX) {
+        if (b.count == 0) return false;
+        slot = popEvent(b);
+        dropEvent(peer, slot);
+    }
+    slotUsed[slot] = true;
+    eventPool[slot].timestamp = timestamp;
+    eventPool[slot].length = length;
+    memcpy(eventPool[slot].state, state, length);
+    b.order[(b.head + b.count) % OUTBOX_EVENTS_MAX] = slot;
+    b.count++;
+    b.statePending = false;     // dogodek nosi tudi zadnje stanje
+    return true;
+}
+
+// Neposlan dogodek nazaj na začetek zaostanka (ostane najstarejši)
+static void requeueEvent(OutboxPeer& b) {
+    b.head = (b.head + OUTBOX_EVENTS_MAX - 1) % OUTBOX_EVENTS_MAX;
+    b.order[b.head] = b.sending;
+    b.count++;
+    b.sending = OUTBOX_NO_SLOT;
+}
+
+void outboxDone(HttpPeerId peer, int code) {
+    if (peer >= HTTP_PEER_COUNT || !boxes[peer].inFlight) return;   // poslano mimo outboxa
+    OutboxPeer& b = boxes[peer];
+    unsigned long now = millis();
+    b.inFlight = false;
+
+    // 4xx: enota je dosegljiva, sporočilo pa zavrnjeno - ponavljanje ne pomaga
+    if (code > 0 && code < 500) {
+        if (b.failures > 0) {
+            LOG_INFO("HTTP", "%s: outbox spet dostavlja po %u neuspehih, v zaostanku %u dogodkov",
+                     httpPeerName(peer), b.failures, b.count);
+        }
+        b.failures = 0;
+        b.stats.delivered++;
+        if (b.sending != OUTBOX_NO_SLOT) slotUsed[b.sending] = false;
+        b.sending = OUTBOX_NO_SLOT;
+        b.nextAt = now + OUTBOX_DRAIN_INTERVAL_MS;
+        return;
+    }
+
+    if (b.sending != OUTBOX_NO_SLOT) requeueEvent(b);
+    else b.statePending = true;
+    if (code == HTTP_POOL_SUPERSEDED) return;       // ni bil poslan - brez backoffa
+
+    if (b.failures < 16) b.failures++;
+    b.stats.retries++;
+    uint32_t backoff = httpBackoffMs(OUTBOX_BACKOFF_MIN_MS, OUTBOX_BACKOFF_MAX_MS, b.failures);
+    b.nextAt = now + backoff;
+    LOG_DEBUG("HTTP", "%s: outbox neuspeh %d (%u zapored), naslednji poskus čez %lu ms",
+              httpPeerName(peer), code, b.failures, (unsigned long)backoff);
+}
+
+void outboxWake(HttpPeerId peer) {
+    if (peer < HTTP_PEER_COUNT && boxes[peer].failures > 0) boxes[peer].nextAt = millis();
+}
+
+void outboxGetStats(HttpPeerId peer, OutboxStats& stats) {
+    if (peer >= HTTP_PEER_COUNT) {
+        memset(&stats, 0, sizeof(stats));
+        return;
+    }
+    const OutboxPeer& b = boxes[peer];
+    stats = b.stats;
+    stats.statePending = b.statePending;
+    stats.events = b.count + (b.sending != OUTBOX_NO_SLOT ? 1 : 0);
+    stats.failures = b.failures;
+    long wait = (long)(b.nextAt - millis());
+    stats.retryInMs = b.failures > 0 && wait > 0 ? wait : 0;
+}
+
+static void sendNextEvent(HttpPeerId peer, unsigned long now) {
+    OutboxPeer& b = boxes[peer];
+    b.sending = popEvent(b);
+    b.inFlight = true;
+    if (!sendEvent(peer, eventPool[b.sending])) {
+        b.inFlight = false;
+        requeueEvent(b);
+        b.nextAt = now + OUTBOX_DRAIN_INTERVAL_MS;
+    }
+}
+
+void outboxService() {
+    if (!sendState || !sendEvent) return;
+    unsigned long now = millis();
+
+    // Dogodki po vrsti za vsako enoto, stanje vsem pripravljenim naenkrat
+    uint8_t stateMask = 0;
+    for (int i = 0; i < HTTP_PEER_COUNT; i++) {
+        OutboxPeer& b = boxes[i];
+        // Nedosegljiva enota: stanje in dogodki čakajo, liveness ob vrnitvi sproži outboxWake
+        if (b.inFlight || !livenessUsable((HttpPeerId)i) || (long)(now - b.nextAt) < 0) continue;
+        if (b.count > 0) {
+            sendNextEvent((HttpPeerId)i, now);
+        } else if (b.statePending) {
+            stateMask |= 1 << i;
+            b.inFlight = true;
+        }
+    }
+    if (stateMask == 0) return;
+
+    uint8_t queued = sendState(stateMask);
+    for (int i = 0; i < HTTP_PEER_COUNT; i++) {
+        if (!(stateMask & (1 << i))) continue;
+        OutboxPeer& b = boxes[i];
+        if (queued & (1 << i)) {
+            b.statePending = false;
+        } else {
+            b.inFlight = false;
+            b.nextAt = now + OUTBOX_DRAIN_INTERVAL_MS;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+// outbox.h - Coalescing store-and-forward queue for REW and DEW units
+//
+// Za vsako enoto outbox hrani zastavico "stanje čaka" in omejen zaostanek
+// dogodkov. Stanje se ne shranjuje: sporočilo se zgradi šele ob pošiljanju iz
+// trenutnih podatkov, zato se vse vmesne spremembe združijo v najnovejšo.
+// Dogodki (npr. prehod napake) se ne smejo izgubiti, zato hranijo posnetek
+// stanja (MessagePack) s časom nastanka. Gredo po vrsti pred stanjem. Vse
+// enote si delijo statičen bazen OUTBOX_EVENTS_MAX dogodkov; ko je poln, se
+// zavrže najstarejši dogodek iste enote.
+//
+// Na enoto je v teku največ eno sporočilo. Po neuspehu outbox poskuša znova
+// z eksponentnim backoffom z naključnim zamikom (OUTBOX_BACKOFF_MIN_MS ..
+// OUTBOX_BACKOFF_MAX_MS). Enoti, ki je liveness.h ne vidi, ne pošilja; ob
+// njeni vrnitvi se zaostanek prazni z največ enim sporočilom na
+// OUTBOX_DRAIN_INTERVAL_MS.
+//
+// Vse funkcije samo iz glavne zanke (callbacki httppool tečejo v njej).
+
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "httppool.h"
+
+struct OutboxEvent {
+    uint32_t timestamp;       // Unix čas nastanka (lokalni, kot offTimes)
+    uint16_t length;
+    uint8_t state[STATUS_SNAPSHOT_MAX];   // polno stanje ob dogodku (MessagePack)
+};
+
+// Pošlje stanje enotam iz maske (bit na HttpPeerId) - sporočilo se zgradi enkrat;
+// vrne masko enot, za katere je zahtevek v vrsti
+typedef uint8_t (*OutboxStateSender)(uint8_t peers);
+// Pošlje dogodek; true, ko je zahtevek v vrsti
+typedef bool (*OutboxEventSender)(HttpPeerId peer, const OutboxEvent& event);
+
+struct OutboxStats {
+    bool statePending;
+    uint8_t events;           // dogodki v zaostanku
+    uint8_t failures;         // zaporedni neuspehi (eksponent backoffa)
+    uint32_t delivered;
+    uint32_t retries;
+    uint32_t dropped;         // dogodki zavrženi ob prelivu
+    uint32_t retryInMs;       // do naslednjega poskusa (0 = takoj)
+};
+
+void initOutbox(OutboxStateSender stateSender, OutboxEventSender eventSender);
+
+// Stanje enote se je spremenilo (ali je čas za periodično pošiljanje)
+void outboxPostState(HttpPeerId peer);
+// Dogodek s posnetkom stanja; nadomesti tudi čakajoče stanje.
+// false, če je posnetek prevelik ali ni prostora (enota nima dogodka za zavreči)
+bool outboxPushEvent(HttpPeerId peer, uint32_t timestamp, const uint8_t* state, size_t length);
+// Rezultat poslanega sporočila (iz HttpDoneCallback)
+void outboxDone(HttpPeerId peer, int code);
+// Enota je spet dosegljiva (ping, prejet zahtevek) - ne čakaj na backoff
+void outboxWake(HttpPeerId peer);
+
+void outboxGetStats(HttpPeerId peer, OutboxStats& stats);
+
+// Iz glavne zanke, pred httpPoolService()
+void outboxService();
+
+#endif // OUTBOX_H
@@ -6,11 +6,17 @@
 
 // SdFat object
 SdFat SD;
+SemaphoreHandle_t sdMutex = NULL;
+static bool sdReady = false;
 
 bool initSD() {
     // Initialize SPI for SD card
     SPI.begin(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_CS_PIN);
 
+    if (sdMutex == NULL) {
+        sdMutex = xSemaphoreCreateMutex();
+    }
+
     if (!SD.begin(SD_CS_PIN, SPI_FULL_SPEED)) {
         Serial.println("SD: Card not present");
         return false;
@@ -27,5 +33,10 @@ bool initSD() {
     uint64_t cardSizeMB = cardSize / (1024 * 1024);
     Serial.printf("SD: Card present, size: %llu MB\n", cardSizeMB);
 
+    sdReady = true;
     return true;
 }
+
+bool isSDReady() {
+    return sdReady;
+}
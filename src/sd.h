@@ -2,7 +2,15 @@
 #ifndef SD_H
 #define SD_H
 
+#include <SdFat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+extern SdFat SD;
+extern SemaphoreHandle_t sdMutex;   // dostop do kartice iz več taskov (log sink, web)
+
 // Function declarations
 bool initSD();
+bool isSDReady();
 
 #endif // SD_H
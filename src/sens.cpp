@@ -3,6 +3,65 @@
 #include "sens.h"
 #include <functional>
 
+I2CStats i2cStats = {};
+
+// Zgornje meje vedrc histograma latenc (ms), zadnje vedro je odprto (>100 ms)
+const uint16_t i2cLatencyBucketsMs[I2C_LATENCY_BUCKETS] = {1, 2, 5, 10, 20, 50, 100, 0xFFFF};
+
+static I2CDeviceStats* statsForAddress(uint8_t address) {
+    if (address == SHT41_ADDRESS) return &i2cStats.sht41;
+    if (address == BME280_ADDRESS) return &i2cStats.bme280;
+    return nullptr;
+}
+
+// Zadnja napaka, vbrizgana med tekočim branjem senzorja (za lostControlTicksByFault)
+static I2CFaultMode readFault = I2C_FAULT_NONE;
+
+#ifdef I2C_FAULT_INJECTION
+// Urnik vbrizganih napak - vsaka injekcija zmanjša števec, ob 0 se urnik konča
+static I2CFaultMode injectedFault = I2C_FAULT_NONE;
+static uint8_t injectedFaultAddress = 0;   // 0 = vse naprave
+static uint16_t injectedFaultCount = 0;
+
+void scheduleI2CFault(I2CFaultMode mode, uint8_t address, uint16_t count) {
+    injectedFault = count > 0 ? mode : I2C_FAULT_NONE;
+    injectedFaultAddress = address;
+    injectedFaultCount = count;
+    LOG_WARN("I2C", "Fault injection: mode=%d addr=0x%02X count=%u", mode, address, count);
+}
+
+static bool takeInjectedFault(I2CFaultMode mode, uint8_t address) {
+    if (injectedFault != mode || injectedFaultCount == 0) return false;
+    if (injectedFaultAddress != 0 && address != 0 && injectedFaultAddress != address) return false;
+    if (--injectedFaultCount == 0) injectedFault = I2C_FAULT_NONE;
+    readFault = mode;
+    return true;
+}
+#else
+static inline bool takeInjectedFault(I2CFaultMode, uint8_t) { return false; }
+#endif
+
+// Izgubljeni krmilni cikli enega branja, pripisani scenariju vbrizgane napake
+static void recordLostTicks(unsigned long startMs, unsigned long endMs) {
+    uint32_t ticks = (endMs - startMs) / CONTROL_TICK_MS;
+    i2cStats.lostControlTicks += ticks;
+    i2cStats.lostControlTicksByFault[readFault] += ticks;
+    readFault = I2C_FAULT_NONE;
+}
+
+static void recordReadLatency(I2CDeviceStats* stats, unsigned long latencyMs) {
+    if (!stats) return;
+    stats->transactions++;
+    stats->lastLatencyMs = latencyMs > 0xFFFF ? 0xFFFF : latencyMs;
+    if (stats->lastLatencyMs > stats->maxLatencyMs) stats->maxLatencyMs = stats->lastLatencyMs;
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        if (latencyMs <= i2cLatencyBucketsMs[i]) {
+            stats->latencyHist[i]++;
+            break;
+        }
+    }
+}
+
 void initI2CBus(bool force) {
     // Initialize I2C bus only once, unless force is true
     static bool i2cInitialized = false;
@@ -14,6 +73,7 @@ void initI2CBus(bool force) {
             pinMode(PIN_I2C_SCL, INPUT);
             delay(10);
             Wire.end(); // Cleanup if already initialized
+            i2cStats.busReinits++;
         }
         
         if (!Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL)) {
@@ -39,8 +99,6 @@ void initI2CBus(bool force) {
 }
 
 void initSensors() {
-    char logMessage[256];
-
     // Initialize I2C bus
     initI2CBus();
 
@@ -134,11 +192,8 @@ void initSensors() {
         LOG_INFO("BME280", "Sensor not detected on I2C bus");
     }
 
-    // Initial read of power supplies
-    uint32_t adc5V_init  = analogRead(2);
-    uint32_t adc3V3_init = analogRead(3);
-    currentData.supply5V  = (adc5V_init  * 3.3f / 4095.0f) * 2.13f;
-    currentData.supply3V3 = (adc3V3_init * 3.3f / 4095.0f) * 2.18f;
+    // Initial read of power supplies and start of continuous monitor
+    initSupplyMonitor();
 
     // Log final status
     if (sht41Present && bmePresent) {
@@ -160,12 +215,19 @@ bool readSensorWithRetry(
     float* tempOut, float* humOut, float* pressOut,
     const char* sensorName
 ) {
-    char logMessage[256];
+    I2CDeviceStats* stats = statsForAddress(address);
 
     // First attempt
     if (checkI2CDevice(address)) {
         float temp, hum = -999.0f, press = -999.0f;
-        if (readCallback(&temp, &hum, &press)) {
+        unsigned long readStart = millis();
+        bool readOk = readCallback(&temp, &hum, &press);
+        recordReadLatency(stats, millis() - readStart);
+        if (readOk && takeInjectedFault(I2C_FAULT_GARBAGE, address)) {
+            temp = 127.9f;
+            if (hum != -999.0f) hum = 255.0f;
+        }
+        if (readOk) {
             // Validate readings
             bool tempValid = (temp >= minTemp && temp <= maxTemp);
             bool humValid = (hum == -999.0f) || (hum >= minHum && hum <= maxHum);
@@ -177,6 +239,7 @@ bool readSensorWithRetry(
                 if (pressOut) *pressOut = press;
                 return true;
             } else {
+                if (stats) stats->invalidReads++;
                 LOG_WARN("Sensors", "Invalid %s data: T=%.1f°C, H=%.1f%%, P=%.1fhPa",
                         sensorName, temp, hum, press);
                 return false;
@@ -189,7 +252,14 @@ bool readSensorWithRetry(
 
     if (checkI2CDevice(address)) {
         float temp, hum = -999.0f, press = -999.0f;
-        if (readCallback(&temp, &hum, &press)) {
+        unsigned long readStart = millis();
+        bool readOk = readCallback(&temp, &hum, &press);
+        recordReadLatency(stats, millis() - readStart);
+        if (readOk && takeInjectedFault(I2C_FAULT_GARBAGE, address)) {
+            temp = 127.9f;
+            if (hum != -999.0f) hum = 255.0f;
+        }
+        if (readOk) {
             // Validate readings
             bool tempValid = (temp >= minTemp && temp <= maxTemp);
             bool humValid = (hum == -999.0f) || (hum >= minHum && hum <= maxHum);
@@ -201,6 +271,7 @@ bool readSensorWithRetry(
                 if (pressOut) *pressOut = press;
                 return true;
             } else {
+                if (stats) stats->invalidReads++;
                 LOG_ERROR("Sensors", "Invalid %s data after retry: T=%.1f°C, H=%.1f%%, P=%.1fhPa",
                         sensorName, temp, hum, press);
                 return false;
@@ -233,11 +304,43 @@ bool readBME280(float* temp, float* hum, float* press) {
     return true;
 }
 
-void readSensors() {
-    // Update timestamp if NTP is synced
-    if (timeSynced) {
-        currentData.timestamp = myTZ.now();
+// Adaptivno vzorčenje - stanje razporejevalnika za posamezen prostor
+struct RoomSampler {
+    unsigned long lastRead;   // millis() zadnjega branja
+    uint16_t intervalSec;     // trenutni efektivni interval
+    float refHumidity;        // vlaga na začetku okna SENSOR_READ_INTERVAL
+    unsigned long refAt;      // millis() začetka okna; 0 = še ni branja
+    bool rising;              // vlaga narašča (dvig >= SENSOR_HUM_RISE_FAST v oknu)
+};
+
+static RoomSampler utilitySampler = {0, SENSOR_READ_INTERVAL, 0, 0, false};
+static RoomSampler bathroomSampler = {0, SENSOR_READ_INTERVAL, 0, 0, false};
+
+// Trend vlage iz uspešnih branj: dvig za SENSOR_HUM_RISE_FAST glede na začetek okna
+// takoj vklopi "rising"; izklopi se šele po celem oknu brez takega dviga
+static void updateHumidityTrend(RoomSampler& s, float humidity) {
+    unsigned long now = millis();
+    if (s.refAt == 0) {
+        s.refHumidity = humidity;
+        s.refAt = now;
+        return;
+    }
+    bool rose = humidity - s.refHumidity >= SENSOR_HUM_RISE_FAST;
+    if (rose) s.rising = true;
+    if (now - s.refAt >= SENSOR_READ_INTERVAL * 1000UL) {
+        s.rising = rose;
+        s.refHumidity = humidity;
+        s.refAt = now;
     }
+}
+
+// Proračun časa na I2C vodilu za branje senzorjev (okno 60 s)
+static unsigned long busWindowStart = 0;
+static unsigned long busTimeInWindowMs = 0;
+
+static void readUtilitySensor() {
+    unsigned long start = millis();
+    readFault = I2C_FAULT_NONE;
 
     // Read SHT41 - always check presence first
     if (checkI2CDevice(SHT41_ADDRESS) && sht41Present) {
@@ -255,6 +358,7 @@ void readSensors() {
             currentData.errorFlags |= ERR_SHT41;
         } else {
             currentData.errorFlags &= ~ERR_SHT41;
+            updateHumidityTrend(utilitySampler, currentData.utilityHumidity);
         }
     } else {
         // Sensor not present or not properly initialized, set error flag
@@ -265,6 +369,15 @@ void readSensors() {
         }
     }
 
+    utilitySampler.lastRead = millis();
+    busTimeInWindowMs += utilitySampler.lastRead - start;
+    recordLostTicks(start, utilitySampler.lastRead);
+}
+
+static void readBathroomSensor() {
+    unsigned long start = millis();
+    readFault = I2C_FAULT_NONE;
+
     // Read BME280 - always check presence first
     if (checkI2CDevice(BME280_ADDRESS) && bmePresent) {
         if (!readSensorWithRetry(
@@ -281,6 +394,7 @@ void readSensors() {
             currentData.errorFlags |= ERR_BME280;
         } else {
             currentData.errorFlags &= ~ERR_BME280;
+            updateHumidityTrend(bathroomSampler, currentData.bathroomHumidity);
         }
     } else {
         // Sensor not present or not properly initialized, set error flag
@@ -291,14 +405,53 @@ void readSensors() {
         }
     }
 
-    // Read power supplies directly
-    uint32_t adc5V  = analogRead(2);   // GPIO2 za 5 V
-    uint32_t adc3V3 = analogRead(3);   // GPIO3 za 3,3 V
-    currentData.supply5V  = (adc5V  * 3.3f / 4095.0f) * 2.13f;
-    currentData.supply3V3 = (adc3V3 * 3.3f / 4095.0f) * 2.18f;
+    bathroomSampler.lastRead = millis();
+    busTimeInWindowMs += bathroomSampler.lastRead - start;
+    recordLostTicks(start, bathroomSampler.lastRead);
+}
+
+void readSensors() {
+    // Update timestamp if NTP is synced
+    if (timeSynced) {
+        currentData.timestamp = myTZ.now();
+    }
+
+    readUtilitySensor();
+    readBathroomSensor();
+
+    // Power supplies - povprečje okna od zadnjega branja (supply monitor task)
+    SupplyWindow supply;
+    if (takeSupplyWindow(supply)) {
+        currentData.supply5V  = supply.mean5V;
+        currentData.supply3V3 = supply.mean3V3;
+        currentData.supply5VMin = supply.min5V;
+        currentData.supply5VMax = supply.max5V;
+    }
 
     // Check power error
     bool powerError = (currentData.supply5V < 4.0f) || (currentData.supply3V3 < 3.0f);
+
+    // Novi padci 5 V od zadnjega branja - logiraj s korelacijo na preklop releja
+    static uint32_t reportedSags = 0;
+    uint32_t sagCount = getSupplySagCount();
+    if (sagCount != reportedSags) {
+        SupplySagEvent events[SUPPLY_SAG_LOG_SIZE];
+        uint32_t newSags = sagCount - reportedSags;
+        uint8_t n = getSupplySagEvents(events, newSags < SUPPLY_SAG_LOG_SIZE ? newSags : SUPPLY_SAG_LOG_SIZE);
+        for (int i = n - 1; i >= 0; i--) {
+            if (events[i].relayPin != 0) {
+                LOG_WARN("Sensors", "Padec 5V: min=%.3fV, %u ms, po preklopu releja GPIO%u %s (+%u ms)%s",
+                         events[i].minVoltage, events[i].durationMs, events[i].relayPin,
+                         events[i].relayOn ? "ON" : "OFF", events[i].relayLeadMs,
+                         powerError ? " [NAPAKA]" : "");
+            } else {
+                LOG_WARN("Sensors", "Padec 5V: min=%.3fV, %u ms, brez preklopa releja%s",
+                         events[i].minVoltage, events[i].durationMs, powerError ? " [NAPAKA]" : "");
+            }
+        }
+        reportedSags = sagCount;
+    }
+    currentData.supplySagCount = sagCount;
     if (powerError) {
         currentData.errorFlags |= ERR_POWER;
     } else {
@@ -319,21 +472,96 @@ void readSensors() {
     bool powerChanged = (fabsf(currentData.supply5V - last5V) > 0.05f) ||
                         (fabsf(currentData.supply3V3 - last3V3) > 0.05f);
     if (powerChanged || powerError) {
-        LOG_INFO("Sensors", "Napajanje: 5V=%.3fV 3.3V=%.3fV%s",
-                 currentData.supply5V, currentData.supply3V3,
-                 powerError ? " [NAPAKA]" : "");
+        LOG_INFO("Sensors", "Napajanje: 5V=%.3fV (%.3f-%.3f) 3.3V=%.3fV%s",
+                 currentData.supply5V, currentData.supply5VMin, currentData.supply5VMax,
+                 currentData.supply3V3, powerError ? " [NAPAKA]" : "");
         last5V  = currentData.supply5V;
         last3V3 = currentData.supply3V3;
     }
 }
 
+// Izbere efektivni interval vzorčenja prostora in logira spremembo
+static uint16_t selectSampleInterval(const char* room, RoomSampler& sampler, bool fast) {
+    uint16_t interval = fast ? SENSOR_READ_INTERVAL_FAST : SENSOR_READ_INTERVAL;
+    if (interval != sampler.intervalSec) {
+        LOG_INFO("Sensors", "%s vzorčenje: %u s -> %u s", room, sampler.intervalSec, interval);
+        sampler.intervalSec = interval;
+    }
+    return interval;
+}
+
+// Adaptivno vzorčenje - klicano iz loop() med rednimi branji (SENSOR_READ_INTERVAL).
+// Prostor v aktivnem sušenju ali z naraščajočo vlago (updateHumidityTrend) se bere
+// vsakih SENSOR_READ_INTERVAL_FAST sekund - konec cikla in auto trigger temeljita na
+// sveži vlagi. Zgodovina vlage v vent.cpp se premika ob vsakem klicu kontrole, ne ob
+// branju, zato hitrejše vzorčenje ne spremeni njene časovne osnove.
+void readSensorsAdaptive() {
+    unsigned long now = millis();
+
+    if (now - busWindowStart >= 60000UL) {
+        busWindowStart = now;
+        busTimeInWindowMs = 0;
+    }
+
+    static bool budgetExceededLogged = false;
+    bool budgetOk = busTimeInWindowMs < SENSOR_BUS_BUDGET_MS;
+    if (!budgetOk && !budgetExceededLogged) {
+        LOG_WARN("Sensors", "I2C proračun presežen (%lu ms / %d ms) - hitro vzorčenje začasno izklopljeno",
+                 busTimeInWindowMs, SENSOR_BUS_BUDGET_MS);
+        budgetExceededLogged = true;
+    } else if (budgetOk) {
+        budgetExceededLogged = false;
+    }
+
+    uint16_t utInterval = selectSampleInterval("UT", utilitySampler,
+        budgetOk && sht41Present && (currentData.utilityDryingMode || utilitySampler.rising));
+    uint16_t kopInterval = selectSampleInterval("KOP", bathroomSampler,
+        budgetOk && bmePresent && (currentData.bathroomDryingMode || bathroomSampler.rising));
+    currentData.utilitySampleInterval = utInterval;
+    currentData.bathroomSampleInterval = kopInterval;
+
+    // Redna branja opravi readSensors() - tu samo pospešena
+    if (utInterval < SENSOR_READ_INTERVAL && now - utilitySampler.lastRead >= utInterval * 1000UL) {
+        readUtilitySensor();
+    }
+    if (kopInterval < SENSOR_READ_INTERVAL && now - bathroomSampler.lastRead >= kopInterval * 1000UL) {
+        readBathroomSensor();
+    }
+}
+
 bool checkI2CDevice(uint8_t address) {
-    Wire.beginTransmission(address);
-    return (Wire.endTransmission() == 0);
+    uint8_t result;
+    if (takeInjectedFault(I2C_FAULT_NACK, address)) {
+        result = 2;
+    } else if (takeInjectedFault(I2C_FAULT_TIMEOUT, address)) {
+        delay(I2C_TIMEOUT_MS);
+        result = 5;
+    } else {
+        Wire.beginTransmission(address);
+        result = Wire.endTransmission();
+    }
+
+    I2CDeviceStats* stats = statsForAddress(address);
+    if (stats) {
+        stats->transactions++;
+        if (result == 2 || result == 3) stats->nacks++;
+        else if (result == 5) stats->timeouts++;
+        else if (result != 0) stats->otherErrors++;
+    }
+    return (result == 0);
+}
+
+// Zabeleži trajanje obnovitve vodila
+static void recordRecovery(unsigned long startMs) {
+    i2cStats.lastRecoveryMs = millis() - startMs;
+    if (i2cStats.lastRecoveryMs > i2cStats.maxRecoveryMs) i2cStats.maxRecoveryMs = i2cStats.lastRecoveryMs;
 }
 
 bool resetI2CBus() {
     LOG_INFO("I2C", "Starting bus recovery...");
+    i2cStats.busRecoveries++;
+    unsigned long recoveryStart = millis();
+    bool sdaStuckInjected = takeInjectedFault(I2C_FAULT_SDA_STUCK, 0);
     
     // Step 1: Bus clear protocol (9 clock pulses)
     pinMode(PIN_I2C_SCL, OUTPUT);
@@ -346,15 +574,18 @@ bool resetI2CBus() {
         delayMicroseconds(5);
         
         // Check if SDA released
-        if (digitalRead(PIN_I2C_SDA) == HIGH) {
+        if (!sdaStuckInjected && digitalRead(PIN_I2C_SDA) == HIGH) {
             LOG_INFO("I2C", "SDA released after %d clocks", i + 1);
             break;
         }
     }
     
     // Step 2: Check final SDA state
-    if (digitalRead(PIN_I2C_SDA) == LOW) {
+    if (sdaStuckInjected || digitalRead(PIN_I2C_SDA) == LOW) {
         LOG_ERROR("I2C", "SDA stuck LOW - hardware issue!");
+        i2cStats.sdaStuck++;
+        i2cStats.busRecoveryFailures++;
+        recordRecovery(recoveryStart);
         return false;
     }
     
@@ -370,21 +601,20 @@ bool resetI2CBus() {
     // Step 4: Reinitialize I2C bus
     initI2CBus(true); // Force reinit
     
-    // Step 5: Verify bus - scan for devices
+    // Step 5: Verify bus - ciljano preverjanje znanih senzorjev namesto skeniranja
+    // 126 naslovov (pri 10 kHz in motenem vodilu polno skeniranje blokira zanko več sekund)
     int devicesFound = 0;
-    for (uint8_t addr = 1; addr < 127; addr++) {
-        Wire.beginTransmission(addr);
-        if (Wire.endTransmission() == 0) {
-            devicesFound++;
-        }
-    }
+    if (checkI2CDevice(SHT41_ADDRESS)) devicesFound++;
+    if (checkI2CDevice(BME280_ADDRESS)) devicesFound++;
     
     bool success = (devicesFound > 0);
     if (success) {
         LOG_INFO("I2C", "Bus recovery successful - %d devices found", devicesFound);
     } else {
         LOG_ERROR("I2C", "Bus recovery failed - no devices found");
+        i2cStats.busRecoveryFailures++;
     }
+    recordRecovery(recoveryStart);
     
     return success;
 }
@@ -397,6 +627,7 @@ void performPeriodicSensorCheck() {
         // Check SHT41
         if (!sht41Present && checkI2CDevice(SHT41_ADDRESS)) {
             LOG_INFO("SHT41", "Sensor detected during periodic check, reinitializing...");
+            i2cStats.sht41.reinits++;
             sht41 = new Adafruit_SHT4x();
 
             bool init_success = false;
@@ -438,6 +669,7 @@ void performPeriodicSensorCheck() {
         // Check BME280
         if (!bmePresent && checkI2CDevice(BME280_ADDRESS)) {
             LOG_INFO("BME280", "Sensor detected during periodic check, reinitializing...");
+            i2cStats.bme280.reinits++;
             bme280 = new Adafruit_BME280();
 
             bool init_success = false;
@@ -580,7 +812,6 @@ void readInputs() {
                               PIN_KOPALNICA_LUC_1, PIN_KOPALNICA_LUC_2, PIN_UTILITY_LUC, PIN_WC_LUC};
     static int lastInputStates[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
 
-    char logMessage[256];
     for (int i = 0; i < 8; i++) {
         int currentState = digitalRead(inputPins[i]);
         if (currentState != lastInputStates[i]) {
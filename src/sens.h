@@ -6,10 +6,58 @@
 #include <Adafruit_BME280.h>
 #include "globals.h"
 #include "logging.h"
+#include "supply.h"
+
+// I2C telemetrija - števci in histogram latenc branja po napravi
+#define I2C_LATENCY_BUCKETS 8
+
+struct I2CDeviceStats {
+    uint32_t transactions;    // vse transakcije (probe + branje)
+    uint32_t nacks;           // endTransmission() = 2/3
+    uint32_t timeouts;        // endTransmission() = 5
+    uint32_t otherErrors;     // endTransmission() = 1/4
+    uint32_t invalidReads;    // branje uspelo, vrednosti izven območja
+    uint32_t reinits;         // ponovne inicializacije senzorja
+    uint32_t latencyHist[I2C_LATENCY_BUCKETS];  // latenca branja (ms), meje v i2cLatencyBucketsMs
+    uint16_t lastLatencyMs;
+    uint16_t maxLatencyMs;
+};
+
+// Vrste vbrizganih napak (aktivne samo z -DI2C_FAULT_INJECTION)
+enum I2CFaultMode {
+    I2C_FAULT_NONE = 0,
+    I2C_FAULT_NACK,
+    I2C_FAULT_TIMEOUT,
+    I2C_FAULT_SDA_STUCK,
+    I2C_FAULT_GARBAGE,
+    I2C_FAULT_MODE_COUNT
+};
+
+struct I2CStats {
+    I2CDeviceStats sht41;
+    I2CDeviceStats bme280;
+    uint32_t busRecoveries;        // klici resetI2CBus()
+    uint32_t busRecoveryFailures;  // neuspešne obnovitve
+    uint32_t sdaStuck;             // SDA ostal LOW po 9 urinih impulzih
+    uint32_t busReinits;           // Wire.end()/begin() ponovne inicializacije
+    uint32_t lastRecoveryMs;       // trajanje zadnje obnovitve vodila
+    uint32_t maxRecoveryMs;
+    uint32_t lostControlTicks;     // krmilni cikli (CONTROL_TICK_MS), izgubljeni med branjem senzorjev
+    // lostControlTicks po scenariju: branje brez vbrizgane napake ([I2C_FAULT_NONE])
+    // ali z napako te vrste (zadnja vbrizgana med branjem)
+    uint32_t lostControlTicksByFault[I2C_FAULT_MODE_COUNT];
+};
+
+extern I2CStats i2cStats;
+extern const uint16_t i2cLatencyBucketsMs[I2C_LATENCY_BUCKETS];
 
 void initI2CBus(bool force = false);
+#ifdef I2C_FAULT_INJECTION
+void scheduleI2CFault(I2CFaultMode mode, uint8_t address, uint16_t count);
+#endif
 void initSensors();
 void readSensors();
+void readSensorsAdaptive();
 bool checkI2CDevice(uint8_t address);
 bool resetI2CBus();
 void performPeriodicSensorCheck();
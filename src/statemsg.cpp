@@ -0,0 +1,249 @@
+// statemsg.cpp - CEE state messages (STATUS_UPDATE, DEW_UPDATE, multicast objava)
+
+#include "statemsg.h"
+#include "globals.h"
+#include "logging.h"
+#include "config.h"
+#include "message_fields.h"
+#include "wirearena.h"
+
+// Helper: Compute fan states — shared between sendStatusUpdate and checkAndSendStatusUpdate
+// Eliminates code duplication and keeps both functions in sync
+FanStates computeFanStates() {
+    FanStates s;
+    s.fwc = currentData.disableWc ? 9 : (currentData.wcFan ? 1 : 0);
+    if (currentData.disableUtility) {
+        s.fut = 9;
+    } else if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
+        s.fut = 5 + currentData.utilityCycleMode;  // 6=mode1, 7=mode2, 8=mode3
+    } else {
+        s.fut = currentData.utilityFan ? 1 : 0;
+    }
+    if (currentData.disableBathroom) {
+        s.fkop = 9;
+    } else if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
+        s.fkop = 5 + currentData.bathroomCycleMode;  // 6=mode1, 7=mode2, 8=mode3
+    } else {
+        s.fkop = currentData.bathroomFan ? 1 : 0;
+    }
+    s.fdse = currentData.disableLivingRoom ? 9 : currentData.livingExhaustLevel;
+    return s;
+}
+
+uint32_t utilityReportedOffTime() {
+    if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
+        return currentData.utilityExpectedEndTime;
+    }
+    return currentData.offTimes[1];
+}
+
+uint32_t bathroomReportedOffTime() {
+    if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
+        return currentData.bathroomExpectedEndTime;
+    }
+    return currentData.offTimes[0];
+}
+
+// Polja STATUS_UPDATE (skupna za HTTP in multicast objavo)
+void fillStatusFields(JsonDocument& doc, const FanStates& fs) {
+    // Fans — via shared helper (0=off, 1=on, 6-8=drying mode, 9=disabled)
+    doc[FIELD_FAN_WC]         = fs.fwc;
+    doc[FIELD_FAN_UTILITY]    = fs.fut;
+    doc[FIELD_FAN_BATHROOM]   = fs.fkop;
+    doc[FIELD_FAN_LIVING_EXH] = fs.fdse;
+
+    // Inputs (digital states)
+    doc[FIELD_INPUT_BATHROOM_L1] = currentData.bathroomLight1 ? 1 : 0;
+    doc[FIELD_INPUT_BATHROOM_L2] = currentData.bathroomLight2 ? 1 : 0;
+    doc[FIELD_INPUT_UTILITY_L]   = currentData.utilityLight ? 1 : 0;
+    doc[FIELD_INPUT_WC_L]        = currentData.wcLight ? 1 : 0;
+    doc[FIELD_INPUT_WINDOW_ROOF] = currentData.windowSensor1 ? 1 : 0;
+    doc[FIELD_INPUT_WINDOW_BALC] = currentData.windowSensor2 ? 1 : 0;
+
+    // Off-times (Unix timestamps)
+    doc[FIELD_TIME_WC] = currentData.offTimes[2];
+    doc[FIELD_TIME_UTILITY] = utilityReportedOffTime();     // med sušenjem pričakovan konec
+    doc[FIELD_TIME_BATHROOM] = bathroomReportedOffTime();
+    doc[FIELD_TIME_LIVING_EXH] = currentData.offTimes[4];
+
+    // Error flags (0=ok, 1=error)
+    doc[FIELD_ERROR_BME280] = currentData.errorFlags & ERR_BME280 ? 1 : 0;
+    doc[FIELD_ERROR_SHT41]  = currentData.errorFlags & ERR_SHT41 ? 1 : 0;
+    doc[FIELD_ERROR_POWER]  = currentData.errorFlags & ERR_POWER ? 1 : 0;
+    doc[FIELD_POWER_SAGS]   = currentData.supplySagCount;
+    doc[FIELD_ERROR_DEW]    = currentData.dewError;
+    // Time sync error detection
+    uint8_t timeSyncError = 0;
+    if (!timeSynced) {
+        timeSyncError = 1;  // NTP not synchronized
+    } else if (externalDataValid) {
+        uint32_t currentTime = myTZ.now();
+        uint32_t timeDiff = abs((int32_t)(currentTime - externalData.timestamp));
+        if (timeDiff > 300) timeSyncError = 2;  // Time discrepancy >5min
+    }
+    doc[FIELD_ERROR_TIME_SYNC] = timeSyncError;
+
+    // Sensor data
+    doc[FIELD_TEMP_BATHROOM]      = currentData.bathroomTemp;
+    doc[FIELD_HUM_BATHROOM]       = currentData.bathroomHumidity;
+    doc[FIELD_PRESS_BATHROOM]     = currentData.bathroomPressure;
+    doc[FIELD_TEMP_UTILITY]       = currentData.utilityTemp;
+    doc[FIELD_HUM_UTILITY]        = currentData.utilityHumidity;
+    doc[FIELD_CURRENT_POWER]      = currentData.currentPower;
+    doc[FIELD_ENERGY_CONSUMPTION] = currentData.energyConsumption;
+    doc[FIELD_DUTY_CYCLE_LIVING]  = (int)currentData.livingRoomDutyCycle;
+}
+
+// DEW_UPDATE polja - enako sporočilo za UT in KOP
+void fillDewFields(JsonDocument& doc) {
+    // Unified payload - same structure sent to both UT and KOP
+    // Each DEW unit reads the fields relevant to its role
+
+    // Utility fan state (0=off, 1=on, 6-8=drying mode, 9=disabled)
+    if (currentData.disableUtility) {
+        doc[FIELD_FAN_UTILITY] = 9;
+    } else if (currentData.utilityDryingMode && currentData.utilityCycleMode >= 1 && currentData.utilityCycleMode <= 3) {
+        doc[FIELD_FAN_UTILITY] = 5 + currentData.utilityCycleMode;  // 6, 7, or 8
+    } else {
+        doc[FIELD_FAN_UTILITY] = currentData.utilityFan ? 1 : 0;
+    }
+
+    // Bathroom fan state (0=off, 1=on, 6-8=drying mode, 9=disabled)
+    if (currentData.disableBathroom) {
+        doc[FIELD_FAN_BATHROOM] = 9;
+    } else if (currentData.bathroomDryingMode && currentData.bathroomCycleMode >= 1 && currentData.bathroomCycleMode <= 3) {
+        doc[FIELD_FAN_BATHROOM] = 5 + currentData.bathroomCycleMode;  // 6, 7, or 8
+    } else {
+        doc[FIELD_FAN_BATHROOM] = currentData.bathroomFan ? 1 : 0;
+    }
+
+    // Times: expectedEndTime if drying (6-8), else offTimes
+    doc[FIELD_TIME_UTILITY] = utilityReportedOffTime();
+    doc[FIELD_TIME_BATHROOM] = bathroomReportedOffTime();
+
+    // Sensor data - both rooms (each DEW unit uses its own fields)
+    doc[FIELD_TEMP_BATHROOM]  = currentData.bathroomTemp;      // tbat - KOP_DEW uses this
+    doc[FIELD_HUM_BATHROOM]   = currentData.bathroomHumidity;  // hbat - KOP_DEW uses this
+    doc[FIELD_PRESS_BATHROOM] = currentData.bathroomPressure;  // pbat - KOP_DEW uses this
+    doc[FIELD_TEMP_UTILITY]   = currentData.utilityTemp;       // tutl - UT_DEW uses this
+    doc[FIELD_HUM_UTILITY]    = currentData.utilityHumidity;   // hutl - UT_DEW uses this
+
+    // Weather icon and season (both DEW units use these); ArduinoJson kopira niz
+    doc[FIELD_WEATHER_ICON] = currentWeatherIcon.c_str();      // wi (string)
+    doc[FIELD_SEASON_CODE]  = currentSeasonCode;               // ss
+
+    // Error flags (both DEW units may use these)
+    doc[FIELD_ERROR_BME280] = currentData.errorFlags & ERR_BME280 ? 1 : 0;  // ebm
+    doc[FIELD_ERROR_SHT41]  = currentData.errorFlags & ERR_SHT41 ? 1 : 0;   // esht
+}
+
+// Multicast objava: STATUS_UPDATE polja + vreme/sezona (unija z DEW_UPDATE)
+void fillPublishFields(JsonDocument& doc) {
+    fillStatusFields(doc, computeFanStates());
+    doc[FIELD_WEATHER_ICON] = currentWeatherIcon.c_str();
+    doc[FIELD_SEASON_CODE]  = currentSeasonCode;
+}
+
+size_t encodeStateDoc(const JsonDocument& doc, WireFormat format, uint8_t* out, size_t size) {
+    return doc.overflowed() ? 0 : wireEncode(doc, format, out, size);
+}
+
+// ---- Delta STATUS_UPDATE ----
+
+#define STATUS_SNAPSHOTS 4   // sporočila v teku + čakajoče (najv. 2) z rezervo
+
+struct StatusSnapshot {
+    uint32_t seq;
+    bool keyframe;
+    uint16_t length;                        // 0 = stanje ni šlo v buffer
+    uint8_t state[STATUS_SNAPSHOT_MAX];     // polno stanje ob sporočilu (MessagePack)
+};
+
+static StatusSnapshot statusSnapshots[STATUS_SNAPSHOTS];
+static WireDocument<MSG_DOC_ARENA> statusBaseline;
+static WireDocument<MSG_DOC_ARENA> deltaDoc;        // sporočilo REW (delta/keyframe)
+static uint32_t statusSeq = 0;
+static uint32_t statusAckedSeq = 0;    // 0 = ni potrjene osnove
+static uint16_t statusSinceKeyframe = 0;
+static bool statusKeyframeRequested = true;
+static bool rewDeltaCaps = false;
+static StatusDeltaStats statusDeltaStats = {};
+
+void getStatusDeltaStats(StatusDeltaStats& stats) {
+    stats = statusDeltaStats;
+    stats.enabled = rewDeltaCaps;
+    stats.ackedSeq = statusAckedSeq;
+}
+
+size_t encodeStatusMessage(JsonDocument& full, WireFormat format, uint32_t& seq, uint8_t* out, size_t size,
+                           uint32_t eventTime) {
+    if (++statusSeq == 0) statusSeq = 1;
+    seq = statusSeq;
+
+    StatusSnapshot& snap = statusSnapshots[seq % STATUS_SNAPSHOTS];
+    snap.seq = seq;
+    snap.length = encodeStateDoc(full, WIRE_MSGPACK, snap.state, sizeof(snap.state));
+    statusDeltaStats.bytesFull += measureJson(full);
+
+    if (!rewDeltaCaps) {
+        snap.keyframe = true;
+        if (eventTime) full[FIELD_TIMESTAMP] = eventTime;
+        size_t length = encodeStateDoc(full, format, out, size);
+        statusDeltaStats.bytesSent += length;
+        return length;
+    }
+
+    snap.keyframe = statusKeyframeRequested || statusAckedSeq == 0 ||
+                    statusSinceKeyframe + 1 >= STATUS_KEYFRAME_EVERY;
+    JsonDocument& msg = deltaDoc;
+    msg.clear();
+    msg[FIELD_SEQUENCE] = seq;
+    if (snap.keyframe) {
+        msg[FIELD_KEYFRAME] = 1;
+        statusKeyframeRequested = false;
+        statusSinceKeyframe = 0;
+        statusDeltaStats.keyframes++;
+    } else {
+        msg[FIELD_BASE_SEQUENCE] = statusAckedSeq;
+        statusSinceKeyframe++;
+        statusDeltaStats.deltas++;
+    }
+    for (JsonPair kv : full.as<JsonObject>()) {
+        JsonVariantConst prev = statusBaseline.as<JsonObjectConst>()[kv.key()];
+        if (snap.keyframe || prev.isNull() || prev != kv.value()) msg[kv.key()] = kv.value();
+    }
+    if (eventTime) msg[FIELD_TIMESTAMP] = eventTime;
+
+    size_t length = encodeStateDoc(msg, format, out, size);
+    statusDeltaStats.bytesSent += length;
+    return length;
+}
+
+void ackStatusMessage(uint32_t seq, bool deltaCaps, bool keyframeRequested) {
+    if (deltaCaps != rewDeltaCaps) {
+        LOG_INFO("HTTP", "STATUS_UPDATE: delta protokol %s", deltaCaps ? "vklopljen" : "izklopljen");
+        rewDeltaCaps = deltaCaps;
+        statusKeyframeRequested = true;
+    }
+    if (keyframeRequested) {
+        statusKeyframeRequested = true;
+        statusDeltaStats.keyframeRequests++;
+    }
+
+    StatusSnapshot& snap = statusSnapshots[seq % STATUS_SNAPSHOTS];
+    if (snap.seq != seq || (int32_t)(seq - statusAckedSeq) <= 0) return;
+    if (snap.length == 0 || deserializeMsgPack(statusBaseline, snap.state, snap.length)) {
+        statusAckedSeq = 0;          // brez osnove - naslednje sporočilo je keyframe
+        return;
+    }
+    statusAckedSeq = seq;
+}
+
+void dropStatusMessage(uint32_t seq) {
+    const StatusSnapshot& snap = statusSnapshots[seq % STATUS_SNAPSHOTS];
+    if (snap.seq == seq && snap.keyframe) statusKeyframeRequested = true;
+}
+
+void requestStatusKeyframe() {
+    statusKeyframeRequested = true;
+}
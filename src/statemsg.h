@@ -0,0 +1,67 @@
+// statemsg.h - CEE state messages (STATUS_UPDATE, DEW_UPDATE, multicast objava)
+//
+// Polja sporočil iz currentData in kodiranje delta STATUS_UPDATE. Ločeno od
+// http.cpp (pošiljanje, outbox, zmožnosti enot), da ga tools/msgpack_bench.cpp
+// prevede na računalniku in preveri, da sporočila ne alocirajo s heapa.
+// Vse funkcije samo iz glavne zanke.
+//
+// Delta STATUS_UPDATE: REW ga vklopi z odgovorom "X-Vent-Caps: delta" na našo glavo.
+// Sporočilo nosi sq in bs (sq zadnjega potrjenega = 2xx) ter samo polja, ki se
+// razlikujejo od stanja bs. Keyframe (kf=1, vsa polja) gre vsakih
+// STATUS_KEYFRAME_EVERY sporočil, po napaki in ko ga REW zahteva z
+// "X-Vent-Keyframe: 1" (npr. ker nima stanja bs ali je zaznal vrzel).
+
+#ifndef STATEMSG_H
+#define STATEMSG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "wire.h"
+
+// Ventilatorji v sporočilih (0=off, 1=on, 6-8=sušenje, 9=onemogočen)
+struct FanStates {
+    uint8_t fwc, fut, fkop, fdse;
+};
+
+FanStates computeFanStates();
+
+// Čas izklopa, kot ga nosijo sporočila (STATUS/DEW_UPDATE, MQTT): med sušenjem
+// (cikel 1-3) pričakovan konec sušenja, sicer offTimes
+uint32_t utilityReportedOffTime();
+uint32_t bathroomReportedOffTime();
+
+// Polja STATUS_UPDATE, DEW_UPDATE in multicast objave (STATUS + vreme/sezona)
+void fillStatusFields(JsonDocument& doc, const FanStates& fs);
+void fillDewFields(JsonDocument& doc);
+void fillPublishFields(JsonDocument& doc);
+
+// Dokument, ki ni šel v areno, se ne zakodira (nepopolno stanje bi bilo napačno);
+// vrne dolžino ali 0
+size_t encodeStateDoc(const JsonDocument& doc, WireFormat format, uint8_t* out, size_t size);
+
+// Zakodira STATUS_UPDATE iz polnega stanja v out (delta ali keyframe, ko je delta
+// vklopljena); seq sporočila gre v ackStatusMessage. eventTime != 0: zapoznel
+// dogodek iz outboxa - čas nastanka gre v ts (ni del osnove)
+size_t encodeStatusMessage(JsonDocument& full, WireFormat format, uint32_t& seq, uint8_t* out, size_t size,
+                           uint32_t eventTime = 0);
+
+// 2xx potrdi sporočilo: njegovo polno stanje postane osnova naslednjih delt.
+// deltaCaps in keyframeRequested iz X-Vent-Caps/X-Vent-Keyframe odgovora
+void ackStatusMessage(uint32_t seq, bool deltaCaps, bool keyframeRequested);
+// Sporočilo nikoli ni bilo poslano - keyframe, ki ga REW pričakuje, gre z naslednjim
+void dropStatusMessage(uint32_t seq);
+// Napaka ali izpad REW - naslednje sporočilo je keyframe
+void requestStatusKeyframe();
+
+struct StatusDeltaStats {
+    bool enabled;
+    uint32_t ackedSeq;
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t keyframeRequests;   // REW je zahteval keyframe
+    uint32_t bytesFull;          // bajti, ki bi jih poslali s polnim stanjem
+    uint32_t bytesSent;
+};
+void getStatusDeltaStats(StatusDeltaStats& stats);
+
+#endif // STATEMSG_H
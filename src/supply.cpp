@@ -0,0 +1,181 @@
+// supply.cpp - Continuous supply voltage monitor for CEE
+//
+// Ločen task vzorči 5 V in 3,3 V napajanje vsakih SUPPLY_SAMPLE_PERIOD_MS z
+// nadvzorčenjem in eFuse kalibracijo ADC (analogReadMilliVolts). Za vsako okno
+// med dvema branjema senzorjev hrani min/povprečje/max, kratke padce 5 V pa
+// zabeleži kot dogodke, povezane z zadnjim preklopom releja iz vent.cpp.
+
+#include "supply.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+
+static portMUX_TYPE supplyMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Akumulatorji tekočega okna (zaščiteni s supplyMux)
+static float winMin5V, winMax5V, winMin3V3, winMax3V3;
+static float winSum5V, winSum3V3;
+static uint32_t winSamples = 0;
+
+// Krožni dnevnik padcev
+static SupplySagEvent sagLog[SUPPLY_SAG_LOG_SIZE];
+static uint8_t sagHead = 0;          // naslednji prost vnos
+static uint32_t sagCount = 0;        // vsi padci od zagona
+
+// Zadnji preklop releja (piše vent.cpp, bere task)
+static volatile uint8_t lastRelayPin = 0;
+static volatile bool lastRelayOn = false;
+static volatile uint32_t lastRelayMs = 0;
+
+// Stanje detekcije padca (samo task)
+static bool inSag = false;
+static uint32_t sagStartMs = 0;
+static float sagMinVoltage = 0.0f;
+
+static void resetWindow() {
+    winMin5V = winMin3V3 = 1000.0f;
+    winMax5V = winMax3V3 = 0.0f;
+    winSum5V = winSum3V3 = 0.0f;
+    winSamples = 0;
+}
+
+static void readSupplies(float& v5, float& v3v3) {
+    uint32_t mv5 = 0, mv3v3 = 0;
+    for (int i = 0; i < SUPPLY_OVERSAMPLE; i++) {
+        mv5 += analogReadMilliVolts(PIN_SUPPLY_5V);
+        mv3v3 += analogReadMilliVolts(PIN_SUPPLY_3V3);
+    }
+    v5 = (mv5 / (float)SUPPLY_OVERSAMPLE) / 1000.0f * SUPPLY_5V_DIVIDER;
+    v3v3 = (mv3v3 / (float)SUPPLY_OVERSAMPLE) / 1000.0f * SUPPLY_3V3_DIVIDER;
+}
+
+static void recordSag(uint32_t endMs) {
+    SupplySagEvent ev;
+    ev.startMs = sagStartMs;
+    ev.durationMs = (endMs - sagStartMs) > 0xFFFF ? 0xFFFF : (endMs - sagStartMs);
+    ev.minVoltage = sagMinVoltage;
+    ev.timestamp = 0;           // ezTime ni varen za ta task - pretvori getSupplySagEvents()
+
+    uint32_t relayMs = lastRelayMs;
+    uint32_t lead = sagStartMs - relayMs;
+    if (relayMs != 0 && lead <= SUPPLY_SAG_CORRELATION_MS) {
+        ev.relayPin = lastRelayPin;
+        ev.relayOn = lastRelayOn;
+        ev.relayLeadMs = lead;
+    } else {
+        ev.relayPin = 0;
+        ev.relayOn = false;
+        ev.relayLeadMs = 0;
+    }
+
+    portENTER_CRITICAL(&supplyMux);
+    sagLog[sagHead] = ev;
+    sagHead = (sagHead + 1) % SUPPLY_SAG_LOG_SIZE;
+    sagCount++;
+    portEXIT_CRITICAL(&supplyMux);
+}
+
+static void supplyMonitorTask(void* param) {
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        float v5, v3v3;
+        readSupplies(v5, v3v3);
+        uint32_t now = millis();
+
+        portENTER_CRITICAL(&supplyMux);
+        if (v5 < winMin5V) winMin5V = v5;
+        if (v5 > winMax5V) winMax5V = v5;
+        if (v3v3 < winMin3V3) winMin3V3 = v3v3;
+        if (v3v3 > winMax3V3) winMax3V3 = v3v3;
+        winSum5V += v5;
+        winSum3V3 += v3v3;
+        winSamples++;
+        portEXIT_CRITICAL(&supplyMux);
+
+        // Detekcija padca 5 V s histerezo
+        if (!inSag && v5 < SUPPLY_SAG_5V_THRESHOLD) {
+            inSag = true;
+            sagStartMs = now;
+            sagMinVoltage = v5;
+        } else if (inSag) {
+            if (v5 < sagMinVoltage) sagMinVoltage = v5;
+            if (v5 >= SUPPLY_SAG_5V_THRESHOLD + SUPPLY_SAG_HYSTERESIS) {
+                inSag = false;
+                recordSag(now);
+            }
+        }
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SUPPLY_SAMPLE_PERIOD_MS));
+    }
+}
+
+void initSupplyMonitor() {
+    analogReadResolution(12);
+
+    // Začetno branje, da so vrednosti veljavne pred prvim oknom
+    float v5, v3v3;
+    readSupplies(v5, v3v3);
+    currentData.supply5V = v5;
+    currentData.supply3V3 = v3v3;
+    resetWindow();
+
+    BaseType_t ok = xTaskCreatePinnedToCore(supplyMonitorTask, "supply", 3072, NULL, 1, NULL, 0);
+    if (ok == pdPASS) {
+        LOG_INFO("Supply", "Monitor zagnan: %d ms perioda, %dx nadvzorčenje, prag padca %.2f V",
+                 SUPPLY_SAMPLE_PERIOD_MS, SUPPLY_OVERSAMPLE, SUPPLY_SAG_5V_THRESHOLD);
+    } else {
+        LOG_ERROR("Supply", "Task ni bil ustvarjen!");
+    }
+}
+
+// Vrne statistiko okna od zadnjega klica in začne novo okno
+bool takeSupplyWindow(SupplyWindow& out) {
+    portENTER_CRITICAL(&supplyMux);
+    uint32_t samples = winSamples;
+    if (samples > 0) {
+        out.min5V = winMin5V;
+        out.max5V = winMax5V;
+        out.mean5V = winSum5V / samples;
+        out.min3V3 = winMin3V3;
+        out.max3V3 = winMax3V3;
+        out.mean3V3 = winSum3V3 / samples;
+        out.samples = samples;
+        resetWindow();
+    }
+    portEXIT_CRITICAL(&supplyMux);
+    return samples > 0;
+}
+
+// Kopira zadnje padce (najnovejši prvi), vrne število kopiranih.
+// Časovni žig se izračuna tukaj iz startMs - task beleži samo millis().
+uint8_t getSupplySagEvents(SupplySagEvent* out, uint8_t maxEvents) {
+    portENTER_CRITICAL(&supplyMux);
+    uint8_t available = sagCount < SUPPLY_SAG_LOG_SIZE ? sagCount : SUPPLY_SAG_LOG_SIZE;
+    uint8_t n = available < maxEvents ? available : maxEvents;
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = sagLog[(sagHead + SUPPLY_SAG_LOG_SIZE - 1 - i) % SUPPLY_SAG_LOG_SIZE];
+    }
+    portEXIT_CRITICAL(&supplyMux);
+
+    uint32_t nowMs = millis();
+    uint32_t localNow = timeSynced ? (uint32_t)myTZ.now() : 0;
+    for (uint8_t i = 0; i < n; i++) {
+        out[i].timestamp = timeSynced ? localNow - (nowMs - out[i].startMs) / 1000 : out[i].startMs / 1000;
+    }
+    return n;
+}
+
+uint32_t getSupplySagCount() {
+    portENTER_CRITICAL(&supplyMux);
+    uint32_t count = sagCount;
+    portEXIT_CRITICAL(&supplyMux);
+    return count;
+}
+
+void noteRelayTransition(uint8_t pin, bool on) {
+    lastRelayPin = pin;
+    lastRelayOn = on;
+    lastRelayMs = millis();
+}
@@ -0,0 +1,34 @@
+// supply.h - Continuous supply voltage monitor for CEE
+
+#ifndef SUPPLY_H
+#define SUPPLY_H
+
+#include <Arduino.h>
+
+// Statistika napajanja v oknu med dvema klicema takeSupplyWindow()
+struct SupplyWindow {
+    float min5V, mean5V, max5V;
+    float min3V3, mean3V3, max3V3;
+    uint32_t samples;
+};
+
+// Zabeležen padec 5 V napajanja (npr. zagonski tok ventilatorja)
+struct SupplySagEvent {
+    uint32_t timestamp;      // lokalni čas (myTZ.now()) začetka padca, sekunde od zagona, če ni NTP;
+                             // izračuna ga getSupplySagEvents() v glavni zanki
+    uint32_t startMs;        // millis() ob začetku padca (edini čas, ki ga zabeleži task)
+    uint16_t durationMs;
+    float minVoltage;
+    uint8_t relayPin;        // zadnji preklopljeni rele pred padcem (0 = ni korelacije)
+    bool relayOn;
+    uint16_t relayLeadMs;    // čas od preklopa releja do začetka padca
+};
+
+void initSupplyMonitor();
+bool takeSupplyWindow(SupplyWindow& out);
+// Samo glavna zanka (myTZ ni varen za klic iz taska)
+uint8_t getSupplySagEvents(SupplySagEvent* out, uint8_t maxEvents);
+uint32_t getSupplySagCount();
+void noteRelayTransition(uint8_t pin, bool on);
+
+#endif // SUPPLY_H
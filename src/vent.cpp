@@ -25,6 +25,14 @@ void startManualLivingRoomFan(bool& fanActive, bool& manualMode, uint8_t& curren
 void stopLivingRoomFan(bool& fanActive, bool& manualMode, uint8_t& currentLevel);
 void logLivingRoomStatus(float cyclePercent, bool canRunAutomatic, uint8_t currentLevel);
 
+// Preklop releja - ob spremembi stanja obvesti supply monitor (korelacija padcev 5 V)
+static void setRelay(uint8_t pin, uint8_t level) {
+    if (digitalRead(pin) != level) {
+        noteRelayTransition(pin, level == HIGH);
+    }
+    digitalWrite(pin, level);
+}
+
 void setupVent() {
     pinMode(PIN_KOPALNICA_ODVOD, OUTPUT);
     pinMode(PIN_UTILITY_ODVOD, OUTPUT);
@@ -58,13 +66,13 @@ void controlFans() {
     else if (digitalRead(PIN_DNEVNI_ODVOD_1) == HIGH && !currentData.disableLivingRoom) currentData.livingExhaustLevel = 1;
 
     if (currentData.bathroomFan || currentData.utilityFan || currentData.wcFan) {
-        digitalWrite(PIN_SKUPNI_VPIH, HIGH);
+        setRelay(PIN_SKUPNI_VPIH, HIGH);
         currentData.commonIntake = true;
         if (currentData.commonIntake) currentData.offTimes[3] = currentData.bathroomFan ? currentData.offTimes[0] :
                                                                 currentData.utilityFan ? currentData.offTimes[1] :
                                                                 currentData.wcFan ? currentData.offTimes[2] : 0;
     } else {
-        digitalWrite(PIN_SKUPNI_VPIH, LOW);
+        setRelay(PIN_SKUPNI_VPIH, LOW);
         currentData.commonIntake = false;
         currentData.offTimes[3] = 0;
     }
@@ -82,7 +90,7 @@ void controlWC() {
         // Handle manual triggers only
         char logMessage[256];
         if (currentData.manualTriggerWC) {
-            digitalWrite(PIN_WC_ODVOD, HIGH);
+            setRelay(PIN_WC_ODVOD, HIGH);
             fanStartTime = millis();
             fanActive = true;
             currentData.wcFan = true;
@@ -94,7 +102,7 @@ void controlWC() {
 
         // Handle timeout for active fans
         if (fanActive && (millis() - fanStartTime >= settings.fanDuration * 1000)) {
-            digitalWrite(PIN_WC_ODVOD, LOW);
+            setRelay(PIN_WC_ODVOD, LOW);
             fanActive = false;
             currentData.wcFan = false;
             currentData.offTimes[2] = 0;
@@ -129,7 +137,7 @@ void controlWC() {
     // Semi-auto fires outside DND always, during DND only if allowed
     // (semiAutomaticTrigger already handles this correctly via !isDNDTime() || dndAllowableSemiautomatic)
     if ((manualTrigger || semiAutomaticTrigger) && !fanActive) {
-        digitalWrite(PIN_WC_ODVOD, HIGH);
+        setRelay(PIN_WC_ODVOD, HIGH);
         fanStartTime = millis();
         fanActive = true;
         currentData.wcFan = true;
@@ -149,7 +157,7 @@ void controlWC() {
     }
 
     if (fanActive && (millis() - fanStartTime >= settings.fanDuration * 1000)) {
-        digitalWrite(PIN_WC_ODVOD, LOW);
+        setRelay(PIN_WC_ODVOD, LOW);
         fanActive = false;
         currentData.wcFan = false;
         currentData.offTimes[2] = 0;
@@ -196,7 +204,7 @@ void controlUtility() {
             utility_cycle_mode = 0;
             utility_burst_count = 0;
             if (in_burst) {
-                digitalWrite(PIN_UTILITY_ODVOD, LOW);
+                setRelay(PIN_UTILITY_ODVOD, LOW);
                 currentData.utilityFan = false;
                 in_burst = false;
             }
@@ -221,7 +229,7 @@ void controlUtility() {
     // Če disableUtility, prekini cikel
     if (currentData.disableUtility) {
         if (digitalRead(PIN_UTILITY_ODVOD) == HIGH) {
-            digitalWrite(PIN_UTILITY_ODVOD, LOW);
+            setRelay(PIN_UTILITY_ODVOD, LOW);
             currentData.utilityFan = false;
             char logMessage[256];
             snprintf(logMessage, sizeof(logMessage), "[UT Vent] OFF: Disable via switch/REW");
@@ -364,7 +372,7 @@ void controlUtility() {
                     }
                 }
                 // --- Zaženi burst ---
-                digitalWrite(PIN_UTILITY_ODVOD, HIGH);
+                setRelay(PIN_UTILITY_ODVOD, HIGH);
                 currentData.utilityFan = true;
                 burst_start = millis();
                 in_burst = true;
@@ -374,7 +382,7 @@ void controlUtility() {
                 logEvent(logMessage);
             }
         } else if (millis() - burst_start >= fan_duration) {
-            digitalWrite(PIN_UTILITY_ODVOD, LOW);
+            setRelay(PIN_UTILITY_ODVOD, LOW);
             currentData.utilityFan = false;
             off_start = millis();
             in_burst = false;
@@ -401,7 +409,7 @@ void controlUtility() {
             logEvent(logMessage);
         } else if (!in_burst) {
             // Zaženi ventilator za fanDuration sekund
-            digitalWrite(PIN_UTILITY_ODVOD, HIGH);
+            setRelay(PIN_UTILITY_ODVOD, HIGH);
             currentData.utilityFan = true;
             burst_start = millis();
             in_burst = true;
@@ -422,7 +430,7 @@ void controlUtility() {
     // Handle manual timeout - ko ni drying cikla, timeout za ročni vklop
     if (!utility_drying_mode && in_burst) {
         if (millis() - burst_start >= settings.fanDuration * 1000UL) {
-            digitalWrite(PIN_UTILITY_ODVOD, LOW);
+            setRelay(PIN_UTILITY_ODVOD, LOW);
             currentData.utilityFan = false;
             in_burst = false;
             currentData.offTimes[1] = 0;
@@ -442,7 +450,7 @@ void controlUtility() {
             logEvent(logMessage);
         } else if (!utility_drying_mode && !in_burst) {
             // Normal manual - zaženi ventilator za fanDuration sekund
-            digitalWrite(PIN_UTILITY_ODVOD, HIGH);
+            setRelay(PIN_UTILITY_ODVOD, HIGH);
             currentData.utilityFan = true;
             burst_start = millis();
             in_burst = true;
@@ -498,7 +506,7 @@ void controlBathroom() {
     // Če disableBathroom, prekini cikel
     if (currentData.disableBathroom) {
         if (digitalRead(PIN_KOPALNICA_ODVOD) == HIGH) {
-            digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+            setRelay(PIN_KOPALNICA_ODVOD, LOW);
             currentData.bathroomFan = false;
             char logMessage[256];
             snprintf(logMessage, sizeof(logMessage), "[KOP Vent] OFF: Disable via switch/REW");
@@ -537,7 +545,7 @@ void controlBathroom() {
                 unsigned long duration = isLongPress ? settings.fanDuration * 2 * 1000 : settings.fanDuration * 1000;
                 fanEndTime = millis() + duration;
                 timeExtended = false;
-                digitalWrite(PIN_KOPALNICA_ODVOD, HIGH);
+                setRelay(PIN_KOPALNICA_ODVOD, HIGH);
                 fanStartTime = millis();
                 fanActive = true;
                 currentData.bathroomFan = true;
@@ -557,7 +565,7 @@ void controlBathroom() {
 
         // Handle timeout for active fans
         if (fanActive && millis() >= fanEndTime) {
-            digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+            setRelay(PIN_KOPALNICA_ODVOD, LOW);
             fanActive = false;
             currentData.bathroomFan = false;
             currentData.offTimes[0] = 0;
@@ -699,7 +707,7 @@ void controlBathroom() {
                     }
                 }
                 // --- Zaženi burst ---
-                digitalWrite(PIN_KOPALNICA_ODVOD, HIGH);
+                setRelay(PIN_KOPALNICA_ODVOD, HIGH);
                 currentData.bathroomFan = true;
                 burst_start = millis();
                 in_burst = true;
@@ -709,7 +717,7 @@ void controlBathroom() {
                 logEvent(logMessage);
             }
         } else if (millis() - burst_start >= fan_duration) {
-            digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+            setRelay(PIN_KOPALNICA_ODVOD, LOW);
             currentData.bathroomFan = false;
             off_start = millis();
             in_burst = false;
@@ -741,7 +749,7 @@ void controlBathroom() {
                 unsigned long duration = isLongPress ? settings.fanDuration * 2 * 1000 : settings.fanDuration * 1000;
                 fanEndTime = millis() + duration;
                 timeExtended = false;
-                digitalWrite(PIN_KOPALNICA_ODVOD, HIGH);
+                setRelay(PIN_KOPALNICA_ODVOD, HIGH);
                 fanStartTime = millis();
                 fanActive = true;
                 currentData.bathroomFan = true;
@@ -787,7 +795,7 @@ void controlBathroom() {
             unsigned long duration = settings.fanDuration * 1000;
             fanEndTime = millis() + duration;
             timeExtended = false;
-            digitalWrite(PIN_KOPALNICA_ODVOD, HIGH);
+            setRelay(PIN_KOPALNICA_ODVOD, HIGH);
             fanStartTime = millis();
             fanActive = true;
             currentData.bathroomFan = true;
@@ -814,7 +822,7 @@ void controlBathroom() {
                 unsigned long duration = settings.fanDuration * 1000;
                 fanEndTime = millis() + duration;
                 timeExtended = false;
-                digitalWrite(PIN_KOPALNICA_ODVOD, HIGH);
+                setRelay(PIN_KOPALNICA_ODVOD, HIGH);
                 fanStartTime = millis();
                 fanActive = true;
                 currentData.bathroomFan = true;
@@ -841,7 +849,7 @@ void controlBathroom() {
 
     // Fan timeout — uporablja fanEndTime (absolute millis)
     if (fanActive && millis() >= fanEndTime) {
-        digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+        setRelay(PIN_KOPALNICA_ODVOD, LOW);
         fanActive = false;
         currentData.bathroomFan = false;
         currentData.offTimes[0] = 0;
@@ -856,7 +864,7 @@ void controlBathroom() {
         if (currentData.errorFlags & ERR_BME280) {
             // Senzor v napaki — ustavi ventilator in ponastaviti burst stanje
             if (fanActive || in_burst) {
-                digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+                setRelay(PIN_KOPALNICA_ODVOD, LOW);
                 fanActive = false;
                 in_burst = false;
                 currentData.bathroomFan = false;
@@ -878,7 +886,7 @@ void controlBathroom() {
             }
         } else if (bmePresent && sht41Present && abs(currentData.bathroomTemp - currentData.utilityTemp) > 10.0) {
             if (fanActive || in_burst) {
-                digitalWrite(PIN_KOPALNICA_ODVOD, LOW);
+                setRelay(PIN_KOPALNICA_ODVOD, LOW);
                 fanActive = false;
                 in_burst = false;
                 currentData.bathroomFan = false;
@@ -1139,10 +1147,10 @@ void handleDisableConditions(bool& fanActive, bool& manualMode, uint8_t& current
 
 // Helper function: Start living room fan
 void startLivingRoomFan(float cyclePercent, bool& fanActive, uint8_t& currentLevel, unsigned long& fanStartTime) {
-    digitalWrite(PIN_DNEVNI_VPIH, HIGH);
-    digitalWrite(PIN_DNEVNI_ODVOD_1, LOW);
-    digitalWrite(PIN_DNEVNI_ODVOD_2, LOW);
-    digitalWrite(PIN_DNEVNI_ODVOD_3, LOW);
+    setRelay(PIN_DNEVNI_VPIH, HIGH);
+    setRelay(PIN_DNEVNI_ODVOD_1, LOW);
+    setRelay(PIN_DNEVNI_ODVOD_2, LOW);
+    setRelay(PIN_DNEVNI_ODVOD_3, LOW);
 
     // Only use valid sensor data for level determination
     bool humidityValid = !isnan(currentData.livingHumidity) && currentData.livingHumidity >= 0 && currentData.livingHumidity <= 100;
@@ -1156,8 +1164,8 @@ void startLivingRoomFan(float cyclePercent, bool& fanActive, uint8_t& currentLev
     // Level 3: rezerviran za ročni trigger
     uint8_t newLevel = (isDND || !highIncrement) ? 1 : 2;
 
-    if (newLevel == 1) digitalWrite(PIN_DNEVNI_ODVOD_1, HIGH);
-    else if (newLevel == 2) digitalWrite(PIN_DNEVNI_ODVOD_2, HIGH);
+    if (newLevel == 1) setRelay(PIN_DNEVNI_ODVOD_1, HIGH);
+    else if (newLevel == 2) setRelay(PIN_DNEVNI_ODVOD_2, HIGH);
 
     fanActive = true;
     currentLevel = newLevel;
@@ -1192,8 +1200,8 @@ void startLivingRoomFan(float cyclePercent, bool& fanActive, uint8_t& currentLev
 
 // Helper function: Start manual living room fan
 void startManualLivingRoomFan(bool& fanActive, bool& manualMode, uint8_t& currentLevel, unsigned long& fanStartTime) {
-    digitalWrite(PIN_DNEVNI_VPIH, HIGH);
-    digitalWrite(PIN_DNEVNI_ODVOD_3, HIGH);
+    setRelay(PIN_DNEVNI_VPIH, HIGH);
+    setRelay(PIN_DNEVNI_ODVOD_3, HIGH);
     fanActive = true;
     manualMode = true;
     currentLevel = 3;
@@ -1215,10 +1223,10 @@ void startManualLivingRoomFan(bool& fanActive, bool& manualMode, uint8_t& curren
 
 // Helper function: Stop living room fan
 void stopLivingRoomFan(bool& fanActive, bool& manualMode, uint8_t& currentLevel) {
-    digitalWrite(PIN_DNEVNI_VPIH, LOW);
-    digitalWrite(PIN_DNEVNI_ODVOD_1, LOW);
-    digitalWrite(PIN_DNEVNI_ODVOD_2, LOW);
-    digitalWrite(PIN_DNEVNI_ODVOD_3, LOW);
+    setRelay(PIN_DNEVNI_VPIH, LOW);
+    setRelay(PIN_DNEVNI_ODVOD_1, LOW);
+    setRelay(PIN_DNEVNI_ODVOD_2, LOW);
+    setRelay(PIN_DNEVNI_ODVOD_3, LOW);
     fanActive = false;
     manualMode = false;
     currentLevel = 0;
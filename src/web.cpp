@@ -8,7 +8,22 @@
 #include "help_html.h"
 #include "html.h"
 #include "vent.h"
+#include "sens.h"
+#include "logsd.h"
+#include "sd.h"
+#include "loglimit.h"
+#include "http.h"
+#include "statemsg.h"
+#include "wire.h"
+#include "mcast.h"
+#include "outbox.h"
+#include "liveness.h"
+#include "dashpush.h"
+#include "wsctl.h"
+#include "mqtt.h"
+#include "metrics.h"
 #include <Update.h>
+#include <memory>
 
 // Helper functions for root page
 String formatUptime(unsigned long seconds) {
@@ -125,158 +140,173 @@ String getSlovenianDateTime() {
 AsyncWebServer server(80);
 
 // HTTP endpoint handlers
-void handleManualControl(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-    static String body;
-    if (index == 0) body = "";
-    for (size_t i = 0; i < len; i++) {
-        body += (char)data[i];
+// Telo sporočila REW (JSON ali MessagePack po Content-Type); false = odgovor že poslan
+static bool decodeMessageBody(AsyncWebServerRequest *request, const WireBody& body, JsonDocument& doc) {
+    if (body.overflow) {
+        LOG_ERROR("HTTP", "Sporočilo %s presega %d B", request->url().c_str(), MSG_BODY_MAX);
+        request->send(413, "application/json", "{\"status\":\"ERROR\",\"message\":\"Body too large\"}");
+        return false;
     }
-    if (index + len == total) {
-        DynamicJsonDocument doc(256);
-        DeserializationError error = deserializeJson(doc, body);
-        if (error) {
-            LOG_ERROR("HTTP", "JSON parse error: %s", error.c_str());
-            request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Invalid JSON\"}");
-            return;
-        }
+    WireFormat format = wireFormatOf(request->contentType().c_str());
+    DeserializationError error = wireDecode(doc, format, body.data, body.length);
+    if (error) {
+        LOG_ERROR("HTTP", "%s parse error: %s", format == WIRE_MSGPACK ? "MessagePack" : "JSON", error.c_str());
+        request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Invalid JSON\"}");
+        return false;
+    }
+    return true;
+}
 
-        String room = doc[FIELD_ROOM] | "";
-        String action = doc[FIELD_ACTION] | "";
+// Potrditev sporočila; REW lahko naslednja pošlje v MessagePack
+static void sendMessageOk(AsyncWebServerRequest *request) {
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", "{\"status\":\"OK\"}");
+    response->addHeader("X-Vent-Caps", "msgpack");
+    request->send(response);
+}
 
-        if (room == "" || action == "") {
-            LOG_ERROR("HTTP", "Missing room or action in MANUAL_CONTROL");
-            request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Missing room or action\"}");
-            return;
-        }
+static void sendMessageError(AsyncWebServerRequest *request, const char* message) {
+    char json[96];
+    snprintf(json, sizeof(json), "{\"status\":\"ERROR\",\"message\":\"%s\"}", message);
+    request->send(400, "application/json", json);
+}
 
-        if (action == "manual") {
-            if (room == "wc") {
-                currentData.manualTriggerWC = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - WC activated");
-            } else if (room == "ut") {
-                currentData.manualTriggerUtility = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Utility activated");
-            } else if (room == "kop") {
-                currentData.manualTriggerBathroom = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom activated");
-            } else if (room == "ds") {
-                currentData.manualTriggerLivingRoom = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Living Room activated");
-            } else {
-                LOG_ERROR("HTTP", "Unknown room: %s", room.c_str());
-                request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown room\"}");
-                return;
-            }
-        } else if (action == "toggle") {
-            if (room == "wc") {
-                currentData.disableWc = !currentData.disableWc;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - WC %s", currentData.disableWc ? "disabled" : "enabled");
-            } else if (room == "ut") {
-                if (!currentData.utilitySwitch) {
-                    // Stikalo je OFF — REW toggle ignoriran (hardware lock)
-                    LOG_INFO("HTTP", "MANUAL_CONTROL: UT toggle ignoriran - switch OFF (hardware lock)");
-                } else {
-                    currentData.disableUtility = !currentData.disableUtility;
-                    LOG_INFO("HTTP", "MANUAL_CONTROL: Utility %s via REW", currentData.disableUtility ? "disabled" : "enabled");
-                }
-            } else if (room == "kop") {
-                currentData.disableBathroom = !currentData.disableBathroom;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom %s", currentData.disableBathroom ? "disabled" : "enabled");
-            } else if (room == "ds") {
-                currentData.disableLivingRoom = !currentData.disableLivingRoom;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Living Room %s", currentData.disableLivingRoom ? "disabled" : "enabled");
-            } else {
-                LOG_ERROR("HTTP", "Unknown room: %s", room.c_str());
-                request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown room\"}");
-                return;
-            }
-        } else if (action == "drying") {
-            if (room == "ut") {
-                currentData.manualTriggerUtilityDrying = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Utility drying mode triggered");
-            } else if (room == "kop") {
-                currentData.manualTriggerBathroomDrying = true;
-                LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom drying mode triggered");
+// Reactivate REW if it was offline - async_tcp, zato le zastavica za livenessService()
+static void reactivateRew(AsyncWebServerRequest *request) {
+    if (request->client()->remoteIP().toString() == IP_REW) livenessSeen(HTTP_PEER_REW);
+}
+
+// MANUAL_CONTROL iz HTTP ali /ws (wsctl.h) - vrne nullptr ali razlog zavrnitve
+const char* applyManualControl(const JsonDocument& doc) {
+    const char* room = doc[FIELD_ROOM] | "";
+    const char* action = doc[FIELD_ACTION] | "";
+
+    if (room[0] == '\0' || action[0] == '\0') {
+        LOG_ERROR("HTTP", "Missing room or action in MANUAL_CONTROL");
+        return "Missing room or action";
+    }
+
+    if (strcmp(action, "manual") == 0) {
+        if (strcmp(room, "wc") == 0) {
+            currentData.manualTriggerWC = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - WC activated");
+        } else if (strcmp(room, "ut") == 0) {
+            currentData.manualTriggerUtility = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Utility activated");
+        } else if (strcmp(room, "kop") == 0) {
+            currentData.manualTriggerBathroom = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom activated");
+        } else if (strcmp(room, "ds") == 0) {
+            currentData.manualTriggerLivingRoom = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Living Room activated");
+        } else {
+            LOG_ERROR("HTTP", "Unknown room: %s", room);
+            return "Unknown room";
+        }
+    } else if (strcmp(action, "toggle") == 0) {
+        if (strcmp(room, "wc") == 0) {
+            currentData.disableWc = !currentData.disableWc;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - WC %s", currentData.disableWc ? "disabled" : "enabled");
+        } else if (strcmp(room, "ut") == 0) {
+            if (!currentData.utilitySwitch) {
+                // Stikalo je OFF — REW toggle ignoriran (hardware lock)
+                LOG_INFO("HTTP", "MANUAL_CONTROL: UT toggle ignoriran - switch OFF (hardware lock)");
             } else {
-                LOG_ERROR("HTTP", "Unknown room for drying action: %s", room.c_str());
-                request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown room for drying action\"}");
-                return;
+                currentData.disableUtility = !currentData.disableUtility;
+                LOG_INFO("HTTP", "MANUAL_CONTROL: Utility %s via REW", currentData.disableUtility ? "disabled" : "enabled");
             }
+        } else if (strcmp(room, "kop") == 0) {
+            currentData.disableBathroom = !currentData.disableBathroom;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom %s", currentData.disableBathroom ? "disabled" : "enabled");
+        } else if (strcmp(room, "ds") == 0) {
+            currentData.disableLivingRoom = !currentData.disableLivingRoom;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Living Room %s", currentData.disableLivingRoom ? "disabled" : "enabled");
         } else {
-            LOG_ERROR("HTTP", "Unknown action: %s", action.c_str());
-            request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown action\"}");
-            return;
+            LOG_ERROR("HTTP", "Unknown room: %s", room);
+            return "Unknown room";
         }
-
-        // Reactivate REW if it was offline
-        String clientIP = request->client()->remoteIP().toString();
-        if (clientIP == IP_REW && !rewStatus.isOnline) {
-            rewStatus.isOnline = true;
-            LOG_INFO("HTTP", "REW reaktiviran ob prejemu MANUAL_CONTROL od %s", clientIP.c_str());
+    } else if (strcmp(action, "drying") == 0) {
+        if (strcmp(room, "ut") == 0) {
+            currentData.manualTriggerUtilityDrying = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Utility drying mode triggered");
+        } else if (strcmp(room, "kop") == 0) {
+            currentData.manualTriggerBathroomDrying = true;
+            LOG_INFO("HTTP", "MANUAL_CONTROL: request received - Bathroom drying mode triggered");
+        } else {
+            LOG_ERROR("HTTP", "Unknown room for drying action: %s", room);
+            return "Unknown room for drying action";
         }
-
-        request->send(200, "application/json", "{\"status\":\"OK\"}");
+    } else {
+        LOG_ERROR("HTTP", "Unknown action: %s", action);
+        return "Unknown action";
     }
+    return nullptr;
 }
 
-void handleSensorData(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-    static String body;
-    if (index == 0) body = "";
-    for (size_t i = 0; i < len; i++) {
-        body += (char)data[i];
+// SENSOR_DATA iz HTTP ali /ws (wsctl.h)
+void applySensorData(const JsonDocument& doc) {
+    externalData.externalTemperature = doc[FIELD_EXT_TEMP] | 0.0f;
+    externalData.externalHumidity = doc[FIELD_EXT_HUM] | 0.0f;
+    externalData.externalPressure = doc[FIELD_EXT_PRESS] | 0.0f;
+    externalData.livingTempDS = doc[FIELD_DS_TEMP] | 0.0f;
+    externalData.livingHumidityDS = doc[FIELD_DS_HUM] | 0.0f;
+    JsonVariantConst co2Variant = doc[FIELD_DS_CO2];
+    if (co2Variant.is<uint16_t>()) {
+        externalData.livingCO2 = co2Variant.as<uint16_t>();
+    } else {
+        externalData.livingCO2 = 0;
+    }
+    externalData.weatherIcon = doc[FIELD_WEATHER_ICON] | "";
+    externalData.seasonCode = doc[FIELD_SEASON_CODE] | 0;
+    externalData.timestamp = doc[FIELD_TIMESTAMP] | 0;
+
+    currentData.externalTemp = externalData.externalTemperature;
+    currentData.externalHumidity = externalData.externalHumidity;
+    currentData.externalPressure = externalData.externalPressure;
+    currentData.livingTemp = externalData.livingTempDS;
+    currentData.livingHumidity = externalData.livingHumidityDS;
+    currentData.livingCO2 = externalData.livingCO2;
+
+    currentWeatherIcon = externalData.weatherIcon;
+    currentSeasonCode = externalData.seasonCode;
+
+    if (timeSynced) {
+        lastSensorDataTime = myTZ.now();
+        externalDataValid = true;
     }
-    if (index + len == total) {
-        DynamicJsonDocument doc(512);
-        DeserializationError error = deserializeJson(doc, body);
-        if (error) {
-            LOG_ERROR("HTTP", "JSON parse error: %s", error.c_str());
-            request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Invalid JSON\"}");
-            return;
-        }
-
-        externalData.externalTemperature = doc[FIELD_EXT_TEMP] | 0.0f;
-        externalData.externalHumidity = doc[FIELD_EXT_HUM] | 0.0f;
-        externalData.externalPressure = doc[FIELD_EXT_PRESS] | 0.0f;
-        externalData.livingTempDS = doc[FIELD_DS_TEMP] | 0.0f;
-        externalData.livingHumidityDS = doc[FIELD_DS_HUM] | 0.0f;
-        JsonVariant co2Variant = doc[FIELD_DS_CO2];
-        if (co2Variant.is<uint16_t>()) {
-            externalData.livingCO2 = co2Variant.as<uint16_t>();
-        } else {
-            externalData.livingCO2 = 0;
-        }
-        externalData.weatherIcon = doc[FIELD_WEATHER_ICON] | "";
-        externalData.seasonCode = doc[FIELD_SEASON_CODE] | 0;
-        externalData.timestamp = doc[FIELD_TIMESTAMP] | 0;
 
-        currentData.externalTemp = externalData.externalTemperature;
-        currentData.externalHumidity = externalData.externalHumidity;
-        currentData.externalPressure = externalData.externalPressure;
-        currentData.livingTemp = externalData.livingTempDS;
-        currentData.livingHumidity = externalData.livingHumidityDS;
-        currentData.livingCO2 = externalData.livingCO2;
+    LOG_INFO("HTTP", "SENSOR_DATA: Received - Ext: %.1f°C/%.1f%%/%.1fhPa, DS: %.1f°C/%.1f%%/%dppm, Icon: %s, Season: %d, TS: %u",
+             externalData.externalTemperature, externalData.externalHumidity, externalData.externalPressure,
+             externalData.livingTempDS, externalData.livingHumidityDS, externalData.livingCO2,
+             externalData.weatherIcon.c_str(), externalData.seasonCode, externalData.timestamp);
+}
 
-        currentWeatherIcon = externalData.weatherIcon;
-        currentSeasonCode = externalData.seasonCode;
+void handleManualControl(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    static WireBody body;
+    if (wireCollect(body, data, len, index, total)) {
+        DynamicJsonDocument doc(256);
+        if (!decodeMessageBody(request, body, doc)) return;
 
-        if (timeSynced) {
-            lastSensorDataTime = myTZ.now();
-            externalDataValid = true;
+        const char* error = applyManualControl(doc);
+        if (error) {
+            sendMessageError(request, error);
+            return;
         }
 
-        LOG_INFO("HTTP", "SENSOR_DATA: Received - Ext: %.1f°C/%.1f%%/%.1fhPa, DS: %.1f°C/%.1f%%/%dppm, Icon: %s, Season: %d, TS: %u",
-                 externalData.externalTemperature, externalData.externalHumidity, externalData.externalPressure,
-                 externalData.livingTempDS, externalData.livingHumidityDS, externalData.livingCO2,
-                 externalData.weatherIcon.c_str(), externalData.seasonCode, externalData.timestamp);
+        reactivateRew(request);
+        sendMessageOk(request);
+    }
+}
 
-        // Reactivate REW if it was offline
-        String clientIP = request->client()->remoteIP().toString();
-        if (clientIP == IP_REW && !rewStatus.isOnline) {
-            rewStatus.isOnline = true;
-            LOG_INFO("HTTP", "REW reaktiviran ob prejemu SENSOR_DATA od %s", clientIP.c_str());
-        }
+void handleSensorData(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    static WireBody body;
+    if (wireCollect(body, data, len, index, total)) {
+        DynamicJsonDocument doc(512);
+        if (!decodeMessageBody(request, body, doc)) return;
+
+        applySensorData(doc);
 
-        request->send(200, "application/json", "{\"status\":\"OK\"}");
+        reactivateRew(request);
+        sendMessageOk(request);
     }
 }
 
@@ -499,7 +529,7 @@ void handleRoot(AsyncWebServerRequest *request) {
     html += F("<div class='card'><h2>Sistem</h2>");
     html += "<div class='status-item'><span class='status-label'>Prosti RAM:</span><span class='status-value' id='sys-ram'>" + String(ramPercent, 1) + " %</span></div>";
     html += "<div class='status-item'><span class='status-label'>Uptime:</span><span class='status-value' id='sys-uptime'>" + uptimeStr + "</span></div>";
-    html += "<div class='status-item'><span class='status-label'>Log buffer:</span><span class='status-value' id='sys-log'>" + String(logBuffer.length()) + " B</span></div>";
+    html += "<div class='status-item'><span class='status-label'>Log buffer:</span><span class='status-value' id='sys-log'>" + String(getLogPendingBytes(LOG_CONSUMER_REW)) + " B</span></div>";
     html += F("</div>");
 
     // Status Card
@@ -525,75 +555,87 @@ void handleRoot(AsyncWebServerRequest *request) {
 
     // JS
     html += F("<script>"
+        "let cur={};"
+        "function render(d){"
+            "document.getElementById('dateDisplay').textContent=d.current_time;"
+            "document.getElementById('wc-pressure').textContent=d.bathroom_pressure+' hPa';"
+            "document.getElementById('wc-light').textContent=d.wc_light?'ON':'OFF';"
+            "document.getElementById('wc-fan').textContent=d.wc_disabled?'DISABLED':(d.wc_fan?'ON':'OFF');"
+            "document.getElementById('wc-remaining').textContent=d.wc_remaining+' s';"
+            "document.getElementById('kop-temp').textContent=d.bathroom_temp+' °C';"
+            "document.getElementById('kop-humidity').textContent=d.bathroom_humidity+' %';"
+            "document.getElementById('kop-button').textContent=d.bathroom_button?'Pritisnjena':'Nepritisnjena';"
+            "document.getElementById('kop-light1').textContent=d.bathroom_light1?'ON':'OFF';"
+            "document.getElementById('kop-light2').textContent=d.bathroom_light2?'ON':'OFF';"
+            "document.getElementById('kop-fan').textContent=d.bathroom_disabled?'DISABLED':(d.bathroom_fan?'ON':'OFF');"
+            "document.getElementById('kop-remaining').textContent=d.bathroom_remaining+' s';"
+            "document.getElementById('kop-drying-mode').textContent=d.bathroom_drying_mode?'DA':'NE';"
+            "document.getElementById('kop-cycle-mode').textContent=d.bathroom_cycle_mode;"
+            "if(d.bathroom_expected_end_time&&d.bathroom_expected_end_time>0){"
+                "const dt=new Date(d.bathroom_expected_end_time*1000);"
+                "document.getElementById('kop-expected-end').textContent=dt.getHours().toString().padStart(2,'0')+':'+dt.getMinutes().toString().padStart(2,'0')+':'+dt.getSeconds().toString().padStart(2,'0');"
+            "}else{document.getElementById('kop-expected-end').textContent='N/A';}"
+            "document.getElementById('ut-temp').textContent=d.utility_temp+' °C';"
+            "document.getElementById('ut-humidity').textContent=d.utility_humidity+' %';"
+            "document.getElementById('ut-light').textContent=d.utility_light?'ON':'OFF';"
+            "document.getElementById('ut-switch').textContent=d.utility_switch?'ON':'OFF';"
+            "document.getElementById('ut-fan').textContent=d.utility_disabled?'DISABLED':(d.utility_fan?'ON':'OFF');"
+            "document.getElementById('ut-remaining').textContent=d.utility_remaining+' s';"
+            "document.getElementById('ut-drying-mode').textContent=d.utility_drying_mode?'DA':'NE';"
+            "document.getElementById('ut-cycle-mode').textContent=d.utility_cycle_mode;"
+            "if(d.utility_expected_end_time&&d.utility_expected_end_time>0){"
+                "const dt=new Date(d.utility_expected_end_time*1000);"
+                "document.getElementById('ut-expected-end').textContent=dt.getHours().toString().padStart(2,'0')+':'+dt.getMinutes().toString().padStart(2,'0')+':'+dt.getSeconds().toString().padStart(2,'0');"
+            "}else{document.getElementById('ut-expected-end').textContent='N/A';}"
+            "document.getElementById('ds-temp').textContent=d.living_temp+' °C';"
+            "document.getElementById('ds-humidity').textContent=d.living_humidity+' %';"
+            "document.getElementById('ds-co2').textContent=d.living_co2+' ppm';"
+            "document.getElementById('ds-window1').textContent=d.living_window2?'Odprto':'Zaprto';"
+            "document.getElementById('ds-window2').textContent=d.living_window1?'Odprto':'Zaprto';"
+            "document.getElementById('ds-fan-level').textContent=d.living_fan_level;"
+            "document.getElementById('ds-duty-cycle').textContent=d.living_duty_cycle+' %';"
+            "document.getElementById('ds-remaining').textContent=d.living_remaining+' s';"
+            "document.getElementById('ext-temp').textContent=d.external_temp+' °C';"
+            "document.getElementById('ext-humidity').textContent=d.external_humidity+' %';"
+            "document.getElementById('ext-pressure').textContent=d.external_pressure+' hPa';"
+//            "document.getElementById('ext-light').textContent=d.external_light+' lux';"
+            "document.getElementById('power-3v3').textContent=d.supply_3v3+' V';"
+            "document.getElementById('power-5v').textContent=d.supply_5v+' V';"
+            "document.getElementById('power-current').textContent=d.current_power+' W';"
+            "document.getElementById('power-energy').textContent=d.energy_consumption+' Wh';"
+            "document.getElementById('sys-ram').textContent=d.ram_percent+' %';"
+            "document.getElementById('sys-uptime').textContent=d.uptime;"
+            "document.getElementById('sys-log').textContent=d.log_buffer_size+' B';"
+            "document.getElementById('status-external').textContent=d.external_data_valid?'VELJAVNI':'NEVELJAVNI';"
+            "document.getElementById('status-bme280').textContent=(d.error_flags&1)?'NAPAKA':'OK';"
+            "document.getElementById('status-sht41').textContent=(d.error_flags&2)?'NAPAKA':'OK';"
+            "document.getElementById('status-power').textContent=(d.error_flags&64)?'NAPAKA':'OK';"
+            "document.getElementById('status-ntp').textContent=d.time_synced?'OK':'NESINHRONIZIRAN';"
+            "document.getElementById('status-time-rew').textContent=(d.external_data_valid&&d.time_synced&&Math.abs(d.server_timestamp-d.external_timestamp)<=300)?'OK':'RAZHAJANJE >5min';"
+            "document.getElementById('status-rew').textContent=d.rew_online?'ONLINE':'OFFLINE';"
+            "document.getElementById('status-ut-dew').textContent=d.ut_dew_online?'ONLINE':'OFFLINE';"
+            "document.getElementById('status-kop-dew').textContent=d.kop_dew_online?'ONLINE':'OFFLINE';"
+        "}"
+        "function merge(d){Object.assign(cur,d);render(cur);}"
         "function updatePage(isAjax=false){"
             "const opts=isAjax?{headers:{'X-Requested-With':'XMLHttpRequest'}}:{};"
-            "fetch('/current-data',opts).then(r=>r.json()).then(d=>{"
-                "document.getElementById('dateDisplay').textContent=d.current_time;"
-                "document.getElementById('wc-pressure').textContent=d.bathroom_pressure+' hPa';"
-                "document.getElementById('wc-light').textContent=d.wc_light?'ON':'OFF';"
-                "document.getElementById('wc-fan').textContent=d.wc_disabled?'DISABLED':(d.wc_fan?'ON':'OFF');"
-                "document.getElementById('wc-remaining').textContent=d.wc_remaining+' s';"
-                "document.getElementById('kop-temp').textContent=d.bathroom_temp+' °C';"
-                "document.getElementById('kop-humidity').textContent=d.bathroom_humidity+' %';"
-                "document.getElementById('kop-button').textContent=d.bathroom_button?'Pritisnjena':'Nepritisnjena';"
-                "document.getElementById('kop-light1').textContent=d.bathroom_light1?'ON':'OFF';"
-                "document.getElementById('kop-light2').textContent=d.bathroom_light2?'ON':'OFF';"
-                "document.getElementById('kop-fan').textContent=d.bathroom_disabled?'DISABLED':(d.bathroom_fan?'ON':'OFF');"
-                "document.getElementById('kop-remaining').textContent=d.bathroom_remaining+' s';"
-                "document.getElementById('kop-drying-mode').textContent=d.bathroom_drying_mode?'DA':'NE';"
-                "document.getElementById('kop-cycle-mode').textContent=d.bathroom_cycle_mode;"
-                "if(d.bathroom_expected_end_time&&d.bathroom_expected_end_time>0){"
-                    "const dt=new Date(d.bathroom_expected_end_time*1000);"
-                    "document.getElementById('kop-expected-end').textContent=dt.getHours().toString().padStart(2,'0')+':'+dt.getMinutes().toString().padStart(2,'0')+':'+dt.getSeconds().toString().padStart(2,'0');"
-                "}else{document.getElementById('kop-expected-end').textContent='N/A';}"
-                "document.getElementById('ut-temp').textContent=d.utility_temp+' °C';"
-                "document.getElementById('ut-humidity').textContent=d.utility_humidity+' %';"
-                "document.getElementById('ut-light').textContent=d.utility_light?'ON':'OFF';"
-                "document.getElementById('ut-switch').textContent=d.utility_switch?'ON':'OFF';"
-                "document.getElementById('ut-fan').textContent=d.utility_disabled?'DISABLED':(d.utility_fan?'ON':'OFF');"
-                "document.getElementById('ut-remaining').textContent=d.utility_remaining+' s';"
-                "document.getElementById('ut-drying-mode').textContent=d.utility_drying_mode?'DA':'NE';"
-                "document.getElementById('ut-cycle-mode').textContent=d.utility_cycle_mode;"
-                "if(d.utility_expected_end_time&&d.utility_expected_end_time>0){"
-                    "const dt=new Date(d.utility_expected_end_time*1000);"
-                    "document.getElementById('ut-expected-end').textContent=dt.getHours().toString().padStart(2,'0')+':'+dt.getMinutes().toString().padStart(2,'0')+':'+dt.getSeconds().toString().padStart(2,'0');"
-                "}else{document.getElementById('ut-expected-end').textContent='N/A';}"
-                "document.getElementById('ds-temp').textContent=d.living_temp+' °C';"
-                "document.getElementById('ds-humidity').textContent=d.living_humidity+' %';"
-                "document.getElementById('ds-co2').textContent=d.living_co2+' ppm';"
-                "document.getElementById('ds-window1').textContent=d.living_window2?'Odprto':'Zaprto';"
-                "document.getElementById('ds-window2').textContent=d.living_window1?'Odprto':'Zaprto';"
-                "document.getElementById('ds-fan-level').textContent=d.living_fan_level;"
-                "document.getElementById('ds-duty-cycle').textContent=d.living_duty_cycle+' %';"
-                "document.getElementById('ds-remaining').textContent=d.living_remaining+' s';"
-                "document.getElementById('ext-temp').textContent=d.external_temp+' °C';"
-                "document.getElementById('ext-humidity').textContent=d.external_humidity+' %';"
-                "document.getElementById('ext-pressure').textContent=d.external_pressure+' hPa';"
-//                "document.getElementById('ext-light').textContent=d.external_light+' lux';"
-                "document.getElementById('power-3v3').textContent=d.supply_3v3+' V';"
-                "document.getElementById('power-5v').textContent=d.supply_5v+' V';"
-                "document.getElementById('power-current').textContent=d.current_power+' W';"
-                "document.getElementById('power-energy').textContent=d.energy_consumption+' Wh';"
-                "document.getElementById('sys-ram').textContent=d.ram_percent+' %';"
-                "document.getElementById('sys-uptime').textContent=d.uptime;"
-                "document.getElementById('sys-log').textContent=d.log_buffer_size+' B';"
-                "document.getElementById('status-external').textContent=d.external_data_valid?'VELJAVNI':'NEVELJAVNI';"
-                "document.getElementById('status-bme280').textContent=(d.error_flags&1)?'NAPAKA':'OK';"
-                "document.getElementById('status-sht41').textContent=(d.error_flags&2)?'NAPAKA':'OK';"
-                "document.getElementById('status-power').textContent=(d.error_flags&64)?'NAPAKA':'OK';"
-                "document.getElementById('status-ntp').textContent=d.time_synced?'OK':'NESINHRONIZIRAN';"
-                "document.getElementById('status-time-rew').textContent=(d.external_data_valid&&d.time_synced&&Math.abs(d.server_timestamp-d.external_timestamp)<=300)?'OK':'RAZHAJANJE >5min';"
-                "document.getElementById('status-rew').textContent=d.rew_online?'ONLINE':'OFFLINE';"
-                "document.getElementById('status-ut-dew').textContent=d.ut_dew_online?'ONLINE':'OFFLINE';"
-                "document.getElementById('status-kop-dew').textContent=d.kop_dew_online?'ONLINE':'OFFLINE';"
-            "}).catch(e=>console.error('Napaka pri osveževanju:',e));"
+            "fetch('/current-data',opts).then(r=>r.json()).then(merge)"
+            ".catch(e=>console.error('Napaka pri osveževanju:',e));"
         "}"
         "function triggerDrying(room){"
             "fetch('/api/manual-control',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({room:room,action:'drying'})})"
             ".then(r=>r.json()).then(d=>{if(d.status!=='OK')console.error('Error:',d.message);})"
             ".catch(e=>console.error('Error:',e));"
         "}"
-        "setInterval(()=>updatePage(true),10000);"
+        // Spremembe prek /events (dashpush.h); polling le brez EventSource ali med prekinitvijo
+        "let poll=null;"
+        "function startPoll(){if(!poll)poll=setInterval(()=>updatePage(true),10000);}"
+        "if(window.EventSource){"
+            "const es=new EventSource('/events');"
+            "['full','delta','tick'].forEach(t=>es.addEventListener(t,e=>merge(JSON.parse(e.data))));"
+            "es.onopen=()=>{if(poll){clearInterval(poll);poll=null;}};"
+            "es.onerror=()=>startPoll();"
+        "}else startPoll();"
         "updatePage();"
     "</script></div></body></html>");
 
@@ -956,6 +998,42 @@ void handleCurrentDataRequest(AsyncWebServerRequest *request) {
     float ramPercent = (ESP.getHeapSize() - ESP.getFreeHeap()) * 100.0 / ESP.getHeapSize();
     String uptimeStr = formatUptime(millis() / 1000);
 
+    SdLogStatus sdLog;
+    getSdLogStatus(sdLog);
+    LogSerialStats serialLog;
+    getLogSerialStats(serialLog);
+    LogLimitStats logLimit;
+    logLimitGetStats(logLimit);
+    StatusDeltaStats statusDelta;
+    getStatusDeltaStats(statusDelta);
+    McastStats mcast;
+    getStateMulticastStats(mcast);
+    OutboxStats rewOutbox;
+    outboxGetStats(HTTP_PEER_REW, rewOutbox);
+    ControlSocketStats wsStats;
+    getControlSocketStats(wsStats);
+#ifdef MQTT_TELEMETRY
+    MqttStats mqttStats;
+    getMqttStats(mqttStats);
+    String mqtt = String("\"mqtt_connected\":") + String(mqttStats.connected ? "true" : "false") + "," +
+                  "\"mqtt_published\":" + String(mqttStats.published) + "," +
+                  "\"mqtt_deferred\":" + String(mqttStats.deferred) + "," +
+                  "\"mqtt_commands\":" + String(mqttStats.commands) + ",";
+#else
+    String mqtt;
+#endif
+
+    // RTT (EWMA), jitter in zaporedni neuspehi po enotah - rew_rtt_ms, ut_dew_rtt_ms, ...
+    static const char* const livenessKeys[3] = {"rew", "ut_dew", "kop_dew"};
+    String liveness;
+    for (int i = 0; i < 3; i++) {
+        LivenessStats l;
+        livenessGetStats((HttpPeerId)i, l);
+        liveness += String("\"") + livenessKeys[i] + "_rtt_ms\":" + String(l.rttMs, 1) + "," +
+                    "\"" + livenessKeys[i] + "_jitter_ms\":" + String(l.jitterMs, 1) + "," +
+                    "\"" + livenessKeys[i] + "_failures\":" + String(l.consecutiveFailures) + ",";
+    }
+
     String json = "{" +
                   String("\"current_time\":\"") + String(myTZ.dateTime().c_str()) + "\"," +
                   String("\"is_dnd\":") + String(isDNDTime() ? "true" : "false") + "," +
@@ -972,6 +1050,7 @@ void handleCurrentDataRequest(AsyncWebServerRequest *request) {
                   String("\"bathroom_drying_mode\":") + String(currentData.bathroomDryingMode ? "true" : "false") + "," +
                   String("\"bathroom_cycle_mode\":") + String(currentData.bathroomCycleMode) + "," +
                   String("\"bathroom_expected_end_time\":") + String(currentData.bathroomExpectedEndTime) + "," +
+                  String("\"bathroom_sample_interval\":") + String(currentData.bathroomSampleInterval) + "," +
                   String("\"utility_temp\":") + String(currentData.utilityTemp, 1) + "," +
                   String("\"utility_humidity\":") + String(currentData.utilityHumidity, 1) + "," +
                   String("\"utility_light\":") + String(currentData.utilityLight ? "true" : "false") + "," +
@@ -982,6 +1061,7 @@ void handleCurrentDataRequest(AsyncWebServerRequest *request) {
                   String("\"utility_drying_mode\":") + String(currentData.utilityDryingMode ? "true" : "false") + "," +
                   String("\"utility_cycle_mode\":") + String(currentData.utilityCycleMode) + "," +
                   String("\"utility_expected_end_time\":") + String(currentData.utilityExpectedEndTime) + "," +
+                  String("\"utility_sample_interval\":") + String(currentData.utilitySampleInterval) + "," +
                   String("\"wc_light\":") + String(currentData.wcLight ? "true" : "false") + "," +
                   String("\"wc_fan\":") + String(currentData.wcFan ? "true" : "false") + "," +
                   String("\"wc_disabled\":") + String(currentData.disableWc ? "true" : "false") + "," +
@@ -1001,13 +1081,44 @@ void handleCurrentDataRequest(AsyncWebServerRequest *request) {
 //                  String("\"external_light\":") + String(currentData.externalLight, 1) + "," +
                   String("\"supply_3v3\":") + String(currentData.supply3V3, 3) + "," +
                   String("\"supply_5v\":") + String(currentData.supply5V, 3) + "," +
+                  String("\"supply_5v_min\":") + String(currentData.supply5VMin, 3) + "," +
+                  String("\"supply_5v_max\":") + String(currentData.supply5VMax, 3) + "," +
+                  String("\"supply_sag_count\":") + String(currentData.supplySagCount) + "," +
                   String("\"current_power\":") + String(currentData.currentPower, 1) + "," +
                   String("\"energy_consumption\":") + String(currentData.energyConsumption, 1) + "," +
                   String("\"time_synced\":") + String(timeSynced ? "true" : "false") + "," +
                   String("\"external_data_valid\":") + String(externalDataValid ? "true" : "false") + "," +
                   String("\"ram_percent\":") + String(ramPercent, 1) + "," +
                   String("\"uptime\":\"") + uptimeStr + "\"," +
-                  String("\"log_buffer_size\":") + String(logBuffer.length()) + "," +
+                  String("\"log_buffer_size\":") + String(getLogPendingBytes(LOG_CONSUMER_REW)) + "," +
+                  String("\"sd_log_active\":") + String(sdLog.active ? "true" : "false") + "," +
+                  String("\"sd_log_bytes\":") + String(sdLog.dataBytes) + "," +
+                  String("\"sd_log_errors\":") + String(sdLog.writeErrors) + "," +
+                  String("\"sd_query_window_s\":") + String(sdLog.queryWindow) + "," +
+                  String("\"sd_query_ms\":") + String(sdLog.queryMs) + "," +
+                  String("\"sd_query_read_ms\":") + String(sdLog.queryReadMs) + "," +
+                  String("\"sd_query_first_line_ms\":") + String(sdLog.queryFirstLineMs) + "," +
+                  String("\"sd_query_kb\":") + String(sdLog.queryBytes / 1024) + "," +
+                  String("\"sd_query_files\":") + String(sdLog.queryFiles) + "," +
+                  String("\"serial_log_pending\":") + String(serialLog.pendingRecords) + "," +
+                  String("\"serial_log_dropped\":") + String(serialLog.dropped) + "," +
+                  String("\"serial_log_lagged\":") + String(serialLog.lagged) + "," +
+                  String("\"log_suppressed\":") + String(logLimit.suppressed) + "," +
+                  String("\"log_rate_dropped\":") + String(logLimit.rateDropped) + "," +
+                  String("\"status_delta\":") + String(statusDelta.enabled ? "true" : "false") + "," +
+                  String("\"status_bytes_sent\":") + String(statusDelta.bytesSent) + "," +
+                  String("\"status_bytes_full\":") + String(statusDelta.bytesFull) + "," +
+                  String("\"mcast_seq\":") + String(mcast.seq) + "," +
+                  String("\"mcast_errors\":") + String(mcast.errors) + "," +
+                  String("\"ws_rew_connected\":") + String(wsStats.rewConnected ? "true" : "false") + "," +
+                  String("\"ws_frames\":") + String(wsStats.frames) + "," +
+                  String("\"ws_rejected\":") + String(wsStats.rejected) + "," +
+                  String("\"ws_push_failures\":") + String(wsStats.pushFailures) + "," +
+                  mqtt +
+                  String("\"rew_outbox_events\":") + String(rewOutbox.events) + "," +
+                  String("\"rew_outbox_dropped\":") + String(rewOutbox.dropped) + "," +
+                  String("\"rew_retry_in_ms\":") + String(rewOutbox.retryInMs) + "," +
+                  liveness +
                   String("\"rew_online\":") + String(rewStatus.isOnline ? "true" : "false") + "," +
                   String("\"ut_dew_online\":") + String(utDewStatus.isOnline ? "true" : "false") + "," +
                   String("\"kop_dew_online\":") + String(kopDewStatus.isOnline ? "true" : "false") + "," +
@@ -1159,11 +1270,391 @@ void handleSettingsStatus(AsyncWebServerRequest *request) {
     request->send(200, "application/json", response);
 }
 
-// Handle logs page - displays RAM log buffer
-void handleLogs(AsyncWebServerRequest *request) {
-    // Ne logiramo GET /logs zahtevkov - polling zahteve brez operativne vrednosti
+// I2C telemetrija kot JSON - števci in histogram latenc po napravi
+static void addI2CDeviceStats(JsonObject obj, const I2CDeviceStats& stats) {
+    obj["transactions"] = stats.transactions;
+    obj["nacks"] = stats.nacks;
+    obj["timeouts"] = stats.timeouts;
+    obj["other_errors"] = stats.otherErrors;
+    obj["invalid_reads"] = stats.invalidReads;
+    obj["reinits"] = stats.reinits;
+    obj["last_latency_ms"] = stats.lastLatencyMs;
+    obj["max_latency_ms"] = stats.maxLatencyMs;
+    JsonArray hist = obj.createNestedArray("latency_hist");
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++) {
+        JsonObject bucket = hist.createNestedObject();
+        if (i2cLatencyBucketsMs[i] == 0xFFFF) bucket["le"] = "+Inf";
+        else bucket["le"] = i2cLatencyBucketsMs[i];
+        bucket["count"] = stats.latencyHist[i];
+    }
+}
 
-    String html = F("<!DOCTYPE HTML><html><head>"
+void handleI2CStats(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(2048);
+    doc["bus_recoveries"] = i2cStats.busRecoveries;
+    doc["bus_recovery_failures"] = i2cStats.busRecoveryFailures;
+    doc["sda_stuck"] = i2cStats.sdaStuck;
+    doc["bus_reinits"] = i2cStats.busReinits;
+    doc["last_recovery_ms"] = i2cStats.lastRecoveryMs;
+    doc["max_recovery_ms"] = i2cStats.maxRecoveryMs;
+    doc["lost_control_ticks"] = i2cStats.lostControlTicks;
+    JsonObject lostByFault = doc.createNestedObject("lost_control_ticks_by_fault");
+    lostByFault["none"] = i2cStats.lostControlTicksByFault[I2C_FAULT_NONE];
+    lostByFault["nack"] = i2cStats.lostControlTicksByFault[I2C_FAULT_NACK];
+    lostByFault["timeout"] = i2cStats.lostControlTicksByFault[I2C_FAULT_TIMEOUT];
+    lostByFault["sda"] = i2cStats.lostControlTicksByFault[I2C_FAULT_SDA_STUCK];
+    lostByFault["garbage"] = i2cStats.lostControlTicksByFault[I2C_FAULT_GARBAGE];
+    addI2CDeviceStats(doc.createNestedObject("sht41"), i2cStats.sht41);
+    addI2CDeviceStats(doc.createNestedObject("bme280"), i2cStats.bme280);
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+#ifdef I2C_FAULT_INJECTION
+// Nastavi urnik vbrizganih I2C napak: /api/i2c-fault?mode=nack|timeout|sda|garbage|none&addr=68&count=5
+void handleI2CFault(AsyncWebServerRequest *request) {
+    String mode = request->hasParam("mode") ? request->getParam("mode")->value() : "none";
+    uint8_t address = request->hasParam("addr") ? request->getParam("addr")->value().toInt() : 0;
+    uint16_t count = request->hasParam("count") ? request->getParam("count")->value().toInt() : 1;
+
+    I2CFaultMode faultMode;
+    if (mode == "nack") faultMode = I2C_FAULT_NACK;
+    else if (mode == "timeout") faultMode = I2C_FAULT_TIMEOUT;
+    else if (mode == "sda") faultMode = I2C_FAULT_SDA_STUCK;
+    else if (mode == "garbage") faultMode = I2C_FAULT_GARBAGE;
+    else if (mode == "none") { faultMode = I2C_FAULT_NONE; count = 0; }
+    else {
+        request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown mode\"}");
+        return;
+    }
+
+    scheduleI2CFault(faultMode, address, count);
+    request->send(200, "application/json", "{\"status\":\"OK\"}");
+}
+#endif
+
+#ifdef HTTP_BENCH
+// Meritev msg/s proti nadomestnemu strežniku (tools/http_standin.py):
+// /api/http-bench?host=192.168.2.50&n=200 sproži, brez host vrne zadnji rezultat
+void handleHttpBench(AsyncWebServerRequest *request) {
+    if (request->hasParam("host")) {
+        long n = request->hasParam("n") ? request->getParam("n")->value().toInt() : 100;
+        httpBenchRequest(request->getParam("host")->value().c_str(), constrain(n, 1, 1000));
+    }
+    HttpBenchResult result;
+    httpBenchGetResult(result);
+    DynamicJsonDocument doc(256);
+    doc["running"] = result.running;
+    doc["messages"] = result.messages;
+    doc["fresh_msg_s"] = result.freshPerSec;
+    doc["fresh_failures"] = result.freshFailures;
+    doc["keepalive_msg_s"] = result.keepAlivePerSec;
+    doc["keepalive_failures"] = result.keepAliveFailures;
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+#endif
+
+// Pragi nivojev po tagu: GET vrne tabelo, POST tag=<ime|*>&level=<DEBUG|INFO|WARN|ERROR|OFF>
+static int parseLogLevel(String value) {
+    value.toUpperCase();
+    if (value == "OFF") return LOG_LEVEL_ERROR + 1;
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_ERROR; i++) {
+        if (value == logLevelName(i) || value == String(i)) return i;
+    }
+    return -1;
+}
+
+void handleGetLogLevels(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(1536);
+    doc["min_level"] = logLevelName(LOG_MIN_LEVEL);
+    JsonObject tags = doc.createNestedObject("tags");
+    for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+        uint8_t level = logTagLevels[i];
+        tags[logTagName(i)] = level > LOG_LEVEL_ERROR ? "OFF" : logLevelName(level);
+    }
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void handlePostLogLevels(AsyncWebServerRequest *request) {
+    if (!request->hasParam("tag", true) || !request->hasParam("level", true)) {
+        request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Missing tag or level\"}");
+        return;
+    }
+    String tagName = request->getParam("tag", true)->value();
+    int level = parseLogLevel(request->getParam("level", true)->value());
+    uint8_t tag = tagName == "*" ? LOG_TAG_COUNT : logTagId(tagName.c_str());
+    if (level < 0 || (tag == LOG_TAG_OTHER && tagName != logTagName(LOG_TAG_OTHER))) {
+        request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"Unknown tag or level\"}");
+        return;
+    }
+
+    setLogTagLevel(tag, level);
+    saveLogTagLevels();
+    LOG_INFO("Web", "Log nivo %s -> %s", tagName.c_str(), level > LOG_LEVEL_ERROR ? "OFF" : logLevelName(level));
+    handleGetLogLevels(request);
+}
+
+// Surovi izpis log ringa za tools/logdecode.py (odloženi zapisi ostanejo neoblikovani)
+// Oblika: "CLG1", nato zapisi <u32 seq><u32 ts><u8 level><u8 tag><u16 len><payload>
+struct LogRawDumpState {
+    LogCursor cursor;
+    LogEntry entry;
+    uint8_t pending[12 + LOG_RING_MSG_MAX];
+    size_t pendingLen;
+    size_t pendingPos;
+};
+
+void handleLogsRaw(AsyncWebServerRequest *request) {
+    std::shared_ptr<LogRawDumpState> state = std::make_shared<LogRawDumpState>();
+    logRingCursorAtOldest(state->cursor);
+    memcpy(state->pending, "CLG1", 4);
+    state->pendingLen = 4;
+    state->pendingPos = 0;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/octet-stream",
+        [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t written = 0;
+            while (written < maxLen) {
+                if (state->pendingPos == state->pendingLen) {
+                    if (!logRingRead(state->cursor, state->entry)) break;
+                    const LogEntry& e = state->entry;
+                    uint8_t* p = state->pending;
+                    memcpy(p, &e.seq, 4);
+                    memcpy(p + 4, &e.timestamp, 4);
+                    p[8] = e.level;
+                    p[9] = e.tag;
+                    memcpy(p + 10, &e.length, 2);
+                    memcpy(p + 12, e.text, e.length);
+                    state->pendingLen = 12 + e.length;
+                    state->pendingPos = 0;
+                }
+                size_t n = state->pendingLen - state->pendingPos;
+                if (n > maxLen - written) n = maxLen - written;
+                memcpy(buffer + written, state->pending + state->pendingPos, n);
+                state->pendingPos += n;
+                written += n;
+            }
+            return written;
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=cee_log.bin");
+    request->send(response);
+}
+
+// Handle logs page - streama log ring v chunkih (brez sestavljanja celotne strani v RAM)
+// Parametri: since=<seq>, level=<DEBUG|INFO|WARN|ERROR> (minimalni nivo),
+// tag=<ime>, limit=<n>, format=html|text|ndjson
+enum LogStreamFormat : uint8_t {
+    LOG_STREAM_HTML = 0,
+    LOG_STREAM_TEXT,
+    LOG_STREAM_NDJSON
+};
+
+enum LogStreamEscape : uint8_t {
+    LOG_ESCAPE_NONE = 0,
+    LOG_ESCAPE_HTML,
+    LOG_ESCAPE_JSON
+};
+
+enum LogStreamPhase : uint8_t {
+    LOG_PHASE_HEADER = 0,
+    LOG_PHASE_LINES,
+    LOG_PHASE_FOOTER,
+    LOG_PHASE_DONE
+};
+
+struct LogStreamSegment {
+    const char* data;
+    size_t length;
+    LogStreamEscape escape;
+};
+
+// Vrsta segmentov ene izhodne vrstice (/logs, /api/logs/query)
+struct LogSegmentEmitter {
+    LogStreamSegment segments[3];
+    uint8_t count;
+    uint8_t index;
+    size_t pos;
+};
+
+struct LogStreamState {
+    LogStreamFormat format;
+    LogStreamPhase phase;
+    LogCursor cursor;
+    int8_t minLevel;         // -1 = vsi nivoji
+    int16_t tag;             // -1 = vsi tagi
+    uint32_t limit;
+    uint32_t emitted;
+    uint32_t startSeq;
+    uint32_t firstEmittedSeq;
+    uint32_t lastEmittedSeq;
+    String query;            // filtri za povezave (brez since)
+    String page;             // glava/noga HTML
+    LogEntry entry;
+    char prefix[112];
+    char line[LOG_LINE_MAX];
+    LogSegmentEmitter emit;
+};
+
+// Izpiše čakajoče segmente; escape se izvaja sproti, znak po znak
+static size_t emitLogSegments(LogSegmentEmitter& em, uint8_t* out, size_t maxLen) {
+    size_t written = 0;
+    while (em.index < em.count) {
+        const LogStreamSegment& seg = em.segments[em.index];
+        if (seg.escape == LOG_ESCAPE_NONE) {
+            size_t n = seg.length - em.pos;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(out + written, seg.data + em.pos, n);
+            em.pos += n;
+            written += n;
+        } else {
+            while (em.pos < seg.length) {
+                char c = seg.data[em.pos];
+                char tmp[8];
+                const char* rep = nullptr;
+                if (seg.escape == LOG_ESCAPE_HTML) {
+                    if (c == '&') rep = "&amp;";
+                    else if (c == '<') rep = "&lt;";
+                    else if (c == '>') rep = "&gt;";
+                } else {
+                    if (c == '"') rep = "\\\"";
+                    else if (c == '\\') rep = "\\\\";
+                    else if (c == '\n') rep = "\\n";
+                    else if ((uint8_t)c < 0x20) {
+                        snprintf(tmp, sizeof(tmp), "\\u%04x", (uint8_t)c);
+                        rep = tmp;
+                    }
+                }
+                size_t repLen = rep ? strlen(rep) : 1;
+                if (written + repLen > maxLen) return written;
+                if (rep) memcpy(out + written, rep, repLen);
+                else out[written] = c;
+                written += repLen;
+                em.pos++;
+            }
+        }
+        if (em.pos < seg.length) return written;
+        em.index++;
+        em.pos = 0;
+    }
+    return written;
+}
+
+static void setLogSegments(LogSegmentEmitter& em, std::initializer_list<LogStreamSegment> segs) {
+    em.count = 0;
+    for (const LogStreamSegment& seg : segs) em.segments[em.count++] = seg;
+    em.index = 0;
+    em.pos = 0;
+}
+
+static bool logStreamMatches(const LogStreamState& st, const LogEntry& e) {
+    uint8_t level = e.level & ~LOG_LEVEL_DEFERRED_FLAG;
+    if (st.minLevel >= 0 && level < st.minLevel) return false;
+    if (st.tag >= 0 && e.tag != st.tag) return false;
+    return true;
+}
+
+// Naslednji zapis, ki ustreza filtrom; oblikuje se samo ujemajoč zapis
+static bool nextLogStreamEntry(LogStreamState& st) {
+    while (logRingRead(st.cursor, st.entry)) {
+        if (!logStreamMatches(st, st.entry)) continue;
+        renderLogEntry(st.entry);
+        return true;
+    }
+    return false;
+}
+
+// Prešteje ujemajoče zapise s seq v [from, to); ob stopAt-tem (od 0) ujemanju
+// vpiše njegov seq v stopSeq in se ustavi. ringMux je zaklenjen samo med
+// posameznim seek/branjem.
+static uint32_t scanLogBlock(LogStreamState& st, uint32_t from, uint32_t to,
+                             uint32_t stopAt, uint32_t& stopSeq) {
+    LogCursor c = {};
+    logRingSeek(c, from);
+    uint32_t matches = 0;
+    while (logRingRead(c, st.entry) && (int32_t)(st.entry.seq - to) < 0) {
+        if (!logStreamMatches(st, st.entry)) continue;
+        if (matches++ == stopAt) {
+            stopSeq = st.entry.seq;
+            break;
+        }
+    }
+    return matches;
+}
+
+// Začetek strani, ki se konča pred endSeq in vsebuje `limit` zapisov, ki
+// ustrezajo filtrom (ali najstarejši zapis). Hoja nazaj od endSeq v blokih po
+// LOG_WEB_SCAN_BLOCK zapisov, vsak blok se prebere naprej; drugi prehod samo
+// čez blok, v katerem se stran začne. Delo je sorazmerno dolžini strani, ne ringu.
+static uint32_t findLogPageStart(LogStreamState& st, uint32_t endSeq) {
+    LogRingStats stats;
+    logRingGetStats(stats);
+    uint32_t need = st.limit;
+    uint32_t blockEnd = endSeq;
+    while ((int32_t)(blockEnd - stats.firstSeq) > 0) {
+        uint32_t blockStart = blockEnd - stats.firstSeq > LOG_WEB_SCAN_BLOCK ?
+                              blockEnd - LOG_WEB_SCAN_BLOCK : stats.firstSeq;
+        uint32_t start = blockStart;
+        uint32_t matches = scanLogBlock(st, blockStart, blockEnd, UINT32_MAX, start);
+        if (matches >= need) {
+            scanLogBlock(st, blockStart, blockEnd, matches - need, start);
+            return start;
+        }
+        need -= matches;
+        blockEnd = blockStart;
+        logRingGetStats(stats);   // pisec med hojo prepisuje najstarejše zapise
+    }
+    return stats.firstSeq;
+}
+
+static bool logStreamFiltered(const LogStreamState& st) {
+    return st.minLevel > LOG_LEVEL_DEBUG || st.tag >= 0;
+}
+
+static void buildLogStreamLine(LogStreamState& st) {
+    const LogEntry& e = st.entry;
+    switch (st.format) {
+        case LOG_STREAM_TEXT: {
+            size_t len = formatLogLine(e, st.line, sizeof(st.line));
+            setLogSegments(st.emit, {{st.line, len, LOG_ESCAPE_NONE}});
+            break;
+        }
+        case LOG_STREAM_NDJSON: {
+            int n = snprintf(st.prefix, sizeof(st.prefix),
+                             "{\"seq\":%lu,\"ts\":%lu,\"level\":\"%s\",\"tag\":\"%s\",\"msg\":\"",
+                             (unsigned long)e.seq, (unsigned long)e.timestamp,
+                             logLevelName(e.level), logTagName(e.tag));
+            setLogSegments(st.emit, {{st.prefix, (size_t)n, LOG_ESCAPE_NONE},
+                                {e.text, e.length, LOG_ESCAPE_JSON},
+                                {"\"}\n", 3, LOG_ESCAPE_NONE}});
+            break;
+        }
+        default: {
+            int n;
+            if (e.tag == LOG_TAG_CEE) {
+                n = snprintf(st.prefix, sizeof(st.prefix), "<span>%lu|CEE|", (unsigned long)e.timestamp);
+            } else {
+                n = snprintf(st.prefix, sizeof(st.prefix), "<span class='log-%s'>%lu|CEE|",
+                             logLevelName(e.level), (unsigned long)e.timestamp);
+            }
+            size_t len = formatLogEntry(e, st.line, sizeof(st.line));
+            setLogSegments(st.emit, {{st.prefix, (size_t)n, LOG_ESCAPE_NONE},
+                                {st.line, len, LOG_ESCAPE_HTML},
+                                {"\n</span>", 8, LOG_ESCAPE_NONE}});
+            break;
+        }
+    }
+}
+
+static void buildLogsPageHeader(LogStreamState& st) {
+    String& html = st.page;
+    html = F("<!DOCTYPE HTML><html><head>"
         "<meta charset='UTF-8'>"
         "<title>CEE - Logi</title>"
         "<style>");
@@ -1174,6 +1665,9 @@ void handleLogs(AsyncWebServerRequest *request) {
         ".log-INFO{color:#66bb6a}.log-WARN{color:#ffa726}"
         ".log-ERROR{color:#ef5350}.log-DEBUG{color:#617edb}"
         ".dim{color:#555}"
+        ".log-filter{font-size:13px;color:#888;margin-bottom:12px}"
+        ".log-filter input,.log-filter select{background:#1a1a1a;color:#ddd;border:1px solid #333;margin-right:8px}"
+        ".log-filter a{color:#888;margin-left:8px}"
         "</style>"
         "<script>"
         "function autoRefresh(){"
@@ -1186,70 +1680,340 @@ void handleLogs(AsyncWebServerRequest *request) {
     html += FPSTR(HTML_NAV_BAR);
     html += F("<div class='wrap'>"
         "<h1 style='margin:16px 0;'>CEE — RAM Logi</h1>"
-        "<p style='color:#666;font-size:13px;margin-bottom:12px'>"
-        "RAM buffer (zadnje log vrstice). "
-        "<label><input id='ar' type='checkbox' onchange='autoRefresh()'> "
-        "Auto-refresh 10s</label>"
-        "</p>"
-        "<div class='log-box'>");
-
-    if (logBuffer.isEmpty()) {
-        html += F("<span class='dim'>Log buffer je prazen.</span>");
-    } else {
-        // Parse log buffer line by line and apply color coding
-        int start = 0;
-        while (start < (int)logBuffer.length()) {
-            int end = logBuffer.indexOf('\n', start);
-            if (end < 0) end = logBuffer.length();
-            String line = logBuffer.substring(start, end);
-            start = end + 1;
-
-            // Determine CSS class based on log level
-            String cssClass = "";
-            if (line.indexOf(":INFO]") >= 0) cssClass = "log-INFO";
-            else if (line.indexOf(":WARN]") >= 0) cssClass = "log-WARN";
-            else if (line.indexOf(":ERROR]") >= 0) cssClass = "log-ERROR";
-            else if (line.indexOf(":DEBUG]") >= 0) cssClass = "log-DEBUG";
-
-            // Escape HTML entities
-            line.replace("&", "&");
-            line.replace("<", "<");
-            line.replace(">", ">");
-
-            if (cssClass.length() > 0)
-                html += "<span class='" + cssClass + "'>" + line + "\n</span>";
-            else
-                html += line + "\n";
-        }
+        "<form class='log-filter' method='GET' action='/logs'>Nivo: <select name='level'>");
+    const char* levels[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    for (int i = 0; i < 4; i++) {
+        html += "<option value='" + String(levels[i]) + "'" + (st.minLevel == i || (st.minLevel < 0 && i == 0) ? " selected" : "") +
+                ">" + levels[i] + "</option>";
     }
+    html += F("</select>Tag: <input name='tag' size='8' value='");
+    if (st.tag >= 0) html += logTagName(st.tag);
+    html += F("'>Vrstic: <input name='limit' size='4' value='");
+    html += String(st.limit);
+    html += F("'><input type='submit' value='Filtriraj'>"
+        "<label><input id='ar' type='checkbox' onchange='autoRefresh()'> Auto-refresh 10s</label>");
+    html += "<a href='/logs?format=text" + st.query + "'>text</a>";
+    html += "<a href='/logs?format=ndjson" + st.query + "'>ndjson</a>";
+    html += F("</form><div class='log-box'>");
+}
 
-    html += F("</div>"
-        "<p style='color:#555;font-size:12px;margin-top:10px'>"
-        "Buffer velikost: ");
-    html += String(logBuffer.length());
+static void buildLogsPageFooter(LogStreamState& st) {
+    String& html = st.page;
+    html = "";
+    if (st.emitted == 0) html += F("<span class='dim'>Ni zapisov za izbrane filtre.</span>");
+    html += F("</div><p style='color:#555;font-size:12px;margin-top:10px'>");
+    if (st.emitted > 0) {
+        html += "Zapisi " + String(st.firstEmittedSeq) + "–" + String(st.lastEmittedSeq) + " (" + String(st.emitted) + ") / ";
+    }
+    html += F("Neposlano (REW): ");
+    html += String(getLogPendingBytes(LOG_CONSUMER_REW));
     html += F(" B / Prag: ");
     html += String(LOG_THRESHOLD_IDLE);
     html += F(" B / Maksimum: ");
     html += String(LOG_BUFFER_MAX);
-    html += F(" B</p>"
-        "</div></body></html>");
+    html += F(" B / Ring: ");
+    LogRingStats stats;
+    logRingGetStats(stats);
+    html += String(stats.used) + " / " + String(stats.capacity);
+    html += F(" B</p><p style='font-size:13px'>");
+    uint32_t older;
+    if (logStreamFiltered(st)) older = findLogPageStart(st, st.startSeq);
+    else older = st.startSeq > stats.firstSeq + st.limit ? st.startSeq - st.limit : stats.firstSeq;
+    if (st.startSeq > stats.firstSeq) {
+        html += "<a style='color:#888' href='/logs?since=" + String(older) + st.query + "'>&larr; starejši</a> ";
+    }
+    if (st.cursor.seq < stats.nextSeq) {
+        html += "<a style='color:#888' href='/logs?since=" + String(st.cursor.seq) + st.query + "'>novejši &rarr;</a>";
+    }
+    html += F("</p></div></body></html>");
+}
 
-    request->send(200, "text/html; charset=utf-8", html);
+void handleLogs(AsyncWebServerRequest *request) {
+    // Ne logiramo GET /logs zahtevkov - polling zahteve brez operativne vrednosti
+    std::shared_ptr<LogStreamState> st = std::make_shared<LogStreamState>();
+    st->phase = LOG_PHASE_HEADER;
+    st->minLevel = -1;
+    st->tag = -1;
+    st->limit = LOG_WEB_MAX_LINES;
+    st->emitted = 0;
+    st->emit.count = st->emit.index = 0;
+    st->emit.pos = 0;
+    st->format = LOG_STREAM_HTML;
+
+    if (request->hasParam("format")) {
+        String f = request->getParam("format")->value();
+        if (f == "text") st->format = LOG_STREAM_TEXT;
+        else if (f == "ndjson") st->format = LOG_STREAM_NDJSON;
+    }
+    if (request->hasParam("level")) {
+        String l = request->getParam("level")->value();
+        l.toUpperCase();
+        for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_ERROR; i++) {
+            if (l == logLevelName(i) || l == String(i)) st->minLevel = i;
+        }
+        if (st->minLevel > LOG_LEVEL_DEBUG) st->query += "&level=" + String(logLevelName(st->minLevel));
+    }
+    if (request->hasParam("tag") && request->getParam("tag")->value().length() > 0) {
+        st->tag = logTagId(request->getParam("tag")->value().c_str());
+        String t = logTagName(st->tag);
+        t.replace(" ", "%20");
+        st->query += "&tag=" + t;
+    }
+    if (request->hasParam("limit")) {
+        long limit = request->getParam("limit")->value().toInt();
+        if (limit > 0) st->limit = limit > LOG_WEB_LIMIT_MAX ? LOG_WEB_LIMIT_MAX : limit;
+        st->query += "&limit=" + String(st->limit);
+    }
+
+    // Brez since: zadnjih `limit` zapisov v ringu, ki ustrezajo filtrom
+    LogRingStats stats;
+    logRingGetStats(stats);
+    uint32_t since;
+    if (request->hasParam("since")) {
+        since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    } else if (logStreamFiltered(*st)) {
+        since = findLogPageStart(*st, stats.nextSeq);
+    } else {
+        since = stats.nextSeq - stats.firstSeq > st->limit ? stats.nextSeq - st->limit : stats.firstSeq;
+    }
+    logRingSeek(st->cursor, since);
+    st->startSeq = st->cursor.seq;
+
+    if (st->format == LOG_STREAM_HTML) buildLogsPageHeader(*st);
+
+    const char* contentType = st->format == LOG_STREAM_HTML ? "text/html; charset=utf-8" :
+                              st->format == LOG_STREAM_NDJSON ? "application/x-ndjson" :
+                              "text/plain; charset=utf-8";
+    AsyncWebServerResponse *response = request->beginChunkedResponse(contentType,
+        [st](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t written = 0;
+            while (written < maxLen) {
+                if (st->emit.index < st->emit.count) {
+                    written += emitLogSegments(st->emit, buffer + written, maxLen - written);
+                    if (st->emit.index < st->emit.count) break;   // chunk poln
+                    continue;
+                }
+                switch (st->phase) {
+                    case LOG_PHASE_HEADER:
+                        if (st->format == LOG_STREAM_HTML) {
+                            setLogSegments(st->emit, {{st->page.c_str(), st->page.length(), LOG_ESCAPE_NONE}});
+                        }
+                        st->phase = LOG_PHASE_LINES;
+                        break;
+                    case LOG_PHASE_LINES:
+                        if (st->emitted >= st->limit || !nextLogStreamEntry(*st)) {
+                            st->phase = LOG_PHASE_FOOTER;
+                            break;
+                        }
+                        if (st->emitted == 0) st->firstEmittedSeq = st->entry.seq;
+                        st->lastEmittedSeq = st->entry.seq;
+                        st->emitted++;
+                        buildLogStreamLine(*st);
+                        break;
+                    case LOG_PHASE_FOOTER:
+                        if (st->format == LOG_STREAM_HTML) {
+                            buildLogsPageFooter(*st);
+                            setLogSegments(st->emit, {{st->page.c_str(), st->page.length(), LOG_ESCAPE_NONE}});
+                        }
+                        st->phase = LOG_PHASE_DONE;
+                        break;
+                    default:
+                        return written;
+                }
+            }
+            return written;
+        });
+    if (st->format != LOG_STREAM_HTML) {
+        response->addHeader("X-Log-First-Seq", String(stats.firstSeq));
+    }
+    request->send(response);
+}
+
+// Zgodovinski logi s SD po času: /api/logs/query?from=<ts>&to=<ts>&level=&tag=&limit=&format=text|ndjson
+// from/to sta v času zapisov (lokalni Unix čas, pred NTP sekunde od zagona); privzeto zadnja ura.
+// SD bere logquery task; callback le pobira pripravljene vrstice (RESPONSE_TRY_AGAIN, dokler jih ni).
+struct LogQueryState {
+    uint32_t queryId;
+    char line[LOG_LINE_MAX];
+    LogSegmentEmitter emit;
+    bool ndjson;
+    bool done;
+    int8_t minLevel;         // -1 = vsi nivoji
+    char tag[24];            // "" = vsi tagi
+    uint32_t limit;
+    uint32_t emitted;
+    char prefix[112];
+
+    ~LogQueryState() {
+        if (queryId) logSdQueryRelease(queryId);   // tudi ob prekinjeni povezavi
+    }
+};
+
+// Razčleni shranjeno vrstico "ts|CEE|[tag:LEVEL] besedilo" (CEE vrstice nimajo taga)
+static void parseStoredLogLine(const char* line, size_t length, const char*& tag, size_t& tagLen,
+                               int& level, const char*& msg, size_t& msgLen) {
+    const char* end = line + length;
+    const char* p = (const char*)memchr(line, '|', length);
+    p = p ? (const char*)memchr(p + 1, '|', end - p - 1) : nullptr;
+    msg = p ? p + 1 : end;
+    tag = "CEE";
+    tagLen = 3;
+    level = LOG_LEVEL_INFO;
+    if (msg < end && *msg == '[') {
+        const char* close = (const char*)memchr(msg, ']', end - msg);
+        const char* colon = close ? (const char*)memchr(msg, ':', close - msg) : nullptr;
+        if (colon) {
+            for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_ERROR; i++) {
+                const char* name = logLevelName(i);
+                if ((size_t)(close - colon - 1) == strlen(name) && strncmp(colon + 1, name, strlen(name)) == 0) {
+                    level = i;
+                    tag = msg + 1;
+                    tagLen = colon - msg - 1;
+                    msg = close + 1;
+                    if (msg < end && *msg == ' ') msg++;
+                    break;
+                }
+            }
+        }
+    }
+    msgLen = end - msg;
+}
+
+// Naslednja vrstica, ki ustreza filtru; LOG_SD_QUERY_WAIT = task še bere
+static LogSdQueryPoll nextLogQueryLine(LogQueryState& st) {
+    uint32_t ts;
+    size_t length;
+    while (st.emitted < st.limit) {
+        LogSdQueryPoll r = logSdQueryPoll(st.queryId, ts, st.line, sizeof(st.line), length);
+        if (r != LOG_SD_QUERY_LINE) return r;
+        const char* line = st.line;
+        const char* tag;
+        const char* msg;
+        size_t tagLen, msgLen;
+        int level;
+        parseStoredLogLine(line, length, tag, tagLen, level, msg, msgLen);
+        if (st.minLevel >= 0 && level < st.minLevel) continue;
+        if (st.tag[0] && (strlen(st.tag) != tagLen || strncasecmp(st.tag, tag, tagLen) != 0)) continue;
+
+        st.emitted++;
+        if (st.ndjson) {
+            int n = snprintf(st.prefix, sizeof(st.prefix), "{\"ts\":%lu,\"level\":\"%s\",\"tag\":\"%.*s\",\"msg\":\"",
+                             (unsigned long)ts, logLevelName(level), (int)tagLen, tag);
+            setLogSegments(st.emit, {{st.prefix, (size_t)n, LOG_ESCAPE_NONE},
+                                     {msg, msgLen, LOG_ESCAPE_JSON},
+                                     {"\"}\n", 3, LOG_ESCAPE_NONE}});
+        } else {
+            setLogSegments(st.emit, {{line, length, LOG_ESCAPE_NONE},
+                                     {"\n", 1, LOG_ESCAPE_NONE}});
+        }
+        return LOG_SD_QUERY_LINE;
+    }
+    return LOG_SD_QUERY_END;
+}
+
+void handleLogsQuery(AsyncWebServerRequest *request) {
+    std::shared_ptr<LogQueryState> st = std::make_shared<LogQueryState>();
+    st->queryId = 0;
+    st->ndjson = request->hasParam("format") && request->getParam("format")->value() == "ndjson";
+    st->done = false;
+    st->minLevel = -1;
+    st->tag[0] = '\0';
+    st->limit = LOG_SD_QUERY_LIMIT;
+    st->emitted = 0;
+    st->emit.count = st->emit.index = 0;
+    st->emit.pos = 0;
+
+    if (request->hasParam("level")) {
+        String l = request->getParam("level")->value();
+        l.toUpperCase();
+        for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_ERROR; i++) {
+            if (l == logLevelName(i) || l == String(i)) st->minLevel = i;
+        }
+    }
+    if (request->hasParam("tag")) {
+        strlcpy(st->tag, request->getParam("tag")->value().c_str(), sizeof(st->tag));
+    }
+    if (request->hasParam("limit")) {
+        long limit = request->getParam("limit")->value().toInt();
+        if (limit > 0 && limit < LOG_SD_QUERY_LIMIT) st->limit = limit;
+    }
+
+    uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) :
+                  timeSynced ? (uint32_t)myTZ.now() : millis() / 1000;
+    uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) :
+                    (to > LOG_SD_QUERY_WINDOW ? to - LOG_SD_QUERY_WINDOW : 0);
+    if (from > to) {
+        request->send(400, "application/json", "{\"status\":\"ERROR\",\"message\":\"from > to\"}");
+        return;
+    }
+
+    if (!isSDReady()) {
+        request->send(503, "application/json", "{\"status\":\"ERROR\",\"message\":\"SD ni na voljo\"}");
+        return;
+    }
+    st->queryId = logSdQueryStart(from, to);
+    if (!st->queryId) {
+        request->send(503, "application/json", "{\"status\":\"ERROR\",\"message\":\"Poizvedba po SD že teče\"}");
+        return;
+    }
+    LOG_DEBUG("Web", "Zahtevek: GET /api/logs/query %lu-%lu", (unsigned long)from, (unsigned long)to);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        st->ndjson ? "application/x-ndjson" : "text/plain; charset=utf-8",
+        [st](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t written = 0;
+            while (written < maxLen) {
+                if (st->emit.index < st->emit.count) {
+                    written += emitLogSegments(st->emit, buffer + written, maxLen - written);
+                    if (st->emit.index < st->emit.count) break;   // chunk poln
+                    continue;
+                }
+                if (st->done) break;
+                LogSdQueryPoll r = nextLogQueryLine(*st);
+                if (r == LOG_SD_QUERY_WAIT) {
+                    if (written == 0) return RESPONSE_TRY_AGAIN;
+                    break;
+                }
+                if (r != LOG_SD_QUERY_LINE) {
+                    st->done = true;
+                    if (r == LOG_SD_QUERY_ERROR) {
+                        const char* err = st->ndjson ? "{\"error\":\"SD read\"}\n" : "# napaka branja SD\n";
+                        setLogSegments(st->emit, {{err, strlen(err), LOG_ESCAPE_NONE}});
+                    }
+                }
+            }
+            return written;
+        });
+    request->send(response);
 }
 
 void setupWebServer() {
     LOG_INFO("Web", "Inicializacija web UI strežnika");
 
+    initMetrics(server);
     server.on("/", HTTP_GET, handleRoot);
     server.on("/settings", HTTP_GET, handleSettings);
     server.on("/logs", HTTP_GET, handleLogs);
+    server.on("/api/logs/raw", HTTP_GET, handleLogsRaw);
+    server.on("/api/logs/query", HTTP_GET, handleLogsQuery);
+    server.on("/api/log-levels", HTTP_GET, handleGetLogLevels);
+    server.on("/api/log-levels", HTTP_POST, handlePostLogLevels);
     server.on("/help", HTTP_GET, handleHelp);
     server.on("/data", HTTP_GET, handleDataRequest);
     server.on("/current-data", HTTP_GET, handleCurrentDataRequest);
+    initDashboardEvents(server);
+    initControlSocket(server);
     server.on("/settings/update", HTTP_POST, handlePostSettings);
     server.on("/settings/reset", HTTP_POST, handleResetSettings);
     server.on("/settings/factory-reset", HTTP_POST, handleFactoryResetSettings);
     server.on("/settings/status", HTTP_GET, handleSettingsStatus);
+    server.on("/api/i2c-stats", HTTP_GET, handleI2CStats);
+#ifdef I2C_FAULT_INJECTION
+    server.on("/api/i2c-fault", HTTP_GET, handleI2CFault);
+#endif
+#ifdef HTTP_BENCH
+    server.on("/api/http-bench", HTTP_GET, handleHttpBench);
+#endif
 
     server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
         LOG_DEBUG("Web", "Zahtevek: GET /status");
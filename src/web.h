@@ -2,6 +2,7 @@
 #define WEB_H
 
 #include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
 
 extern AsyncWebServer server;
 
@@ -12,4 +13,12 @@ void handleResetSettings(AsyncWebServerRequest *request);
 void handleSettingsStatus(AsyncWebServerRequest *request);
 void setupWebServer();
 
+// Skupno z dashpush.cpp
+String formatUptime(unsigned long seconds);
+int getRemainingTime(int index);
+
+// Sporočila REW - skupno za HTTP in /ws (wsctl.h)
+const char* applyManualControl(const JsonDocument& doc);   // nullptr = OK, sicer razlog
+void applySensorData(const JsonDocument& doc);
+
 #endif // WEB_H
\ No newline at end of file
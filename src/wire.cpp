@@ -0,0 +1,58 @@
+// wire.cpp - Wire format (JSON / MessagePack) for inter-unit messages
+
+#include "wire.h"
+#include "wirearena.h"
+
+WireFormat wireFormatOf(const char* contentType) {
+    if (contentType && strncasecmp(contentType, WIRE_CT_MSGPACK, sizeof(WIRE_CT_MSGPACK) - 1) == 0) {
+        return WIRE_MSGPACK;
+    }
+    return WIRE_JSON;
+}
+
+const char* wireContentType(WireFormat format) {
+    return format == WIRE_MSGPACK ? WIRE_CT_MSGPACK : WIRE_CT_JSON;
+}
+
+size_t wireEncode(const JsonDocument& doc, WireFormat format, uint8_t* out, size_t size) {
+    // JSON potrebuje še prostor za \0
+    size_t needed = format == WIRE_MSGPACK ? measureMsgPack(doc) : measureJson(doc) + 1;
+    if (needed > size) return 0;
+    if (format == WIRE_MSGPACK) return serializeMsgPack(doc, out, size);
+    return serializeJson(doc, (char*)out, size);
+}
+
+DeserializationError wireDecode(JsonDocument& doc, WireFormat format, const uint8_t* data, size_t length) {
+    if (format == WIRE_MSGPACK) return deserializeMsgPack(doc, data, length);
+    return deserializeJson(doc, (const char*)data, length);
+}
+
+size_t wireToText(WireFormat format, const uint8_t* data, size_t length, char* out, size_t size) {
+    if (size == 0) return 0;
+    if (format == WIRE_JSON) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(out, data, n);
+        out[n] = '\0';
+        return n;
+    }
+    static WireDocument<MSG_DOC_ARENA> doc;   // samo glavna zanka (log rezultatov v http.cpp)
+    if (deserializeMsgPack(doc, data, length)) {
+        return snprintf(out, size, "(msgpack %u B, neveljaven)", (unsigned)length);
+    }
+    size_t n = serializeJson(doc, out, size);
+    if (n >= size) n = size - 1;
+    out[n] = '\0';
+    return n;
+}
+
+bool wireCollect(WireBody& body, const uint8_t* data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        body.length = 0;
+        body.overflow = total > sizeof(body.data);
+    }
+    if (!body.overflow && index + len <= sizeof(body.data)) {
+        memcpy(body.data + index, data, len);
+        body.length = index + len;
+    }
+    return index + len == total;
+}
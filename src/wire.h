@@ -0,0 +1,44 @@
+// wire.h - Wire format (JSON / MessagePack) for inter-unit messages
+//
+// STATUS_UPDATE, DEW_UPDATE, SENSOR_DATA in MANUAL_CONTROL so lahko JSON ali
+// MessagePack z istimi kratkimi ključi (message_fields.h); format določa
+// Content-Type. Enota, ki sprejema MessagePack, to sporoči z glavo
+// "X-Vent-Caps: msgpack" v odgovoru. Kodiranje in dekodiranje gre v/iz
+// fiksnih bufferjev (MSG_BODY_MAX).
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+#define WIRE_CT_JSON    "application/json"
+#define WIRE_CT_MSGPACK "application/msgpack"
+
+enum WireFormat : uint8_t {
+    WIRE_JSON = 0,
+    WIRE_MSGPACK
+};
+
+// Telo zahtevka, zbrano iz AsyncWebServer body callbacka
+struct WireBody {
+    uint8_t data[MSG_BODY_MAX];
+    size_t length;
+    bool overflow;
+};
+
+WireFormat wireFormatOf(const char* contentType);
+const char* wireContentType(WireFormat format);
+
+// Vrne dolžino; 0, če sporočilo ne gre v buffer
+size_t wireEncode(const JsonDocument& doc, WireFormat format, uint8_t* out, size_t size);
+DeserializationError wireDecode(JsonDocument& doc, WireFormat format, const uint8_t* data, size_t length);
+
+// Berljiv izpis sporočila za log (MessagePack se pretvori v JSON)
+size_t wireToText(WireFormat format, const uint8_t* data, size_t length, char* out, size_t size);
+
+// true, ko je telo celo (index + len == total)
+bool wireCollect(WireBody& body, const uint8_t* data, size_t len, size_t index, size_t total);
+
+#endif // WIRE_H
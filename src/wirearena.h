@@ -0,0 +1,104 @@
+// wirearena.h - Fixed-capacity JsonDocument for inter-unit messages
+//
+// ArduinoJson 7 dodeljuje pomnilnik prek Allocatorja; WireArena ga jemlje iz
+// fiksnega bufferja namesto s heapa. Bloki se dodeljujejo zaporedno (glava z
+// velikostjo pred vsakim), sproščen zadnji blok se vrne, ko dokument sprosti
+// vse (clear(), nov deserialize), pa se arena izprazni. Premajhna arena ni
+// napaka pomnilnika: doc.overflowed() je true in wireEncode vrne 0.
+//
+// WireDocument<N> je JsonDocument z lastno areno N bajtov - namenjen statičnim
+// dokumentom, ki se ponovno uporabljajo za vsako sporočilo (samo en task).
+// Samo glave, da ga lahko uporabi tudi tools/msgpack_bench.cpp na računalniku.
+
+#ifndef WIREARENA_H
+#define WIREARENA_H
+
+#include <ArduinoJson.h>
+#include <stdint.h>
+#include <string.h>
+
+class WireArena : public ArduinoJson::Allocator {
+public:
+    WireArena(uint8_t* buffer, size_t size) : buffer_(buffer), size_(size) {}
+
+    void* allocate(size_t size) override {
+        size_t total = HEADER + align(size);
+        if (top_ + total > size_) {
+            failures_++;
+            return nullptr;
+        }
+        uint8_t* block = buffer_ + top_;
+        *(size_t*)block = size;
+        top_ += total;
+        live_++;
+        if (top_ > highWater_) highWater_ = top_;
+        return block + HEADER;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!ptr) return;
+        if (isLast(ptr)) top_ = (uint8_t*)ptr - HEADER - buffer_;
+        if (--live_ == 0) top_ = 0;
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (!ptr) return allocate(newSize);
+        size_t oldSize = blockSize(ptr);
+        if (isLast(ptr)) {
+            size_t start = (uint8_t*)ptr - buffer_;
+            if (start + align(newSize) > size_) {
+                failures_++;
+                return nullptr;
+            }
+            *(size_t*)((uint8_t*)ptr - HEADER) = newSize;
+            top_ = start + align(newSize);
+            if (top_ > highWater_) highWater_ = top_;
+            return ptr;
+        }
+        if (newSize <= oldSize) return ptr;     // krčenje sredi arene - prostor ostane
+        void* moved = allocate(newSize);
+        if (!moved) return nullptr;
+        memcpy(moved, ptr, oldSize);
+        deallocate(ptr);
+        return moved;
+    }
+
+    size_t used() const { return top_; }
+    size_t highWater() const { return highWater_; }
+    uint32_t failures() const { return failures_; }
+
+private:
+    static const size_t ALIGN = 8;
+    static const size_t HEADER = ALIGN;     // velikost bloka, poravnana
+
+    static size_t align(size_t n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+    size_t blockSize(void* ptr) const { return *(size_t*)((uint8_t*)ptr - HEADER); }
+    bool isLast(void* ptr) const { return (uint8_t*)ptr + align(blockSize(ptr)) == buffer_ + top_; }
+
+    uint8_t* buffer_;
+    size_t size_;
+    size_t top_ = 0;
+    size_t highWater_ = 0;
+    uint32_t live_ = 0;
+    uint32_t failures_ = 0;
+};
+
+// Arena mora obstajati pred JsonDocument (vrstni red baznih razredov)
+template <size_t N>
+struct WireArenaStorage {
+    alignas(8) uint8_t arenaBuffer[N];
+    WireArena arenaAllocator;
+    WireArenaStorage() : arenaAllocator(arenaBuffer, N) {}
+};
+
+template <size_t N>
+class WireDocument : private WireArenaStorage<N>, public JsonDocument {
+public:
+    WireDocument() : WireArenaStorage<N>(), JsonDocument(&this->arenaAllocator) {}
+    WireDocument(const WireDocument&) = delete;
+    WireDocument& operator=(const WireDocument&) = delete;
+
+    const WireArena& arena() const { return this->arenaAllocator; }
+};
+
+#endif // WIREARENA_H
@@ -0,0 +1,157 @@
+// wsctl.cpp - WebSocket control channel between REW and CEE
+
+#include "wsctl.h"
+#include "config.h"
+#include "logging.h"
+#include "message_fields.h"
+#include "wire.h"
+#include "wirearena.h"
+#include "liveness.h"
+#include "web.h"
+
+#define WS_ACK_MAX 96               // potrditev z najdaljšim razlogom
+
+static AsyncWebSocket ws("/ws");
+static volatile uint32_t rewClient = 0;     // id odjemalca z IP_REW; 0 = ni povezan
+static volatile WireFormat rewFormat = WIRE_JSON;
+static ControlSocketStats stats;
+
+// Samo async_tcp task (dogodki AsyncWebSocket)
+static WireBody frameBody;
+static uint32_t frameClient = 0;            // čigav okvir se zbira v frameBody
+static WireDocument<MSG_DOC_ARENA> frameDoc;
+static WireDocument<256> ackDoc;
+
+// Samo glavna zanka
+static uint8_t pushBuf[MSG_BODY_MAX];
+static uint32_t pushSeq = 0;
+static unsigned long lastCleanup = 0;
+
+static bool sendFrame(AsyncWebSocketClient* client, WireFormat format, const uint8_t* data, size_t length) {
+    if (format == WIRE_MSGPACK) return client->binary(data, length);
+    return client->text(data, length);
+}
+
+static void sendAck(AsyncWebSocketClient* client, WireFormat format, uint32_t id, const char* error) {
+    ackDoc.clear();
+    ackDoc[FIELD_MSG_TYPE] = WS_MSG_ACK;
+    ackDoc[FIELD_MSG_ID] = id;
+    ackDoc[FIELD_ACK_STATUS] = error ? "ERROR" : "OK";
+    if (error) {
+        ackDoc[FIELD_ACK_MESSAGE] = error;
+        stats.rejected++;
+    }
+    uint8_t buf[WS_ACK_MAX];
+    size_t length = wireEncode(ackDoc, format, buf, sizeof(buf));
+    if (length > 0) sendFrame(client, format, buf, length);
+}
+
+static void handleFrame(AsyncWebSocketClient* client, WireFormat format) {
+    stats.frames++;
+    if (frameBody.overflow) {
+        LOG_ERROR("Web", "/ws: okvir presega %d B", MSG_BODY_MAX);
+        sendAck(client, format, 0, "Body too large");
+        return;
+    }
+    DeserializationError error = wireDecode(frameDoc, format, frameBody.data, frameBody.length);
+    if (error) {
+        LOG_ERROR("Web", "/ws: %s parse error: %s", format == WIRE_MSGPACK ? "MessagePack" : "JSON", error.c_str());
+        sendAck(client, format, 0, "Invalid JSON");
+        return;
+    }
+
+    const char* type = frameDoc[FIELD_MSG_TYPE] | "";
+    uint32_t id = frameDoc[FIELD_MSG_ID] | 0;
+    if (strcmp(type, WS_MSG_ACK) == 0) return;      // REW potrjuje stanje - ni odgovora
+
+    const char* reason = nullptr;
+    if (strcmp(type, WS_MSG_MANUAL_CONTROL) == 0) {
+        reason = applyManualControl(frameDoc);
+    } else if (strcmp(type, WS_MSG_SENSOR_DATA) == 0) {
+        applySensorData(frameDoc);
+    } else {
+        LOG_WARN("Web", "/ws: neznan tip okvirja '%s'", type);
+        reason = "Unknown message type";
+    }
+
+    if (client->id() == rewClient) {
+        rewFormat = format;         // stanje gre REW v formatu, ki ga sam uporablja
+        livenessSeen(HTTP_PEER_REW);     // async_tcp - livenessService() v glavni zanki
+    }
+    sendAck(client, format, id, reason);
+}
+
+static void onFrame(AsyncWebSocketClient* client, const AwsFrameInfo* info, const uint8_t* data, size_t len) {
+    WireFormat format = info->message_opcode == WS_BINARY ? WIRE_MSGPACK : WIRE_JSON;
+    // Sporočilo v več WS okvirjih REW ne pošilja; en okvir je lahko v več TCP segmentih
+    if (info->num > 0 || !info->final) {
+        if (info->num == 0 && info->index == 0) sendAck(client, format, 0, "Fragmented message");
+        return;
+    }
+    if (info->index == 0) frameClient = client->id();
+    else if (frameClient != client->id()) return;   // prepleteno z drugim odjemalcem
+    if (wireCollect(frameBody, data, len, info->index, info->len)) handleFrame(client, format);
+}
+
+static void onSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                          void* arg, uint8_t* data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            client->keepAlivePeriod(WS_KEEPALIVE_S);
+            if (client->remoteIP().toString() == IP_REW) {
+                rewClient = client->id();
+                LOG_INFO("Web", "/ws: REW povezan (#%u)", client->id());
+            } else {
+                LOG_DEBUG("Web", "/ws: odjemalec %s (#%u)", client->remoteIP().toString().c_str(), client->id());
+            }
+            break;
+        case WS_EVT_DISCONNECT:
+            if (client->id() == rewClient) {
+                rewClient = 0;
+                LOG_INFO("Web", "/ws: REW prekinil povezavo - stanje spet po HTTP");
+            }
+            break;
+        case WS_EVT_DATA:
+            onFrame(client, (const AwsFrameInfo*)arg, data, len);
+            break;
+        default:
+            break;
+    }
+}
+
+void initControlSocket(AsyncWebServer& server) {
+    ws.onEvent(onSocketEvent);
+    server.addHandler(&ws);
+}
+
+bool controlSocketActive() {
+    return rewClient != 0;
+}
+
+bool publishStateControlSocket(JsonDocument& doc) {
+    uint32_t id = rewClient;
+    if (id == 0) return false;
+    if (++pushSeq == 0) pushSeq = 1;
+    doc[FIELD_MSG_TYPE] = WS_MSG_STATE;
+    doc[FIELD_SEQUENCE] = pushSeq;
+    WireFormat format = rewFormat;
+    size_t length = doc.overflowed() ? 0 : wireEncode(doc, format, pushBuf, sizeof(pushBuf));
+    bool sent = length > 0 &&
+                (format == WIRE_MSGPACK ? ws.binary(id, pushBuf, length) : ws.text(id, pushBuf, length));
+    if (sent) stats.pushes++;
+    else stats.pushFailures++;
+    return sent;
+}
+
+void controlSocketService() {
+    unsigned long now = millis();
+    if (now - lastCleanup < 1000) return;
+    lastCleanup = now;
+    ws.cleanupClients(WS_MAX_CLIENTS);
+}
+
+void getControlSocketStats(ControlSocketStats& out) {
+    out = stats;
+    out.rewConnected = rewClient != 0;
+    out.clients = ws.count();
+}
@@ -0,0 +1,47 @@
+// wsctl.h - WebSocket control channel between REW and CEE
+//
+// /ws je trajna povezava, po kateri REW pošilja MANUAL_CONTROL in SENSOR_DATA
+// brez nove TCP povezave na sporočilo, CEE pa po isti povezavi potiska stanje.
+// Besedilni okvir je JSON, binarni MessagePack; vsak okvir je objekt s
+// FIELD_MSG_TYPE in FIELD_MSG_ID (message_fields.h), ostala polja so ista kot v
+// HTTP telesu. Vsak zahtevek dobi potrditev (WS_MSG_ACK, isti id, isti format)
+// z "status" in "message" kot HTTP odgovor.
+//
+// Stanje (WS_MSG_STATE) gre REW ob vsaki spremembi in ob heartbeatu, v formatu
+// zadnjega okvirja od REW. Kot multicast je brez potrditve - periodični HTTP
+// STATUS_UPDATE ostane zanesljiva pot, sprememba pa gre po HTTP le, ko REW
+// ni povezan na /ws.
+//
+// Okvirji se obdelajo v async_tcp tasku (kot HTTP handlerji); stanje pošilja
+// glavna zanka.
+
+#ifndef WSCTL_H
+#define WSCTL_H
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+struct ControlSocketStats {
+    bool rewConnected;
+    uint32_t clients;
+    uint32_t frames;          // prejeti zahtevki
+    uint32_t rejected;        // potrjeni z "ERROR"
+    uint32_t pushes;          // stanje poslano REW
+    uint32_t pushFailures;    // polna vrsta ali stanje ne gre v buffer
+};
+
+// Registrira /ws na strežniku (iz setupWebServer)
+void initControlSocket(AsyncWebServer& server);
+
+// REW je povezan na /ws - spremembe stanja dobi po njem
+bool controlSocketActive();
+
+// Pošlje polno stanje REW; doc dobi tip in zaporedno številko (samo glavna zanka)
+bool publishStateControlSocket(JsonDocument& doc);
+
+// Iz glavne zanke: zapiranje odvečnih in prekinjenih odjemalcev
+void controlSocketService();
+
+void getControlSocketStats(ControlSocketStats& stats);
+
+#endif // WSCTL_H
@@ -0,0 +1,44 @@
+// Adafruit_BME280.h - nadomestek za host teste v tools/ (ni za firmware)
+// Vrednosti nastavi test; branje porabi čas na simuliranem vodilu (Wire.h)
+// kot knjižnica: vlaga in tlak najprej znova prebereta temperaturo.
+
+#ifndef HOST_ADAFRUIT_BME280_H
+#define HOST_ADAFRUIT_BME280_H
+
+#include "Wire.h"
+
+class Adafruit_BME280 {
+public:
+    bool begin(uint8_t addr) {
+        address = addr;
+        return Wire.transfer(address, 2) == 0;
+    }
+    float readTemperature() {
+        readRegister(3);
+        return temperature;
+    }
+    float readHumidity() {
+        readTemperature();
+        readRegister(2);
+        return humidity;
+    }
+    float readPressure() {
+        readTemperature();
+        readRegister(3);
+        return pressure;
+    }
+
+    float temperature = 22.0f;
+    float humidity = 60.0f;
+    float pressure = 98000.0f;   // Pa
+
+private:
+    void readRegister(uint8_t bytes) {
+        Wire.transfer(address, 1);
+        Wire.transfer(address, bytes);
+    }
+
+    uint8_t address = 0x76;
+};
+
+#endif // HOST_ADAFRUIT_BME280_H
@@ -0,0 +1,38 @@
+// Adafruit_SHT4x.h - nadomestek za host teste v tools/ (ni za firmware)
+// Vrednosti nastavi test; branje porabi čas na simuliranem vodilu (Wire.h).
+
+#ifndef HOST_ADAFRUIT_SHT4X_H
+#define HOST_ADAFRUIT_SHT4X_H
+
+#include "Wire.h"
+
+#define SHT4X_DEFAULT_ADDR 0x44
+
+enum sht4x_precision_t { SHT4X_HIGH_PRECISION, SHT4X_MED_PRECISION, SHT4X_LOW_PRECISION };
+enum sht4x_heater_t { SHT4X_NO_HEATER };
+
+struct sensors_event_t {
+    float temperature;
+    float relative_humidity;
+};
+
+class Adafruit_SHT4x {
+public:
+    bool begin() { return Wire.transfer(SHT4X_DEFAULT_ADDR, 1) == 0; }
+    void setPrecision(sht4x_precision_t) {}
+    void setHeater(sht4x_heater_t) {}
+    // Ukaz za meritev, 10 ms (visoka natančnost), 6 bajtov rezultata
+    bool getEvent(sensors_event_t* humidity, sensors_event_t* temp) {
+        Wire.transfer(SHT4X_DEFAULT_ADDR, 1);
+        delay(10);
+        Wire.transfer(SHT4X_DEFAULT_ADDR, 6);
+        temp->temperature = temperature;
+        humidity->relative_humidity = relativeHumidity;
+        return true;
+    }
+
+    float temperature = 21.5f;
+    float relativeHumidity = 55.0f;
+};
+
+#endif // HOST_ADAFRUIT_SHT4X_H
@@ -0,0 +1,86 @@
+// Arduino.h - minimalne nadomestne glave za host teste v tools/ (ni za firmware)
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+// Samo za deklaracije v config.h (ExternalData::weatherIcon)
+class String {
+public:
+    String(const char* s = "") : text(s) {}
+    const char* c_str() const { return text; }
+private:
+    const char* text;
+};
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+// Simulirana ura - delay() in I2C prenosi (Wire.h) jo premikajo, test jo bere
+inline uint64_t& hostMicros() { static uint64_t us = 0; return us; }
+inline unsigned long millis() { return (unsigned long)(hostMicros() / 1000); }
+inline unsigned long micros() { return (unsigned long)hostMicros(); }
+inline void delay(unsigned long ms) { hostMicros() += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros() += us; }
+
+// Simuliran GPIO: linije s pull-upom so HIGH, razen če jih drži izhod LOW ali
+// zunanja naprava (hostGpio().heldLow, npr. zataknjen SDA). Naprava, ki drži
+// linijo, jo spusti po releaseAfterClocks urinih impulzih (LOW) na clockPin.
+#define HOST_GPIO_PINS 64
+
+struct HostGpio {
+    uint8_t mode[HOST_GPIO_PINS];
+    uint8_t level[HOST_GPIO_PINS];
+    bool heldLow[HOST_GPIO_PINS];
+    uint8_t clockPin;               // linija, katere impulzi štejejo za sprostitev
+    uint16_t releaseAfterClocks;    // 0 = drži, dokler je test ne spusti
+    uint32_t clocks;                // impulzi na clockPin od zadnjega hostGpioHold()
+};
+
+inline HostGpio& hostGpio() { static HostGpio gpio = {}; return gpio; }
+
+inline void hostGpioHold(uint8_t pin, uint8_t clockPin, uint16_t releaseAfterClocks) {
+    HostGpio& g = hostGpio();
+    g.heldLow[pin] = true;
+    g.clockPin = clockPin;
+    g.releaseAfterClocks = releaseAfterClocks;
+    g.clocks = 0;
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HOST_GPIO_PINS) hostGpio().mode[pin] = mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin >= HOST_GPIO_PINS) return;
+    HostGpio& g = hostGpio();
+    if (pin == g.clockPin && value == LOW) {
+        g.clocks++;
+        if (g.releaseAfterClocks != 0 && g.clocks >= g.releaseAfterClocks) {
+            for (int i = 0; i < HOST_GPIO_PINS; i++) g.heldLow[i] = false;
+        }
+    }
+    g.level[pin] = value;
+}
+
+inline int digitalRead(uint8_t pin) {
+    if (pin >= HOST_GPIO_PINS) return LOW;
+    HostGpio& g = hostGpio();
+    if (g.heldLow[pin]) return LOW;
+    if (g.mode[pin] == OUTPUT) return g.level[pin];
+    return HIGH;
+}
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,102 @@
+// Wire.h - nadomestek TwoWire za host teste v tools/ (ni za firmware)
+//
+// Vsaka transakcija premakne simulirano uro (Arduino.h) za čas prenosa pri
+// nastavljeni frekvenci: START + naslov + ACK + 9 bitov na podatkovni bajt + STOP.
+// Urnik napak vrne NACK (2) ali timeout (5, po setTimeout() ms) izbranim
+// sondam endTransmission() ali pa naprava obtiči in drži SDA LOW; zataknjen SDA
+// povzroči timeout vsake transakcije, dokler ga naprava ne spusti (po
+// stuckReleaseClocks urinih impulzih na SCL, 0 = nikoli).
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+enum HostI2CFault {
+    HOST_I2C_OK = 0,
+    HOST_I2C_NACK,
+    HOST_I2C_TIMEOUT,
+    HOST_I2C_SDA_STUCK     // naprava obtiči sredi bajta in drži SDA (timeout)
+};
+
+class TwoWire {
+public:
+    bool begin(int sda, int scl) {
+        sdaPin = sda;
+        sclPin = scl;
+        begins++;
+        return true;
+    }
+    void end() { ends++; }
+    void setClock(uint32_t hz) { clockHz = hz; }
+    void setTimeout(uint16_t ms) { timeoutMs = ms; }
+
+    void beginTransmission(uint8_t address) { txAddress = address; }
+    uint8_t endTransmission(bool stop = true) {
+        (void)stop;
+        probes++;
+        return transact(txAddress, 0, takeFault(txAddress));
+    }
+
+    // Prenos registrov iz nadomestkov senzorjev - samo čas, brez napak iz urnika
+    // (readSHT41/readBME280 napak pri branju ne preverjata)
+    uint8_t transfer(uint8_t address, uint8_t bytes) {
+        return transact(address, bytes, HOST_I2C_OK);
+    }
+
+    // Napaka za sonde na address (0 = vse): preskoči skip sond, nato count napak
+    void schedule(HostI2CFault fault, uint8_t address, uint16_t skip, uint16_t count) {
+        faultMode = fault;
+        faultAddress = address;
+        faultSkip = skip;
+        faultCount = count;
+    }
+
+    uint16_t stuckReleaseClocks = 0;
+    uint32_t probes = 0;
+    uint32_t transactions = 0;
+    uint32_t begins = 0;
+    uint32_t ends = 0;
+
+private:
+    HostI2CFault takeFault(uint8_t address) {
+        if (faultCount == 0) return HOST_I2C_OK;
+        if (faultAddress != 0 && faultAddress != address) return HOST_I2C_OK;
+        if (faultSkip > 0) {
+            faultSkip--;
+            return HOST_I2C_OK;
+        }
+        faultCount--;
+        return faultMode;
+    }
+
+    uint8_t transact(uint8_t address, uint8_t bytes, HostI2CFault fault) {
+        (void)address;
+        transactions++;
+        if (fault == HOST_I2C_SDA_STUCK && sdaPin >= 0) {
+            hostGpioHold(sdaPin, sclPin, stuckReleaseClocks);
+        }
+        if (fault == HOST_I2C_TIMEOUT || (sdaPin >= 0 && digitalRead(sdaPin) == LOW)) {
+            delay(timeoutMs);
+            return 5;
+        }
+        uint32_t bits = (fault == HOST_I2C_NACK) ? 11 : 11 + 9 * bytes;
+        hostMicros() += (uint64_t)bits * 1000000ULL / clockHz;
+        return fault == HOST_I2C_NACK ? 2 : 0;
+    }
+
+    int sdaPin = -1;
+    int sclPin = -1;
+    uint32_t clockHz = 100000;
+    uint16_t timeoutMs = 50;
+    uint8_t txAddress = 0;
+    HostI2CFault faultMode = HOST_I2C_OK;
+    uint8_t faultAddress = 0;
+    uint16_t faultSkip = 0;
+    uint16_t faultCount = 0;
+};
+
+inline TwoWire& hostWire() { static TwoWire wire; return wire; }
+#define Wire hostWire()
+
+#endif // HOST_WIRE_H
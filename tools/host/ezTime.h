@@ -0,0 +1,13 @@
+// ezTime.h - nadomestek za host teste v tools/ (ni za firmware)
+
+#ifndef HOST_EZTIME_H
+#define HOST_EZTIME_H
+
+#include "Arduino.h"
+
+class Timezone {
+public:
+    time_t now() { return (time_t)(millis() / 1000); }
+};
+
+#endif // HOST_EZTIME_H
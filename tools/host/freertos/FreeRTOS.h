@@ -0,0 +1,11 @@
+// FreeRTOS.h - enonitni nadomestek za host teste v tools/ (kritične sekcije so prazne)
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,13 @@
+// semphr.h - enonitni nadomestek za host teste v tools/ (mutex vedno uspe)
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+typedef void* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    static int mutex;
+    return &mutex;
+}
+
+#endif // HOST_SEMPHR_H
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""http_standin.py - nadomestek REW/DEW HTTP API za meritve na računalniku.
+
+Odgovarja na /api/ping ("pong"), /api/status-update in /api/dew-update z
+HTTP/1.1 keep-alive (ali z --close vsakič zapre povezavo, kot stari odjemalec).
+Vsako sekundo izpiše sporočila/s ter število novih in ponovno uporabljenih
+TCP povezav.
+
+Z --delta odgovori na X-Vent-Caps z "delta" in sprejema delta STATUS_UPDATE kot
+REW: delta z bs, ki ni zadnji uporabljen sq, je vrzel - zahteva keyframe
+(X-Vent-Keyframe: 1). Z --msgpack ponudi še MessagePack (potreben paket msgpack).
+
+Uporaba:
+    python tools/http_standin.py --port 80
+    python tools/http_standin.py --port 80 --delay-ms 5   # simulira obdelavo
+    python tools/http_standin.py --port 80 --delta        # delta STATUS_UPDATE
+    python tools/http_standin.py --port 80 --msgpack      # application/msgpack
+
+Meritev na CEE (build z -DHTTP_BENCH):
+    curl 'http://192.168.2.192/api/http-bench?host=<IP računalnika>&n=200'
+    curl 'http://192.168.2.192/api/http-bench'            # rezultat
+"""
+
+import argparse
+import json
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+state = {"requests": 0, "connections": 0, "reused": 0, "lock": threading.Lock()}
+status = {"seq": None, "fields": {}, "keyframes": 0, "deltas": 0, "gaps": 0}
+
+
+class StandinHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    disable_nagle_algorithm = True
+    wbufsize = 65536   # glava in telo v enem TCP segmentu (flush po vsakem zahtevku)
+
+    def setup(self):
+        super().setup()
+        self.served = 0
+        with state["lock"]:
+            state["connections"] += 1
+
+    def count(self):
+        with state["lock"]:
+            state["requests"] += 1
+            if self.served > 0:
+                state["reused"] += 1
+        self.served += 1
+        if self.server.delay_ms:
+            time.sleep(self.server.delay_ms / 1000.0)
+
+    def do_GET(self):
+        if self.path != "/api/ping":
+            self.send_error(404)
+            return
+        self.count()
+        self.reply(200, b"pong", "text/plain")
+
+    def do_POST(self):
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        if self.path not in ("/api/status-update", "/api/dew-update"):
+            self.send_error(404)
+            return
+        self.count()
+        try:
+            if self.headers.get("Content-Type", "").startswith("application/msgpack"):
+                import msgpack
+                msg = msgpack.unpackb(body)
+            else:
+                msg = json.loads(body)
+        except ValueError as e:
+            self.reply(400, json.dumps({"status": "ERROR", "message": str(e)}).encode())
+            return
+        offered = self.headers.get("X-Vent-Caps", "")
+        caps = [c for c, on in (("delta", self.server.delta), ("msgpack", self.server.msgpack)) if on and c in offered]
+        headers = {"X-Vent-Caps": ",".join(caps)} if caps else {}
+        if self.path == "/api/status-update" and "delta" in caps:
+            if not self.apply_status(msg):
+                headers["X-Vent-Keyframe"] = "1"
+        self.reply(200, b'{"status":"OK"}', headers=headers)
+
+    def apply_status(self, msg):
+        """Uporabi (delta) STATUS_UPDATE; False ob vrzeli."""
+        with state["lock"]:
+            seq = msg.pop("sq", None)
+            if seq is None or msg.pop("kf", 0):
+                status["fields"] = msg
+                status["keyframes"] += 1
+            elif msg.pop("bs", None) == status["seq"]:
+                status["fields"].update(msg)
+                status["deltas"] += 1
+            else:
+                status["gaps"] += 1
+                status["seq"] = None
+                return False
+            status["seq"] = seq
+            return True
+
+    def reply(self, code, body, content_type="application/json", headers=None):
+        self.send_response(code)
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close" if self.server.close else "keep-alive")
+        self.end_headers()
+        self.wfile.write(body)
+        if self.server.close:
+            self.close_connection = True
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def report():
+    last = dict(state)
+    while True:
+        time.sleep(1)
+        with state["lock"]:
+            now = {k: state[k] for k in ("requests", "connections", "reused")}
+        if now["requests"] != last["requests"]:
+            print("%4d msg/s  nove povezave: %3d  ponovno uporabljene: %4d  (skupaj %d)"
+                  % (now["requests"] - last["requests"], now["connections"] - last["connections"],
+                     now["reused"] - last["reused"], now["requests"]))
+            if status["keyframes"]:
+                print("      STATUS sq=%s keyframe: %d  delta: %d  vrzeli: %d"
+                      % (status["seq"], status["keyframes"], status["deltas"], status["gaps"]))
+        last = now
+
+
+def main():
+    ap = argparse.ArgumentParser(description="REW/DEW HTTP nadomestek za meritve keep-alive")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--close", action="store_true", help="po vsakem odgovoru zapri povezavo")
+    ap.add_argument("--delay-ms", type=float, default=0, help="zakasnitev obdelave zahtevka")
+    ap.add_argument("--delta", action="store_true", help="podpri delta STATUS_UPDATE (X-Vent-Caps)")
+    ap.add_argument("--msgpack", action="store_true", help="sprejmi application/msgpack (X-Vent-Caps)")
+    args = ap.parse_args()
+
+    server = ThreadingHTTPServer((args.host, args.port), StandinHandler)
+    server.close = args.close
+    server.delay_ms = args.delay_ms
+    server.delta = args.delta
+    server.msgpack = args.msgpack
+    threading.Thread(target=report, daemon=True).start()
+    print("Poslušam na %s:%d (%s)" % (args.host, args.port, "close" if args.close else "keep-alive"))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
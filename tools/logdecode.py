@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""logdecode.py - dekodira surovi izpis log ringa CEE (/api/logs/raw).
+
+Odloženi zapisi (LOG_DEFERRED_FORMAT) vsebujejo samo naslov format niza in
+surove argumente; format nize in imena tagov prebere iz firmware ELF datoteke
+(.pio/build/<env>/firmware.elf iste gradnje, ki teče na napravi).
+
+Uporaba:
+    python tools/logdecode.py firmware.elf cee_log.bin
+    python tools/logdecode.py firmware.elf --url http://192.168.2.192/api/logs/raw
+
+Potrebuje: pip install pyelftools
+"""
+
+import argparse
+import re
+import struct
+import sys
+import urllib.request
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+LEVEL_NAMES = {0: "DEBUG", 1: "INFO", 2: "WARN", 3: "ERROR"}
+DEFERRED_FLAG = 0x80
+TAG_CEE = 0
+TAG_OTHER = 1
+
+# Enaka slovnica kot nextFormatSpec() v src/logfmt.cpp
+SPEC_RE = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<prec>\*|\d*))?"
+                     r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conv>[diuxXocfFeEgGaAsp%])")
+
+
+class FirmwareImage:
+    def __init__(self, path):
+        self.f = open(path, "rb")
+        self.elf = ELFFile(self.f)
+        self.segments = []
+        for section in self.elf.iter_sections():
+            if section["sh_flags"] & 0x2 and section["sh_type"] == "SHT_PROGBITS":
+                self.segments.append((section["sh_addr"], section["sh_size"], section))
+        self.cache = {}
+
+    def read(self, addr, size):
+        for start, length, section in self.segments:
+            if start <= addr < start + length:
+                if section.name not in self.cache:
+                    self.cache[section.name] = section.data()
+                off = addr - start
+                return self.cache[section.name][off:off + size]
+        return None
+
+    def cstring(self, addr, limit=512):
+        data = self.read(addr, limit)
+        if data is None:
+            return None
+        end = data.find(b"\0")
+        return data[:end if end >= 0 else len(data)].decode("utf-8", "replace")
+
+    def tag_names(self):
+        symtab = self.elf.get_section_by_name(".symtab")
+        if not isinstance(symtab, SymbolTableSection):
+            return {}
+        for sym in symtab.iter_symbols():
+            if sym.name in ("logTagNames", "_ZL11logTagNames"):
+                data = self.read(sym["st_value"], sym["st_size"])
+                if not data:
+                    return {}
+                ptrs = struct.unpack("<%dI" % (len(data) // 4), data)
+                return {i: self.cstring(p) or "?" for i, p in enumerate(ptrs)}
+        return {}
+
+
+def render_deferred(fw, payload):
+    if len(payload) < 4:
+        return "<?>"
+    (fmt_addr,) = struct.unpack_from("<I", payload, 0)
+    fmt = fw.cstring(fmt_addr)
+    if fmt is None:
+        return "<format @0x%08x ni v ELF>" % fmt_addr
+    pos = 4
+    out = []
+    last = 0
+
+    def take(fmt_code, size):
+        nonlocal pos
+        if pos + size > len(payload):
+            raise ValueError
+        (v,) = struct.unpack_from(fmt_code, payload, pos)
+        pos += size
+        return v
+
+    try:
+        for m in SPEC_RE.finditer(fmt):
+            out.append(fmt[last:m.start()])
+            last = m.end()
+            conv = m.group("conv")
+            if conv == "%":
+                out.append("%")
+                continue
+            width, prec = m.group("width"), m.group("prec")
+            if width == "*":
+                width = str(take("<i", 4))
+            if prec == "*":
+                prec = str(take("<i", 4))
+            spec = "%" + m.group("flags") + (width or "") + ("." + prec if prec is not None else "")
+            longlong = m.group("length") in ("ll", "j")
+            if conv in "di":
+                out.append((spec + "d") % take("<q" if longlong else "<i", 8 if longlong else 4))
+            elif conv in "uxXo":
+                v = take("<Q" if longlong else "<I", 8 if longlong else 4)
+                out.append((spec + ("d" if conv == "u" else conv)) % v)
+            elif conv == "c":
+                out.append((spec + "c") % chr(take("<i", 4) & 0xFF))
+            elif conv == "p":
+                out.append((spec + "s") % ("0x%x" % take("<I", 4)))
+            elif conv in "fFeEgGaA":
+                out.append((spec + ("f" if conv in "aA" else conv)) % take("<d", 8))
+            elif conv == "s":
+                end = payload.find(b"\0", pos)
+                if end < 0:
+                    raise ValueError
+                s = payload[pos:end].decode("utf-8", "replace")
+                pos = end + 1
+                out.append((spec + "s") % s)
+        out.append(fmt[last:])
+    except ValueError:
+        out.append("<?>")
+    return "".join(out)
+
+
+def decode(fw, data):
+    if data[:4] != b"CLG1":
+        sys.exit("napačen izpis (manjka glava CLG1)")
+    tags = fw.tag_names()
+    pos = 4
+    while pos + 12 <= len(data):
+        seq, ts, level, tag, length = struct.unpack_from("<IIBBH", data, pos)
+        payload = data[pos + 12:pos + 12 + length]
+        pos += 12 + length
+        if level & DEFERRED_FLAG:
+            text = render_deferred(fw, payload)
+        else:
+            text = payload.decode("utf-8", "replace")
+        level &= ~DEFERRED_FLAG
+        if tag in (TAG_CEE, TAG_OTHER):
+            line = text
+        else:
+            line = "[%s:%s] %s" % (tags.get(tag, "tag%d" % tag), LEVEL_NAMES.get(level, "?"), text)
+        yield seq, "%d|CEE|%s" % (ts, line)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Dekodira CEE log ring izpis")
+    ap.add_argument("elf", help="firmware.elf iste gradnje")
+    ap.add_argument("dump", nargs="?", help="datoteka z /api/logs/raw izpisom")
+    ap.add_argument("--url", help="prenesi izpis neposredno z naprave")
+    ap.add_argument("--seq", action="store_true", help="izpiši tudi zaporedno številko")
+    args = ap.parse_args()
+
+    if args.url:
+        with urllib.request.urlopen(args.url, timeout=30) as r:
+            data = r.read()
+    elif args.dump:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    else:
+        ap.error("podaj dump datoteko ali --url")
+
+    fw = FirmwareImage(args.elf)
+    for seq, line in decode(fw, data):
+        print("%d %s" % (seq, line) if args.seq else line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,147 @@
+// logring_test.cpp - preverjanje src/logring.cpp na hostu
+//
+// Majhen ring se večkrat obrne, medtem ko porabniki berejo z različnim
+// zaostankom: eden sproti, drugi v naključnih paketih, tretji za dalj časa
+// obmiruje (tudi s kazalcem na koncu bufferja tik pred obratom). Vsak prebran
+// zapis mora imeti pričakovan seq, dolžino in vsebino; preskočeni zapisi se
+// morajo pokazati v cursor.dropped. Izhodna koda je 1 ob napaki.
+//
+// Prevod (iz korena repozitorija), priporočeno z ASan:
+//     g++ -std=c++11 -g -Wall -fsanitize=address,undefined -Itools/host -Isrc tools/logring_test.cpp src/logring.cpp -o logring_test && ./logring_test
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "logring.h"
+
+#define RING_CAPACITY 4096
+#define APPENDS 200000
+
+static unsigned long failures = 0;
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Dolžina in vsebina zapisa sta odvisni samo od seq
+static size_t payloadLength(uint32_t seq) {
+    uint32_t h = seq * 2654435761u;
+    return 1 + (h >> 8) % 240;
+}
+
+static size_t buildPayload(uint32_t seq, char* out) {
+    size_t length = payloadLength(seq);
+    for (size_t i = 0; i < length; i++) out[i] = (char)('a' + (seq + i) % 26);
+    return length;
+}
+
+struct Consumer {
+    const char* name;
+    LogCursor cursor;
+    uint32_t expectSeq;      // naslednji pričakovan seq
+    uint32_t dropped;        // cursor.dropped ob zadnjem branju
+    unsigned long reads;
+};
+
+static void fail(const Consumer& c, const char* what, const LogEntry& e) {
+    if (failures++ < 10) {
+        printf("NAPAKA %s: %s (seq=%u pričakovan=%u dolžina=%u dropped=%u)\n",
+               c.name, what, e.seq, c.expectSeq, e.length, c.cursor.dropped);
+    }
+}
+
+static void readRecords(Consumer& c, uint32_t maxRecords) {
+    static LogEntry entry;
+    char expected[LOG_RING_MSG_MAX];
+    for (uint32_t n = 0; n < maxRecords; n++) {
+        if (!logRingRead(c.cursor, entry)) return;
+        c.reads++;
+        uint32_t skipped = c.cursor.dropped - c.dropped;
+        c.dropped = c.cursor.dropped;
+        c.expectSeq += skipped;
+        if (entry.seq != c.expectSeq) fail(c, "seq se ne ujema", entry);
+        size_t length = buildPayload(entry.seq, expected);
+        if (entry.length != length) fail(c, "dolžina se ne ujema", entry);
+        else if (memcmp(entry.text, expected, length) != 0 || entry.text[length] != '\0') fail(c, "vsebina", entry);
+        c.expectSeq = entry.seq + 1;
+    }
+}
+
+static void checkPending(const Consumer& c) {
+    size_t bytes = logRingPendingBytes(c.cursor);
+    if (bytes > RING_CAPACITY) {
+        if (failures++ < 10) printf("NAPAKA %s: pendingBytes=%u > kapaciteta\n", c.name, (unsigned)bytes);
+    }
+}
+
+int main() {
+    if (!logRingInit(RING_CAPACITY, RING_CAPACITY)) {
+        printf("logRingInit ni uspel\n");
+        return 1;
+    }
+
+    Consumer live = {"sproti", {}, 0, 0, 0};
+    Consumer batch = {"paketi", {}, 0, 0, 0};
+    Consumer idle = {"mirovanje", {}, 0, 0, 0};
+    logRingCursorAtOldest(live.cursor);
+    logRingCursorAtOldest(batch.cursor);
+    logRingCursorAtOldest(idle.cursor);
+
+    char payload[LOG_RING_MSG_MAX];
+    uint32_t idleUntil = 0;
+    unsigned long seeks = 0;
+    for (uint32_t seq = 0; seq < APPENDS; seq++) {
+        size_t length = buildPayload(seq, payload);
+        logRingAppend(seq, 3, 1, payload, length);
+
+        readRecords(live, 1);
+        if (nextRandom() % 4 == 0) readRecords(batch, nextRandom() % 12);
+
+        // Mirovanje: dohiti pisca (kazalec na glavi, pogosto tik pred obratom),
+        // nato ne bere od nekaj zapisov do nekaj obratov ringa
+        if (seq >= idleUntil) {
+            readRecords(idle, 0xFFFFFFFF);
+            idleUntil = seq + 1 + nextRandom() % (RING_CAPACITY / 8);
+        }
+
+        if (nextRandom() % 64 == 0) {
+            // Seek na naključen zapis v ringu mora vrniti točno ta zapis
+            LogRingStats stats;
+            logRingGetStats(stats);
+            Consumer probe = {"seek", {}, 0, 0, 0};
+            uint32_t target = stats.firstSeq + nextRandom() % (stats.nextSeq - stats.firstSeq);
+            logRingSeek(probe.cursor, target);
+            probe.expectSeq = target;
+            readRecords(probe, 1);
+            if (probe.reads != 1 || probe.expectSeq != target + 1) {
+                if (failures++ < 10) printf("NAPAKA seek na %u\n", target);
+            }
+            seeks++;
+        }
+
+        checkPending(live);
+        checkPending(batch);
+        checkPending(idle);
+    }
+    readRecords(batch, 0xFFFFFFFF);
+    readRecords(idle, 0xFFFFFFFF);
+
+    LogRingStats stats;
+    logRingGetStats(stats);
+    printf("zapisov %u, prepisanih %u (~%u obratov), v ringu %u\n", APPENDS, stats.overwritten,
+           stats.overwritten / (stats.records ? stats.records : 1), stats.records);
+    const Consumer* consumers[] = {&live, &batch, &idle};
+    for (const Consumer* c : consumers) {
+        printf("%-10s prebranih %lu, izpuščenih %u\n", c->name, c->reads, c->cursor.dropped);
+        if (c->expectSeq != APPENDS || c->reads + c->cursor.dropped != APPENDS) {
+            if (failures++ < 10) printf("NAPAKA %s: ni dohitel pisca ali štetje ne ustreza\n", c->name);
+        }
+    }
+    printf("seek preverjanj %lu\n", seeks);
+    printf(failures ? "NEUSPEH: %lu napak\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
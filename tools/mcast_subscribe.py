@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""mcast_subscribe.py - prejemnik multicast objave stanja CEE (src/mcast.h).
+
+Pridruži se skupini, razčleni glavo (VS, verzija, zastavice, seq, čas) in
+MessagePack telo ter izpiše spremenjena polja. Zazna izgubljene datagrame
+(vrzel v seq) in ponovni zagon CEE (seq se vrne na 1).
+
+Uporaba:
+    python tools/mcast_subscribe.py                    # 239.255.53.1:45353
+    python tools/mcast_subscribe.py --iface 192.168.2.50 --all
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+HEADER = struct.Struct("<2sBBII")
+FLAG_HEARTBEAT = 0x01
+
+
+def unpack(data, pos=0):
+    """Minimalni MessagePack dekoder (map, str, int, float, bool, nil, array)."""
+    b = data[pos]
+    pos += 1
+    if b <= 0x7F:
+        return b, pos
+    if 0x80 <= b <= 0x8F or b in (0xDE, 0xDF):
+        if b <= 0x8F:
+            n = b & 0x0F
+        elif b == 0xDE:
+            n = struct.unpack_from(">H", data, pos)[0]
+            pos += 2
+        else:
+            n = struct.unpack_from(">I", data, pos)[0]
+            pos += 4
+        out = {}
+        for _ in range(n):
+            k, pos = unpack(data, pos)
+            v, pos = unpack(data, pos)
+            out[k] = v
+        return out, pos
+    if 0x90 <= b <= 0x9F or b in (0xDC, 0xDD):
+        if b <= 0x9F:
+            n = b & 0x0F
+        elif b == 0xDC:
+            n = struct.unpack_from(">H", data, pos)[0]
+            pos += 2
+        else:
+            n = struct.unpack_from(">I", data, pos)[0]
+            pos += 4
+        out = []
+        for _ in range(n):
+            v, pos = unpack(data, pos)
+            out.append(v)
+        return out, pos
+    if 0xA0 <= b <= 0xBF or b in (0xD9, 0xDA, 0xDB):
+        if b <= 0xBF:
+            n = b & 0x1F
+        else:
+            size = {0xD9: 1, 0xDA: 2, 0xDB: 4}[b]
+            n = int.from_bytes(data[pos:pos + size], "big")
+            pos += size
+        return data[pos:pos + n].decode("utf-8", "replace"), pos + n
+    if b >= 0xE0:
+        return b - 0x100, pos
+    fixed = {
+        0xC0: (None, 0), 0xC2: (False, 0), 0xC3: (True, 0),
+        0xCA: (">f", 4), 0xCB: (">d", 8),
+        0xCC: (">B", 1), 0xCD: (">H", 2), 0xCE: (">I", 4), 0xCF: (">Q", 8),
+        0xD0: (">b", 1), 0xD1: (">h", 2), 0xD2: (">i", 4), 0xD3: (">q", 8),
+    }
+    if b not in fixed:
+        raise ValueError("nepodprt MessagePack tip 0x%02x" % b)
+    fmt, size = fixed[b]
+    if size == 0:
+        return fmt, pos
+    value = struct.unpack_from(fmt, data, pos)[0]
+    if isinstance(value, float):
+        value = round(value, 3)
+    return value, pos + size
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Prejemnik multicast objave stanja CEE")
+    ap.add_argument("--group", default="239.255.53.1")
+    ap.add_argument("--port", type=int, default=45353)
+    ap.add_argument("--iface", default="0.0.0.0", help="IP lokalnega vmesnika za IGMP join")
+    ap.add_argument("--all", action="store_true", help="izpiši vsa polja, ne le spremenjenih")
+    args = ap.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port))
+    mreq = socket.inet_aton(args.group) + socket.inet_aton(args.iface)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    print("Poslušam %s:%d" % (args.group, args.port))
+
+    last_seq = None
+    state = {}
+    received = lost = 0
+    while True:
+        data, addr = sock.recvfrom(2048)
+        if len(data) < HEADER.size:
+            continue
+        magic, version, flags, seq, ts = HEADER.unpack_from(data)
+        if magic != b"VS" or version != 1:
+            print("%s: neznan datagram (%d B)" % (addr[0], len(data)))
+            continue
+        try:
+            fields, _ = unpack(data, HEADER.size)
+        except (ValueError, IndexError, struct.error) as e:
+            print("%s: seq=%d neveljavno telo: %s" % (addr[0], seq, e))
+            continue
+
+        received += 1
+        note = ""
+        if last_seq is not None:
+            if seq == 1 or seq < last_seq:
+                note = " [ponovni zagon CEE]"
+            elif seq != last_seq + 1:
+                lost += seq - last_seq - 1
+                note = " [izgubljenih %d]" % (seq - last_seq - 1)
+        last_seq = seq
+
+        changed = fields if args.all else {k: v for k, v in fields.items() if state.get(k) != v}
+        state.update(fields)
+        kind = "heartbeat" if flags & FLAG_HEARTBEAT else "sprememba"
+        print("%s seq=%d %s %d B ts=%d (prejetih %d, izgubljenih %d)%s"
+              % (time.strftime("%H:%M:%S"), seq, kind, len(data), ts, received, lost, note))
+        if changed:
+            print("    " + " ".join("%s=%s" % (k, v) for k, v in sorted(changed.items())))
+
+
+if __name__ == "__main__":
+    main()
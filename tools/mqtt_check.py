@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""mqtt_check.py - preverjanje MQTT telemetrije CEE (src/mqtt.h) z lokalnim brokerjem.
+
+Minimalni MQTT 3.1.1 odjemalec (samo standardna knjižnica): naroči se na
+<prefix>/#, izpiše retained stanje skupin ob povezavi in nato le spremenjena
+polja ter šteje objave na skupino - ponavljanje nespremenjenega stanja
+pomeni, da zaznava sprememb na CEE ne deluje. Z --cmd pošlje ukaze na
+<prefix>/cmd/<soba> (kot MANUAL_CONTROL).
+
+Uporaba (mosquitto na računalniku, CEE zgrajen z -DMQTT_TELEMETRY in
+MQTT_HOST na IP računalnika):
+    mosquitto -v -p 1883
+    python tools/mqtt_check.py --host 127.0.0.1
+    python tools/mqtt_check.py --cmd kop=drying --cmd wc=manual
+"""
+
+import argparse
+import json
+import socket
+import struct
+import time
+
+CONNECT, CONNACK, PUBLISH, PUBACK, SUBSCRIBE, SUBACK, PINGREQ, PINGRESP = 1, 2, 3, 4, 8, 9, 12, 13
+
+
+def encode_length(n):
+    out = bytearray()
+    while True:
+        byte = n % 128
+        n //= 128
+        out.append(byte | 0x80 if n else byte)
+        if not n:
+            return bytes(out)
+
+
+def mqtt_string(s):
+    data = s.encode("utf-8")
+    return struct.pack(">H", len(data)) + data
+
+
+def packet(kind, flags, body):
+    return bytes([kind << 4 | flags]) + encode_length(len(body)) + body
+
+
+def read_packet(sock):
+    """Vrne (tip, zastavice, telo) ali None ob zaprti povezavi."""
+    head = sock.recv(1)
+    if not head:
+        return None
+    length, shift = 0, 0
+    while True:
+        byte = sock.recv(1)[0]
+        length |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            break
+    body = b""
+    while len(body) < length:
+        chunk = sock.recv(length - len(body))
+        if not chunk:
+            return None
+        body += chunk
+    return head[0] >> 4, head[0] & 0x0F, body
+
+
+def connect(args):
+    sock = socket.create_connection((args.host, args.port), timeout=args.keepalive)
+    body = mqtt_string("MQTT") + bytes([4, 0x02]) + struct.pack(">H", args.keepalive)
+    body += mqtt_string("mqtt_check_%d" % (int(time.time()) % 100000))
+    sock.sendall(packet(CONNECT, 0, body))
+    reply = read_packet(sock)
+    if not reply or reply[0] != CONNACK or reply[2][1] != 0:
+        raise SystemExit("Broker zavrnil povezavo: %r" % (reply,))
+    sock.sendall(packet(SUBSCRIBE, 0x02, struct.pack(">H", 1) + mqtt_string(args.prefix + "/#") + b"\x00"))
+    return sock
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Preverjanje MQTT telemetrije CEE")
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--prefix", default="vent/cee")
+    ap.add_argument("--keepalive", type=int, default=30)
+    ap.add_argument("--cmd", action="append", default=[], metavar="SOBA=AKCIJA",
+                    help="ukaz, npr. kop=drying, ut=toggle, wc=manual")
+    ap.add_argument("--all", action="store_true", help="izpiši vsa polja, ne le spremenjenih")
+    args = ap.parse_args()
+
+    sock = connect(args)
+    print("Naročen na %s/# pri %s:%d" % (args.prefix, args.host, args.port))
+    for cmd in args.cmd:
+        room, _, action = cmd.partition("=")
+        topic = "%s/cmd/%s" % (args.prefix, room)
+        sock.sendall(packet(PUBLISH, 0, mqtt_string(topic) + action.encode()))
+        print("-> %s %s" % (topic, action))
+
+    state, counts = {}, {}
+    last_ping = time.time()
+    sock.settimeout(1.0)
+    while True:
+        if time.time() - last_ping >= args.keepalive / 2:
+            sock.sendall(packet(PINGREQ, 0, b""))
+            last_ping = time.time()
+        try:
+            reply = read_packet(sock)
+        except socket.timeout:
+            continue
+        if reply is None:
+            raise SystemExit("Broker je zaprl povezavo")
+        kind, flags, body = reply
+        if kind != PUBLISH:
+            continue
+
+        n = struct.unpack_from(">H", body)[0]
+        topic = body[2:2 + n].decode("utf-8", "replace")
+        pos = 2 + n
+        qos = (flags >> 1) & 0x03
+        if qos:
+            sock.sendall(packet(PUBACK, 0, body[pos:pos + 2]))
+            pos += 2
+        payload = body[pos:].decode("utf-8", "replace")
+        retained = " [retained]" if flags & 0x01 else ""
+        group = topic[len(args.prefix) + 1:]
+        counts[group] = counts.get(group, 0) + 1
+        stamp = time.strftime("%H:%M:%S")
+
+        try:
+            fields = json.loads(payload)
+        except ValueError:
+            print("%s %s = %s%s" % (stamp, group, payload, retained))
+            continue
+        if not isinstance(fields, dict):
+            print("%s %s = %s%s" % (stamp, group, payload, retained))
+            continue
+        prev = state.get(group, {})
+        changed = fields if args.all else {k: v for k, v in fields.items() if prev.get(k) != v}
+        state[group] = fields
+        note = "" if changed or not prev else "  ** brez spremembe **"
+        print("%s %s #%d%s%s" % (stamp, group, counts[group], retained, note))
+        if changed:
+            print("    " + " ".join("%s=%s" % (k, v) for k, v in sorted(changed.items())))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,252 @@
+// msgpack_bench.cpp - JSON proti MessagePack za sporočila med enotami (host)
+//
+// Zgradi tipične STATUS_UPDATE, DEW_UPDATE, multicast objavo in SENSOR_DATA
+// ter izmeri velikost in čas kodiranja/dekodiranja v fiksne bufferje (kot
+// src/wire.cpp). Sporočila CEE gradijo iste funkcije kot firmware
+// (src/statemsg.cpp) iz tipičnega currentData; SENSOR_DATA, ki ga CEE samo
+// prejema, zgradi buildSensorData spodaj. Velikosti (MSG_BODY_MAX,
+// MSG_DOC_ARENA ...) so iz include/config.h.
+//
+// Nato preveri, da kodiranje ne naredi nobene alokacije na heapu: malloc/new
+// se štejeta (glibc) med STATUS_UPDATE (encodeStatusMessage s potrditvijo),
+// delta STATUS_UPDATE (z osnovo iz potrjenih posnetkov in keyframi), DEW_UPDATE
+// (JSON in MessagePack), multicast objavo in dekodiranjem SENSOR_DATA. Izhodna
+// koda je 1, če se je kaj alociralo, arena ni zadostovala ali delta ni nastala.
+// ArduinoJson je samo glave.
+//
+// Prevod (iz korena repozitorija, po prvem `pio run`, ki prenese knjižnice):
+//     g++ -O2 -std=c++11 -Wall -Itools/host -Iinclude -Isrc -I.pio/libdeps/esp32-s3-eth/ArduinoJson/src tools/msgpack_bench.cpp src/statemsg.cpp src/wire.cpp -o msgpack_bench && ./msgpack_bench
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include "config.h"
+#include "globals.h"
+#include "logging.h"
+#include "message_fields.h"
+#include "statemsg.h"
+#include "wirearena.h"
+
+#define ITERATIONS 20000
+
+// Globalne spremenljivke, ki jih statemsg.cpp pričakuje od firmwara
+CurrentData currentData = {};
+ExternalData externalData = {};
+bool externalDataValid = false;
+bool timeSynced = true;
+Timezone myTZ;
+String currentWeatherIcon = "04d";
+int currentSeasonCode = 2;
+uint8_t logTagLevels[LOG_TAG_COUNT] = {};
+
+void logEventDeferred(LogLevel, uint8_t, const char*, const char*, ...) {}
+void logEventTagged(LogLevel, uint8_t, const char*, const char*, ...) {}
+
+// Štetje alokacij (glibc): samo med allocCounting
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+static volatile bool allocCounting = false;
+static volatile unsigned long allocCount = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (allocCounting) allocCount++;
+    return __libc_malloc(size);
+}
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (allocCounting) allocCount++;
+    return __libc_realloc(ptr, size);
+}
+extern "C" void* calloc(size_t n, size_t size) {
+    if (allocCounting) allocCount++;
+    return __libc_calloc(n, size);
+}
+void* operator new(size_t size) {
+    if (allocCounting) allocCount++;
+    void* p = __libc_malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* ptr) noexcept { free(ptr); }
+
+// Tipično stanje: UT suši (cikel 2), KOP vklopljen, dnevna soba na stopnji 2
+static void setupState() {
+    currentData.utilityDryingMode = true;
+    currentData.utilityCycleMode = 2;
+    currentData.bathroomFan = true;
+    currentData.livingExhaustLevel = 2;
+    currentData.bathroomLight1 = true;
+    currentData.wcLight = true;
+    currentData.windowSensor2 = true;
+    currentData.utilityExpectedEndTime = 1767225600u;
+    currentData.offTimes[0] = 1767226200u;
+    currentData.supplySagCount = 3;
+    currentData.bathroomTemp = 23.47f;
+    currentData.bathroomHumidity = 61.82f;
+    currentData.bathroomPressure = 1012.63f;
+    currentData.utilityTemp = 21.09f;
+    currentData.utilityHumidity = 55.4f;
+    currentData.currentPower = 14.2f;
+    currentData.energyConsumption = 1834.7f;
+    currentData.livingRoomDutyCycle = 35;
+}
+
+static void buildStatusUpdate(JsonDocument& doc) {
+    fillStatusFields(doc, computeFanStates());
+}
+
+static void buildSensorData(JsonDocument& doc) {
+    doc[FIELD_EXT_TEMP] = 7.83f;
+    doc[FIELD_EXT_HUM] = 88.1f;
+    doc[FIELD_EXT_PRESS] = 1013.2f;
+    doc[FIELD_DS_TEMP] = 22.61f;
+    doc[FIELD_DS_HUM] = 47.3f;
+    doc[FIELD_DS_CO2] = 812;
+    doc[FIELD_WEATHER_ICON] = "04d";
+    doc[FIELD_SEASON_CODE] = 2;
+    doc[FIELD_TIMESTAMP] = 1767225600u;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double microsPerOp(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / ITERATIONS;
+}
+
+static void bench(const char* name, void (*build)(JsonDocument&)) {
+    JsonDocument doc;
+    build(doc);
+    static uint8_t buf[MSG_BODY_MAX];
+    size_t jsonLen = 0, packLen = 0;
+    volatile size_t sink = 0;
+
+    Clock::time_point t = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) jsonLen = serializeJson(doc, (char*)buf, sizeof(buf));
+    double jsonEnc = microsPerOp(t);
+
+    static char json[MSG_BODY_MAX];
+    memcpy(json, buf, jsonLen);
+    JsonDocument in;
+    t = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        deserializeJson(in, (const char*)json, jsonLen);
+        sink += in.size();
+    }
+    double jsonDec = microsPerOp(t);
+
+    t = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) packLen = serializeMsgPack(doc, buf, sizeof(buf));
+    double packEnc = microsPerOp(t);
+
+    t = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        deserializeMsgPack(in, buf, packLen);
+        sink += in.size();
+    }
+    double packDec = microsPerOp(t);
+
+    printf("%-14s %5zu B %7.2f us %7.2f us | %5zu B %7.2f us %7.2f us | %3.0f %%\n",
+           name, jsonLen, jsonEnc, jsonDec, packLen, packEnc, packDec, 100.0 * packLen / jsonLen);
+    (void)sink;
+}
+
+// Koraki preverjanja alokacij - kot http.cpp: statičen dokument stanja, clear()
+// pred vsakim sporočilom, kodiranje v fiksen buffer. Vrnejo dolžino (0 = napaka).
+static WireDocument<MSG_DOC_ARENA> decoded;
+
+static size_t stepStatus(JsonDocument& doc, uint8_t* buf, size_t size) {
+    fillStatusFields(doc, computeFanStates());
+    uint32_t seq;
+    size_t length = encodeStatusMessage(doc, WIRE_JSON, seq, buf, size);
+    ackStatusMessage(seq, false, false);
+    return length;
+}
+
+// Vsako sporočilo spremeni vlago in moč; potrditev posnetka postane osnova
+// naslednje delte, vsako STATUS_KEYFRAME_EVERY-to je keyframe
+static size_t stepDelta(JsonDocument& doc, uint8_t* buf, size_t size) {
+    static uint32_t step = 0;
+    step++;
+    currentData.bathroomHumidity = 60.0f + step % 7;
+    currentData.currentPower = 10.0f + step % 3;
+    fillStatusFields(doc, computeFanStates());
+    uint32_t seq;
+    size_t length = encodeStatusMessage(doc, WIRE_MSGPACK, seq, buf, size);
+    ackStatusMessage(seq, true, false);
+    return length;
+}
+
+static size_t stepDew(JsonDocument& doc, uint8_t* buf, size_t size) {
+    fillDewFields(doc);
+    if (encodeStateDoc(doc, WIRE_JSON, buf, size) == 0) return 0;
+    return encodeStateDoc(doc, WIRE_MSGPACK, buf, size);
+}
+
+static size_t stepPublish(JsonDocument& doc, uint8_t* buf, size_t size) {
+    fillPublishFields(doc);
+    return encodeStateDoc(doc, WIRE_MSGPACK, buf, size);
+}
+
+static size_t stepSensorData(JsonDocument& doc, uint8_t* buf, size_t size) {
+    buildSensorData(doc);
+    size_t length = encodeStateDoc(doc, WIRE_MSGPACK, buf, size);
+    if (length == 0 || deserializeMsgPack(decoded, buf, length) || decoded.overflowed()) return 0;
+    return length;
+}
+
+static bool checkAllocations(const char* name, size_t (*step)(JsonDocument&, uint8_t*, size_t)) {
+    static WireDocument<MSG_DOC_ARENA> doc;
+    static uint8_t buf[MSG_BODY_MAX];
+    bool overflow = false;
+    size_t maxLength = 0;
+
+    allocCount = 0;
+    allocCounting = true;
+    for (int i = 0; i < 1000; i++) {
+        doc.clear();
+        size_t length = step(doc, buf, sizeof(buf));
+        if (length == 0 || doc.overflowed()) overflow = true;
+        if (length > maxLength) maxLength = length;
+    }
+    allocCounting = false;
+
+    bool ok = allocCount == 0 && !overflow;
+    printf("%-14s alokacije: %lu, arena %zu/%d B, sporočilo do %zu/%d B%s\n", name, allocCount,
+           doc.arena().highWater(), MSG_DOC_ARENA, maxLength, MSG_BODY_MAX,
+           ok ? "" : (overflow ? "  PRELIV" : "  NAPAKA"));
+    return ok;
+}
+
+int main() {
+    setupState();
+    printf("%-14s %-29s | %-29s | velikost\n", "", "JSON (B, kodiranje, dekod.)", "MessagePack");
+    bench("STATUS_UPDATE", buildStatusUpdate);
+    bench("DEW_UPDATE", fillDewFields);
+    bench("MCAST", fillPublishFields);
+    bench("SENSOR_DATA", buildSensorData);
+
+    printf("\n");
+    bool ok = checkAllocations("STATUS_UPDATE", stepStatus);
+
+    StatusDeltaStats before;
+    getStatusDeltaStats(before);
+    ok = checkAllocations("STATUS delta", stepDelta) && ok;
+    StatusDeltaStats after;
+    getStatusDeltaStats(after);
+    uint32_t deltas = after.deltas - before.deltas;
+    uint32_t keyframes = after.keyframes - before.keyframes;
+    printf("%-14s delt %u, keyframov %u, poslano %u/%u B\n", "", deltas, keyframes,
+           after.bytesSent - before.bytesSent, after.bytesFull - before.bytesFull);
+    if (!after.enabled || deltas == 0 || keyframes == 0) {
+        printf("%-14s delta ni nastala  NAPAKA\n", "STATUS delta");
+        ok = false;
+    }
+
+    ok = checkAllocations("DEW_UPDATE", stepDew) && ok;
+    ok = checkAllocations("MCAST", stepPublish) && ok;
+    ok = checkAllocations("SENSOR_DATA", stepSensorData) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""rew_log_sink.py - nadomestek REW /api/logs za testiranje na računalniku.
+
+Sprejme POST /api/logs s chunked transfer encoding in Content-Encoding: gzip
+(kot ga pošilja src/logship.cpp), razpakira {"logs":"..."} in vrstice doda v
+datoteko. Zapise, ki jih je že prejel (po X-Log-First-Seq/X-Log-Last-Seq),
+preskoči in v odgovoru vrne X-Log-Ack z zadnjim shranjenim seq. Zadnji seq
+hrani ločeno za vsak X-Log-Boot (seq se ob ponovnem zagonu CEE začne pri 0).
+Izpiše tudi X-Log-Dropped (zapisi, prepisani na CEE pred pošiljanjem).
+
+Uporaba:
+    python tools/rew_log_sink.py --port 80 --out cee_logs.txt
+    python tools/rew_log_sink.py --fail-every 3     # simulira izpade
+    python tools/rew_log_sink.py --no-gzip          # gzip zavrne s 415 (preklop CEE)
+
+Za test CEE začasno nastavi IP_REW v include/config.h na IP računalnika.
+"""
+
+import argparse
+import gzip
+import json
+import threading
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+state = {"last_seq": {}, "requests": 0, "lock": threading.Lock()}   # last_seq: boot -> seq
+
+
+def read_chunked(rfile):
+    body = bytearray()
+    while True:
+        size_line = rfile.readline().strip()
+        size = int(size_line.split(b";")[0], 16)
+        if size == 0:
+            while rfile.readline().strip():   # trailerji
+                pass
+            return bytes(body)
+        body += rfile.read(size)
+        rfile.readline()
+
+
+class LogSinkHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def do_POST(self):
+        if self.path != "/api/logs":
+            self.send_error(404)
+            return
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            raw = read_chunked(self.rfile)
+        else:
+            raw = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        wire_bytes = len(raw)
+
+        with state["lock"]:
+            state["requests"] += 1
+            if self.server.fail_every and state["requests"] % self.server.fail_every == 0:
+                self.reply(503, {"status": "ERROR", "message": "simuliran izpad"})
+                return
+
+        if self.server.no_gzip and self.headers.get("Content-Encoding", "").lower() == "gzip":
+            self.reply(415, {"status": "ERROR", "message": "gzip ni podprt"})
+            print("POST /api/logs: gzip zavrnjen (415)")
+            return
+
+        try:
+            if self.headers.get("Content-Encoding", "").lower() == "gzip":
+                raw = gzip.decompress(raw)
+            elif self.headers.get("Content-Encoding", "").lower() == "deflate":
+                raw = zlib.decompress(raw)
+            logs = json.loads(raw)["logs"]
+        except (OSError, zlib.error, ValueError, KeyError) as e:
+            self.reply(400, {"status": "ERROR", "message": str(e)})
+            return
+
+        lines = [l for l in logs.split("\n") if l]
+        first = self.headers.get("X-Log-First-Seq")
+        boot = self.headers.get("X-Log-Boot")
+        with state["lock"]:
+            last_seq = state["last_seq"].get(boot)
+            if first is not None:
+                first = int(first)
+                # Preskoči že shranjene zapise (ponovno pošiljanje po prekinitvi)
+                if last_seq is not None and first <= last_seq:
+                    lines = lines[last_seq + 1 - first:]
+                    first = last_seq + 1
+                if lines:
+                    last_seq = first + len(lines) - 1
+                    state["last_seq"][boot] = last_seq
+            with open(self.server.out, "a", encoding="utf-8") as f:
+                for line in lines:
+                    f.write(line + "\n")
+            ack = last_seq
+
+        print("POST /api/logs: zagon %s, %d B na žici (%s), %d B JSON, %d novih vrstic, ack=%s, prepisanih=%s"
+              % (boot or "?", wire_bytes, self.headers.get("Content-Encoding", "identity"), len(logs), len(lines),
+                 ack, self.headers.get("X-Log-Dropped", "?")))
+        self.reply(200, {"status": "OK", "lines": len(lines)}, ack)
+
+    def reply(self, code, payload, ack=None):
+        body = json.dumps(payload).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if ack is not None:
+            self.send_header("X-Log-Ack", str(ack))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def main():
+    ap = argparse.ArgumentParser(description="REW /api/logs nadomestek")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--out", default="cee_logs.txt")
+    ap.add_argument("--fail-every", type=int, default=0, help="vsak N-ti zahtevek vrne 503")
+    ap.add_argument("--no-gzip", action="store_true", help="Content-Encoding: gzip zavrne s 415")
+    args = ap.parse_args()
+
+    server = ThreadingHTTPServer((args.host, args.port), LogSinkHandler)
+    server.out = args.out
+    server.fail_every = args.fail_every
+    server.no_gzip = args.no_gzip
+    print("Poslušam na %s:%d, zapisujem v %s" % (args.host, args.port, args.out))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
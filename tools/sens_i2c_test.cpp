@@ -0,0 +1,220 @@
+// sens_i2c_test.cpp - obnovitvene poti I2C iz src/sens.cpp na hostu
+//
+// sens.cpp se prevede nespremenjen proti nadomestkom v tools/host: Wire.h
+// (simulirano vodilo z urnikom napak), Arduino.h (simulirana ura in GPIO z
+// zataknjenim SDA) ter Adafruit_SHT4x.h/Adafruit_BME280.h. Vsak scenarij
+// nastavi urnik, izvede en readSensors() (UT + KOP) in preveri število in
+// trajanje obnovitev vodila, izgubljene krmilne cikle (CONTROL_TICK_MS) ter
+// napake senzorjev. Zadnji scenarij primerja vbrizgano napako iz firmwara
+// (scheduleI2CFault) z enako napako na vodilu. Izhodna koda je 1 ob napaki,
+// -v izpiše log.
+//
+// Prevod (iz korena repozitorija), priporočeno z ASan:
+//     g++ -std=c++11 -g -Wall -fsanitize=address,undefined -DI2C_FAULT_INJECTION -Itools/host -Iinclude -Isrc tools/sens_i2c_test.cpp src/sens.cpp -o sens_i2c_test && ./sens_i2c_test
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include "sens.h"
+
+// Globalne spremenljivke in odvisnosti, ki jih sens.cpp pričakuje od firmwara
+Settings settings = {};
+CurrentData currentData = {};
+Adafruit_BME280* bme280 = nullptr;
+Adafruit_SHT4x* sht41 = nullptr;
+bool bmePresent = false;
+bool sht41Present = false;
+Timezone myTZ;
+bool timeSynced = false;
+bool externalDataValid = false;
+DeviceStatus utDewStatus = {true};
+DeviceStatus kopDewStatus = {true};
+SemaphoreHandle_t i2cMutex = NULL;
+uint8_t logTagLevels[LOG_TAG_COUNT] = {};
+
+static bool verbose = false;
+
+void logEventDeferred(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...) {
+    (void)level;
+    (void)tagId;
+    if (!verbose) return;
+    va_list args;
+    va_start(args, format);
+    printf("  %8lu ms [%s] ", millis(), tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+void logEventTagged(LogLevel level, uint8_t tagId, const char* tag, const char* format, ...) {
+    (void)level;
+    (void)tagId;
+    if (!verbose) return;
+    va_list args;
+    va_start(args, format);
+    printf("  %8lu ms [%s] ", millis(), tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+void initSupplyMonitor() {}
+bool takeSupplyWindow(SupplyWindow& out) {
+    out = {4.9f, 5.0f, 5.1f, 3.2f, 3.3f, 3.4f, 1};
+    return true;
+}
+uint32_t getSupplySagCount() { return 0; }
+uint8_t getSupplySagEvents(SupplySagEvent*, uint8_t) { return 0; }
+
+struct Scenario {
+    const char* name;
+    void (*setup)();
+    uint32_t recoveries;         // klici resetI2CBus()
+    uint32_t recoveryFailures;
+    uint32_t sdaStuck;
+    uint32_t maxRecoveryMs;      // zgornja meja trajanja zadnje obnovitve
+    uint32_t lostTicks;          // izgubljeni krmilni cikli (UT + KOP)
+    bool utError;
+    bool kopError;
+};
+
+// Ena sonda pri 10 kHz traja ~1,1 ms; obnovitev (bus clear, STOP, Wire.end/begin
+// z delay(10) in sondi obeh senzorjev) ~12 ms, če SDA ni zataknjen.
+static const Scenario scenarios[] = {
+    {"clean", [] {},
+        0, 0, 0, 0, 0, false, false},
+    {"nack-transient", [] { Wire.schedule(HOST_I2C_NACK, SHT41_ADDRESS, 1, 1); },
+        1, 0, 0, 15, 0, false, false},
+    {"timeout-transient", [] { Wire.schedule(HOST_I2C_TIMEOUT, SHT41_ADDRESS, 1, 1); },
+        1, 0, 0, 15, 0, false, false},
+    // Sonda, sonda ob obnovitvi in ponovna sonda po 100 ms: branje UT preseže en cikel
+    {"timeout-persistent", [] { Wire.schedule(HOST_I2C_TIMEOUT, SHT41_ADDRESS, 1, 3); },
+        1, 0, 0, 115, 1, true, false},
+    {"nack-kop", [] { Wire.schedule(HOST_I2C_NACK, BME280_ADDRESS, 1, 1); },
+        1, 0, 0, 15, 0, false, false},
+    {"sda-stuck-released", [] {
+            Wire.stuckReleaseClocks = 3;
+            Wire.schedule(HOST_I2C_SDA_STUCK, SHT41_ADDRESS, 1, 1);
+        },
+        1, 0, 0, 15, 0, false, false},
+    // 9 impulzov ne sprosti SDA: obnovitev odneha takoj, ponovna sonda UT in
+    // sonda KOP čakata timeout, KOP je označen kot nedosegljiv
+    {"sda-stuck-hard", [] {
+            Wire.stuckReleaseClocks = 0;
+            Wire.schedule(HOST_I2C_SDA_STUCK, SHT41_ADDRESS, 1, 1);
+        },
+        1, 1, 1, 1, 1, true, true},
+    {"garbage", [] { sht41->relativeHumidity = 255.0f; },
+        0, 0, 0, 0, 0, true, false},
+};
+
+static unsigned long failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what, unsigned long got, unsigned long want) {
+    if (ok) return;
+    printf("FAIL %s: %s = %lu (pričakovano %lu)\n", scenario, what, got, want);
+    failures++;
+}
+
+// Stanje pred scenarijem: vodilo brez napak, oba senzorja prisotna in berljiva
+static void resetBus() {
+    Wire.schedule(HOST_I2C_OK, 0, 0, 0);
+    Wire.stuckReleaseClocks = 0;
+    memset(hostGpio().heldLow, 0, sizeof(hostGpio().heldLow));
+    sht41->relativeHumidity = 55.0f;
+    sht41Present = true;
+    bmePresent = true;
+    currentData.errorFlags = 0;
+    delay(60000);
+}
+
+static void runScenario(const Scenario& s) {
+    resetBus();
+    if (verbose) printf("%s\n", s.name);
+    s.setup();
+
+    I2CStats before = i2cStats;
+    unsigned long start = millis();
+    readSensors();
+    unsigned long elapsed = millis() - start;
+
+    uint32_t recoveries = i2cStats.busRecoveries - before.busRecoveries;
+    uint32_t failed = i2cStats.busRecoveryFailures - before.busRecoveryFailures;
+    uint32_t stuck = i2cStats.sdaStuck - before.sdaStuck;
+    uint32_t lost = i2cStats.lostControlTicks - before.lostControlTicks;
+    uint32_t lostNone = i2cStats.lostControlTicksByFault[I2C_FAULT_NONE] -
+                        before.lostControlTicksByFault[I2C_FAULT_NONE];
+    bool utError = (currentData.errorFlags & ERR_SHT41) != 0;
+    bool kopError = (currentData.errorFlags & ERR_BME280) != 0;
+
+    printf("%-20s %4lu ms, obnovitve %u (neuspešne %u, zadnja %u ms), izgubljeni cikli %u\n",
+           s.name, elapsed, recoveries, failed, recoveries ? i2cStats.lastRecoveryMs : 0, lost);
+
+    expect(recoveries == s.recoveries, s.name, "busRecoveries", recoveries, s.recoveries);
+    expect(failed == s.recoveryFailures, s.name, "busRecoveryFailures", failed, s.recoveryFailures);
+    expect(stuck == s.sdaStuck, s.name, "sdaStuck", stuck, s.sdaStuck);
+    if (recoveries > 0) {
+        expect(i2cStats.lastRecoveryMs <= s.maxRecoveryMs, s.name, "lastRecoveryMs",
+               i2cStats.lastRecoveryMs, s.maxRecoveryMs);
+    }
+    expect(lost == s.lostTicks, s.name, "lostControlTicks", lost, s.lostTicks);
+    // Brez vbrizgane napake se vsi izgubljeni cikli pripišejo [I2C_FAULT_NONE]
+    expect(lostNone == lost, s.name, "lostControlTicksByFault[NONE]", lostNone, lost);
+    expect(utError == s.utError, s.name, "ERR_SHT41", utError, s.utError);
+    expect(kopError == s.kopError, s.name, "ERR_BME280", kopError, s.kopError);
+}
+
+// Vbrizgan timeout (scheduleI2CFault) mora trajati in šteti enako kot timeout
+// na vodilu; zadene prvo sondo, zato je UT nato označen kot nedosegljiv
+static void runInjectionScenario() {
+    const char* name = "inject-vs-bus";
+
+    resetBus();
+    Wire.schedule(HOST_I2C_TIMEOUT, SHT41_ADDRESS, 0, 1);
+    I2CStats busBefore = i2cStats;
+    unsigned long start = millis();
+    readSensors();
+    unsigned long busElapsed = millis() - start;
+    uint32_t busTimeouts = i2cStats.sht41.timeouts - busBefore.sht41.timeouts;
+
+    resetBus();
+    scheduleI2CFault(I2C_FAULT_TIMEOUT, SHT41_ADDRESS, 1);
+    I2CStats before = i2cStats;
+    start = millis();
+    readSensors();
+    unsigned long elapsed = millis() - start;
+    uint32_t timeouts = i2cStats.sht41.timeouts - before.sht41.timeouts;
+    uint32_t lost = i2cStats.lostControlTicks - before.lostControlTicks;
+    bool utError = (currentData.errorFlags & ERR_SHT41) != 0;
+
+    printf("%-20s %4lu ms (vodilo %lu ms), izgubljeni cikli %u\n", name, elapsed, busElapsed, lost);
+
+    // Razlika samo zaradi zaokroževanja na ms
+    unsigned long diff = elapsed > busElapsed ? elapsed - busElapsed : busElapsed - elapsed;
+    expect(diff <= 2, name, "trajanje", elapsed, busElapsed);
+    expect(timeouts == busTimeouts, name, "sht41.timeouts", timeouts, busTimeouts);
+    expect(lost == 0, name, "lostControlTicks", lost, 0);
+    expect(utError && !sht41Present, name, "ERR_SHT41", utError, 1);
+}
+
+int main(int argc, char** argv) {
+    verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+    delay(1000);
+    initSensors();
+    if (!sht41Present || !bmePresent) {
+        printf("FAIL initSensors: senzorja nista prisotna\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        runScenario(scenarios[i]);
+    }
+    runInjectionScenario();
+
+    if (failures) {
+        printf("%lu napak\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}